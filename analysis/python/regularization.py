@@ -14,7 +14,7 @@ from matplotlib import pyplot as plt
 import ROOT
 
 from triggerbins import TriggerBins
-from utils import Hist1D, mpl_style
+from utils import Hist1D, build_trigger_chain, mpl_style
 
 
 class SimHistBuilder:
@@ -25,19 +25,32 @@ class SimHistBuilder:
     are filled.
     """
 
-    def __init__(self, trigger_bins, max_pt=math.inf):
+    # Names of profiles filled by plugin SimBalanceHists for variables
+    # stored in the trees
+    stored_profile_names = {
+        'PtJ1': 'PtLeadProfile', 'PtBal': 'PtBalProfile', 'MPF': 'MPFProfile'
+    }
+
+    def __init__(
+        self, trigger_bins, max_pt=math.inf, use_stored_profiles=False
+    ):
         """Initialize from a TriggerBins object.
 
         Arguments:
             trigger_bins:  TriggerBins object.
             max_pt:  Trigger bins whose pt range (without the margin)
                 lies fully above this value, are skipped.
+            use_stored_profiles:  Whether profiles filled by plugin
+                SimBalanceHists should be used instead of the trees
+                when this gives exactly the same result.  See method
+                fill.
         """
 
         self.trigger_bins = TriggerBins.from_bins(
             filter(lambda b: b.pt_range[0] < max_pt, trigger_bins.bins)
         )
         self.pt_binning = None
+        self.use_stored_profiles = use_stored_profiles
 
 
     def construct_binning(self, max_pt, num_bins):
@@ -62,7 +75,12 @@ class SimHistBuilder:
         """Fill profiles from files with simulation.
 
         Construct profiles of given variables versus pt of the leading
-        jet.  Use binning defined in self.pt_binning.
+        jet.  Use binning defined in self.pt_binning.  If requested at
+        initialization and the input files contain profiles filled by
+        plugin SimBalanceHists for all requested variables and the given
+        weights, with a binning that allows to merge them exactly, they
+        are merged instead of reading the trees.  Otherwise the trees
+        are read.  See _find_stored_profiles and _merge_stored_profiles.
 
         Arguments:
             sim_paths:   Paths to ROOT files with balance observables for
@@ -82,21 +100,28 @@ class SimHistBuilder:
         if self.pt_binning is None:
             raise RuntimeError('Binning is not defined.')
 
-        # All trigger bins will be processed together.  Find pt ranges
-        # for each bin that eliminate the overlap.  This means including
-        # the margin only for the first and the last bins.
-        trigger_pt_ranges = {}
-        
-        b = self.trigger_bins[0]
-        trigger_pt_ranges[b.name] = (b.pt_range_margined[0], b.pt_range[1])
-        
-        b = self.trigger_bins[-1]
-        trigger_pt_ranges[b.name] = (b.pt_range[0], b.pt_range_margined[1])
-        
-        for b in self.trigger_bins[1:-1]:
-            trigger_pt_ranges[b.name] = b.pt_range
-        
-        
+        trigger_pt_ranges = self._trigger_pt_ranges()
+
+        # If multijet has filled the profiles already, use them instead
+        # of reading the trees
+        if self.use_stored_profiles:
+            suffix = self._find_stored_profiles(
+                sim_paths, era, variables, add_weight, trigger_pt_ranges
+            )
+
+            if suffix is not None:
+                return self._merge_stored_profiles(
+                    sim_paths, variables, suffix, trigger_pt_ranges
+                )
+
+            print(
+                'Stored profiles cannot be used for variables {} with '
+                'additional weight "{}".  Reading trees instead.'.format(
+                    ', '.join(variables), add_weight
+                )
+            )
+
+
         # Construct and fill profiles for all requested variables
         profiles = {
             variable: ROOT.TProfile(
@@ -114,18 +139,9 @@ class SimHistBuilder:
         
 
         for trigger_name in trigger_pt_ranges:
-            chain = ROOT.TChain(trigger_name + '/BalanceVars')
-            friend_chains = [
-                ROOT.TChain('{}/{}'.format(trigger_name, tree_name))
-                for tree_name in ['GenWeights', 'PeriodWeights']
-            ]
-
-            for path in sim_paths:
-                for c in [chain] + friend_chains:
-                    c.AddFile(path)
-
-            for friend in friend_chains:
-                chain.AddFriend(friend)
+            chain, friend_chains = build_trigger_chain(
+                sim_paths, trigger_name, ['GenWeights', 'PeriodWeights']
+            )
 
             
             pt_selection = 'PtJ1 > {} && PtJ1 < {}'.format(
@@ -159,6 +175,231 @@ class SimHistBuilder:
         return profiles
 
 
+    def _find_stored_profiles(
+        self, sim_paths, era, variables, add_weight, trigger_pt_ranges
+    ):
+        """Check if profiles stored in input files can be used.
+
+        The stored profiles must exist for all requested variables and
+        trigger bins in all input files.  Their binning must be
+        compatible with self.pt_binning and the pt ranges of the trigger
+        bins, as checked with method _is_stored_binning_aligned.
+
+        Arguments:
+            sim_paths, era, variables, add_weight:  Same as in method
+                fill.
+            trigger_pt_ranges:  Dictionary with pt ranges for each
+                trigger bin, as returned by method _trigger_pt_ranges.
+
+        Return value:
+            Suffix of names of stored profiles that correspond to the
+            given weights or None if the stored profiles cannot be used.
+        """
+
+        if any(v not in self.stored_profile_names for v in variables):
+            return None
+
+        # Additional weights that correspond to stored variations
+        weight_suffixes = {
+            '': '',
+            'WeightMERenorm[0]': '_MERenormUp',
+            'WeightMERenorm[1]': '_MERenormDown',
+            'WeightMEFact[0]': '_MEFactUp',
+            'WeightMEFact[1]': '_MEFactDown',
+            'Weight_{}_L1TPrefiring[0]'.format(era): '_L1TPrefiringUp',
+            'Weight_{}_L1TPrefiring[1]'.format(era): '_L1TPrefiringDown'
+        }
+        add_weight = add_weight.replace(' ', '') if add_weight else ''
+
+        if add_weight not in weight_suffixes:
+            return None
+
+        suffix = '_' + era + weight_suffixes[add_weight]
+
+        for path in sim_paths:
+            input_file = ROOT.TFile(path)
+            usable = True
+
+            for trigger_name, pt_range in trigger_pt_ranges.items():
+                for variable in variables:
+                    profile = input_file.Get('{}/{}{}'.format(
+                        trigger_name, self.stored_profile_names[variable],
+                        suffix
+                    ))
+
+                    if not profile or not self._is_stored_binning_aligned(
+                        profile, pt_range
+                    ):
+                        usable = False
+                        break
+
+                if not usable:
+                    break
+
+            input_file.Close()
+
+            if not usable:
+                return None
+
+        return suffix
+
+
+    def _is_stored_binning_aligned(self, profile, pt_range):
+        """Check if a stored profile can be merged exactly.
+
+        Consider the intersection of the pt range of the trigger bin
+        with the range of self.pt_binning.  Its boundaries and all edges
+        of self.pt_binning inside it must coincide with edges of the
+        profile, up to rounding errors.  This also implies that the
+        intersection is covered fully by regular bins of the profile.
+        Then every bin of the profile within it is contained in a single
+        bin of self.pt_binning.  Under- and overflow bins of the result
+        are not reproduced exactly, but they are not used in the fits.
+
+        Arguments:
+            profile:  Stored profile.
+            pt_range:  Range in pt of the leading jet of the trigger
+                bin to which the profile corresponds.
+
+        Return value:
+            True if the binning of the profile is aligned, False
+            otherwise.
+        """
+
+        axis = profile.GetXaxis()
+        stored_edges = np.array([
+            axis.GetBinLowEdge(bin) for bin in range(1, axis.GetNbins() + 2)
+        ])
+        min_pt = max(pt_range[0], self.pt_binning[0])
+        max_pt = min(pt_range[1], self.pt_binning[-1])
+
+        if min_pt >= max_pt:
+            return True
+
+        required_edges = [min_pt, max_pt] + [
+            edge for edge in self.pt_binning if min_pt < edge < max_pt
+        ]
+
+        return all(
+            np.any(np.isclose(stored_edges, edge, rtol=1e-9, atol=0.))
+            for edge in required_edges
+        )
+
+
+    def _merge_stored_profiles(
+        self, sim_paths, variables, suffix, trigger_pt_ranges
+    ):
+        """Merge profiles stored in input files.
+
+        Sum the profiles over the input files and over the trigger bins,
+        using for each trigger bin only the bins of the stored profiles
+        whose centres lie within the given pt range.  Each of these bins
+        is added to the bin of self.pt_binning that contains its centre.
+        Since the alignment of the binnings has been checked in method
+        _find_stored_profiles, the result is the same as when the trees
+        are read.
+
+        Arguments:
+            sim_paths:  Paths to ROOT files with simulation.
+            variables:  Variables to be read.
+            suffix:  Suffix of names of stored profiles, as returned by
+                method _find_stored_profiles.
+            trigger_pt_ranges:  Dictionary with pt ranges for each
+                trigger bin, as returned by method _trigger_pt_ranges.
+
+        Return value:
+            Same as in method fill.
+        """
+
+        # Sums of w, w * x, w * x^2, and w^2 in each target bin,
+        # including under- and overflows
+        num_target_bins = len(self.pt_binning) + 1
+        sums = {
+            variable: np.zeros((4, num_target_bins))
+            for variable in variables
+        }
+
+        for path in sim_paths:
+            input_file = ROOT.TFile(path)
+
+            for trigger_name, pt_range in trigger_pt_ranges.items():
+                for variable in variables:
+                    profile = input_file.Get('{}/{}{}'.format(
+                        trigger_name, self.stored_profile_names[variable],
+                        suffix
+                    ))
+                    sum_wx2 = profile.GetSumw2()
+                    sum_w2 = profile.GetBinSumw2()
+                    cur_sums = sums[variable]
+
+                    for bin in range(1, profile.GetNbinsX() + 1):
+                        centre = profile.GetBinCenter(bin)
+
+                        if not pt_range[0] < centre < pt_range[1]:
+                            continue
+
+                        sum_w = profile.GetBinEntries(bin)
+                        target_bin = np.searchsorted(
+                            self.pt_binning, centre, side='right'
+                        )
+                        cur_sums[:, target_bin] += [
+                            sum_w, profile.GetBinContent(bin) * sum_w,
+                            sum_wx2.At(bin), sum_w2.At(bin)
+                        ]
+
+            input_file.Close()
+
+
+        # Compute means and their uncertainties in the same way as
+        # done by ROOT.TProfile
+        profiles = {}
+
+        for variable in variables:
+            sum_w, sum_wx, sum_wx2, sum_w2 = sums[variable]
+            filled = sum_w > 0.
+            means = np.zeros(num_target_bins)
+            errors = np.zeros(num_target_bins)
+
+            means[filled] = sum_wx[filled] / sum_w[filled]
+            variances = np.maximum(
+                sum_wx2[filled] / sum_w[filled] - means[filled] ** 2, 0.
+            )
+            errors[filled] = np.sqrt(
+                variances * sum_w2[filled] / sum_w[filled] ** 2
+            )
+
+            profiles[variable] = Hist1D(
+                binning=self.pt_binning, contents=means, errors=errors
+            )
+
+        return profiles
+
+
+    def _trigger_pt_ranges(self):
+        """Find pt ranges of trigger bins that eliminate the overlap.
+
+        This means including the margin only for the first and the last
+        bins.
+
+        Return value:
+            Dictionary that maps names of trigger bins into their pt
+            ranges.
+        """
+
+        trigger_pt_ranges = {}
+        
+        b = self.trigger_bins[0]
+        trigger_pt_ranges[b.name] = (b.pt_range_margined[0], b.pt_range[1])
+        
+        b = self.trigger_bins[-1]
+        trigger_pt_ranges[b.name] = (b.pt_range[0], b.pt_range_margined[1])
+        
+        for b in self.trigger_bins[1:-1]:
+            trigger_pt_ranges[b.name] = b.pt_range
+
+        return trigger_pt_ranges
+
+
 class SplineSimFitter:
     """Class to construct continuous <B>(log(tau1)) in simulation.
     
@@ -175,7 +416,7 @@ class SplineSimFitter:
     
     def __init__(
         self, sim_paths, era, trigger_bins,
-        diagnostic_plots_dir=None
+        diagnostic_plots_dir=None, use_stored_profiles=False
     ):
         """Initialize from paths to input files and trigger bins.
         
@@ -187,11 +428,14 @@ class SplineSimFitter:
             diagnostic_plots_dir:  Directory in which figures with
                 diagnostic plots are to be stored.  If None, the plots
                 will not be produced.
+            use_stored_profiles:  Whether profiles filled during the
+                event loop can be used.  See SimHistBuilder.
         """
         
         self.sim_paths = sim_paths
         self.era_label = era
         self.trigger_bins = trigger_bins
+        self.use_stored_profiles = use_stored_profiles
         
         self.diagnostic_plots_dir = diagnostic_plots_dir
         
@@ -222,7 +466,9 @@ class SplineSimFitter:
         
         # The fit will be done for all trigger bins simultaneously.
         # Construct required profiles.
-        hist_builder = SimHistBuilder(self.trigger_bins)
+        hist_builder = SimHistBuilder(
+            self.trigger_bins, use_stored_profiles=self.use_stored_profiles
+        )
         hist_builder.construct_binning(max_pt, num_bins)
         profiles = hist_builder.fill(
             self.sim_paths, self.era_label, ['PtJ1'] + variables
@@ -592,7 +838,7 @@ class SimVariationFitter(VariationFitter):
 
     def __init__(
         self, syst_config, trigger_bins, variables,
-        max_pt=1700., num_bins=50, **kwargs
+        max_pt=1700., num_bins=50, use_stored_profiles=False, **kwargs
     ):
         """Initialize from a configuration object.
         
@@ -606,6 +852,8 @@ class SimVariationFitter(VariationFitter):
                 larger pt will not be used in the fit.
             num_bins:  Number of bins in pt of the leading jet to be
                 used in internal histograms for the fit.
+            use_stored_profiles:  Whether profiles filled during the
+                event loop can be used.  See SimHistBuilder.
 
         All additional keyword arguments are forwarded to the base
         class.
@@ -620,7 +868,10 @@ class SimVariationFitter(VariationFitter):
 
 
         # Fill nominal profiles, for all trigger bins simultaneously
-        self.hist_builder = SimHistBuilder(trigger_bins, max_pt=max_pt)
+        self.hist_builder = SimHistBuilder(
+            trigger_bins, max_pt=max_pt,
+            use_stored_profiles=use_stored_profiles
+        )
         self.hist_builder.construct_binning(self.max_pt, self.num_bins)
         profiles = self.hist_builder.fill(
             self.syst_config.nominal.sim_paths, self.syst_config.period_weight,
@@ -234,6 +234,50 @@ class RDFHists:
         return tuple(model)
 
 
+def build_trigger_chain(paths, trigger, friend_trees=()):
+    """Construct a chain with variables for a trigger bin.
+
+    Support both layouts of outputs of program multijet: a separate
+    tree per producer in the directory of the trigger bin, which are
+    combined as friends of tree "BalanceVars", and a single tree "Vars"
+    written with option --merged-trees.  The layout is determined from
+    the first file.
+
+    Arguments:
+        paths:  Paths to ROOT files produced by multijet.
+        trigger:  Name of the trigger bin.
+        friend_trees:  Names of trees, in addition to "BalanceVars",
+            whose variables are needed.  Ignored for the merged layout.
+
+    Return value:
+        Tuple with the chain and the list of its friends.  The friends
+        must be kept alive as long as the chain is used.
+    """
+
+    input_file = ROOT.TFile(paths[0])
+    merged = bool(input_file.Get(trigger + '/Vars'))
+    input_file.Close()
+
+    if merged:
+        chain = ROOT.TChain(trigger + '/Vars')
+        friends = []
+    else:
+        chain = ROOT.TChain(trigger + '/BalanceVars')
+        friends = [
+            ROOT.TChain('{}/{}'.format(trigger, tree_name))
+            for tree_name in friend_trees
+        ]
+
+    for path in paths:
+        for c in [chain] + friends:
+            c.AddFile(path)
+
+    for friend in friends:
+        chain.AddFriend(friend)
+
+    return chain, friends
+
+
 def spline_to_root(spline):
     """Convert a SciPy spline into ROOT.TSpline3.
     
@@ -66,6 +66,10 @@ if __name__ == '__main__':
     arg_parser.add_argument(
         '--plots', default='fig', help='Directory for diagnostic plots.'
     )
+    arg_parser.add_argument(
+        '--stored-profiles', action='store_true',
+        help='Use profiles for simulation filled in multijet if possible.'
+    )
     args = arg_parser.parse_args()
     
     
@@ -152,7 +156,8 @@ if __name__ == '__main__':
     # simulation
     sim_fitter = SplineSimFitter(
         args.sim, args.era, trigger_bins,
-        diagnostic_plots_dir=args.plots + '/sim_fit'
+        diagnostic_plots_dir=args.plots + '/sim_fit',
+        use_stored_profiles=args.stored_profiles
     )
     sim_fitter.fit(['PtBal', 'MPF'])
     
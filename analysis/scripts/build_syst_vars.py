@@ -43,6 +43,10 @@ if __name__ == '__main__':
     arg_parser.add_argument(
         '--plots', default='fig', help='Base directory for diagnostic plots.'
     )
+    arg_parser.add_argument(
+        '--stored-profiles', action='store_true',
+        help='Use profiles for simulation filled in multijet if possible.'
+    )
     args = arg_parser.parse_args()
     
     
@@ -113,7 +117,8 @@ if __name__ == '__main__':
     # Construct smoothed relative variations in simulation
     sim_fitter = SimVariationFitter(
         syst_config, trigger_bins, variables,
-        diagnostic_plots_dir=args.plots + '/sim_syst'
+        diagnostic_plots_dir=args.plots + '/sim_syst',
+        use_stored_profiles=args.stored_profiles
     )
 
     for syst_label in syst_config.iter_group('sim'):
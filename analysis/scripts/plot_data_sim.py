@@ -23,7 +23,7 @@ import ROOT
 ROOT.PyConfig.IgnoreCommandLineOptions = True
 
 from plotting import plot_distribution, plot_balance
-from utils import RDFHists, mpl_style
+from utils import RDFHists, build_trigger_chain, mpl_style
 
 
 if __name__ == '__main__':
@@ -126,23 +126,10 @@ if __name__ == '__main__':
     
     # Fill the histograms
     for trigger, pt_range in config['triggers'].items():
-        chain_data = ROOT.TChain(trigger + '/BalanceVars')
-
-        for f in args.data:
-            chain_data.AddFile(f)
-
-        chain_sim = ROOT.TChain(trigger + '/BalanceVars')
-        chain_sim_friends = [
-            ROOT.TChain('{}/{}'.format(trigger, name))
-            for name in ['GenWeights', 'PeriodWeights']
-        ]
-
-        for f in args.sim:
-            for chain in [chain_sim] + chain_sim_friends:
-                chain.AddFile(f)
-
-        for friend in chain_sim_friends:
-            chain_sim.AddFriend(friend)
+        chain_data, _ = build_trigger_chain(args.data, trigger)
+        chain_sim, chain_sim_friends = build_trigger_chain(
+            args.sim, trigger, ['GenWeights', 'PeriodWeights']
+        )
         
         
         pt_selection = 'PtJ1 > {}'.format(pt_range[0])
@@ -5,7 +5,7 @@
 #include <string>
 
 
-class JetMETReader;
+class JetKinematics;
 
 
 /**
@@ -18,7 +18,7 @@ class JetMETReader;
  * are considered, without any pt threshold. If an event does not contain jets needed to compute an
  * angle and a non-trivial selection for that angle has been specified, the event is rejected.
  * 
- * This plugin relies on the presence of a JetMETReader with a default name "JetMET".
+ * Angles are taken from a JetKinematics plugin with a default name "JetKinematics".
  */
 class AngularFilter: public AnalysisPlugin
 {
@@ -27,7 +27,7 @@ public:
     
 public:
     /**
-     * \brief Saves pointer to the jet reader
+     * \brief Saves pointer to the plugin that computes kinematic quantities of jets
      * 
      * Reimplemented from Plugin.
      */
@@ -40,6 +40,9 @@ public:
      */
     virtual AngularFilter *Clone() const override;
     
+    /// Changes name of the plugin that computes kinematic quantities of jets
+    void SetJetKinematicsName(std::string const &name);
+    
     /**
      * \brief Sets selection on Delta(phi) between two leading jets
      * 
@@ -63,11 +66,11 @@ private:
     virtual bool ProcessEvent() override;
     
 private:
-    /// Name of the plugin that produces jets
-    std::string jetmetPluginName;
+    /// Name of the plugin that computes kinematic quantities of jets
+    std::string jetKinematicsName;
     
-    /// Non-owning pointer to the plugin that produces jets
-    JetMETReader const *jetmetPlugin;
+    /// Non-owning pointer to the plugin that computes kinematic quantities of jets
+    JetKinematics const *jetKinematics;
     
     /// Selection on Delta(phi) between the two leading jets
     double minDPhi12, maxDPhi12;
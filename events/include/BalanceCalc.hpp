@@ -5,6 +5,8 @@
 #include <string>
 
 
+class JetBlock;
+class JetKinematics;
 class JetMETReader;
 
 
@@ -19,7 +21,8 @@ class JetMETReader;
  * weight changes in a smooth manner. This is done in order to make the pt balance in a given event
  * a continuous function of parameters of the L3Res correction.
  * 
- * An event is rejected if it contains no jets.
+ * Projections of momenta onto the direction of the leading jet are taken from a JetKinematics
+ * plugin with a default name "JetKinematics". An event is rejected if it contains no jets.
  */
 class BalanceCalc: public AnalysisPlugin
 {
@@ -53,6 +56,12 @@ public:
      */
     virtual BalanceCalc *Clone() const override;
     
+    /// Changes name of the plugin that computes kinematic quantities of jets
+    void SetJetKinematicsName(std::string const &name);
+    
+    /// Changes name of the plugin that provides jets and MET
+    void SetJetMETPluginName(std::string const &name);
+    
     /// Returns value of MPF observable in current event
     double GetMPF() const;
     
@@ -90,6 +99,15 @@ private:
     /// Non-owning pointer to the plugin that produces jets
     JetMETReader const *jetmetPlugin;
     
+    /// Non-owning pointer to jets from the above plugin in the columnar layout
+    JetBlock const *jetBlock;
+    
+    /// Name of the plugin that computes kinematic quantities of jets
+    std::string jetKinematicsName;
+    
+    /// Non-owning pointer to the plugin that computes kinematic quantities of jets
+    JetKinematics const *jetKinematics;
+    
     /// Values of balance observables in the current event
     double ptBal, mpf;
 };
@@ -6,6 +6,7 @@
 
 
 class BalanceCalc;
+class JetBlock;
 class JetMETReader;
 
 
@@ -42,6 +43,12 @@ public:
      */
     virtual Plugin *Clone() const override;
     
+    /// Changes name of the plugin that computes balance observables
+    void SetBalanceCalcName(std::string const &name);
+    
+    /// Changes name of the plugin that provides jets and MET
+    void SetJetMETPluginName(std::string const &name);
+    
     /**
      * \brief Sets minimal pt of the leading jet for the filtering to be applied
      * 
@@ -71,6 +78,9 @@ private:
     /// Non-owning pointer to a plugin that produces jets and MET
     JetMETReader const *jetmetPlugin;
     
+    /// Non-owning pointer to jets from the above plugin in the columnar layout
+    JetBlock const *jetBlock;
+    
     /// Name of a plugin that computes balance observables
     std::string balanceCalcName;
     
@@ -12,6 +12,8 @@
 
 
 class BalanceCalc;
+class JetBlock;
+class JetKinematics;
 class JetMETReader;
 class TFileService;
 
@@ -20,8 +22,8 @@ class TFileService;
  * \class BalanceHists
  * \brief Produces histograms needed to recompute balancing in multijet events
  * 
- * Intended to be used with data only. Depends on the presence of a jet reader and a plugin to
- * compute balance observables.
+ * Intended to be used with data only. Depends on the presence of a jet reader, a plugin to
+ * compute balance observables, and a JetKinematics plugin.
  */
 class BalanceHists: public AnalysisPlugin
 {
@@ -52,6 +54,18 @@ public:
      */
     virtual Plugin *Clone() const override;
     
+    /// Changes name of the plugin that computes balance observables
+    void SetBalanceCalcName(std::string const &name);
+    
+    /// Changes name of TFileService
+    void SetFileServiceName(std::string const &name);
+    
+    /// Changes name of the plugin that computes kinematic quantities of jets
+    void SetJetKinematicsName(std::string const &name);
+    
+    /// Changes name of the plugin that provides jets and MET
+    void SetJetMETPluginName(std::string const &name);
+    
     /// Sets binning in ptlead
     void SetBinningPtLead(std::vector<double> const &binning);
     
@@ -86,6 +100,15 @@ private:
     /// Non-owning pointer to a plugin that produces jets and MET
     JetMETReader const *jetmetPlugin;
     
+    /// Non-owning pointer to jets from the above plugin in the columnar layout
+    JetBlock const *jetBlock;
+    
+    /// Name of a plugin that computes kinematic quantities of jets
+    std::string jetKinematicsName;
+    
+    /// Non-owning pointer to a plugin that computes kinematic quantities of jets
+    JetKinematics const *jetKinematics;
+    
     /// Name of a plugin that computes balance observables
     std::string balanceCalcName;
     
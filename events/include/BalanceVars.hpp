@@ -2,11 +2,12 @@
 
 #include <mensura/AnalysisPlugin.hpp>
 
-#include <TLorentzVector.h>
 #include <TTree.h>
 
 
 class BalanceCalc;
+class JetBlock;
+class JetKinematics;
 class JetMETReader;
 class TFileService;
 
@@ -15,7 +16,8 @@ class TFileService;
  * \class BalanceVars
  * \brief Produces tuples with variables that describe multijet balancing
  * 
- * Depends on the presence of a jet reader and a plugin to compute balance observables.
+ * Depends on the presence of a jet reader, a plugin to compute balance observables, and a
+ * JetKinematics plugin.
  */
 class BalanceVars: public AnalysisPlugin
 {
@@ -41,6 +43,26 @@ public:
      */
     virtual Plugin *Clone() const override;
     
+    /// Changes name of the plugin that computes balance observables
+    void SetBalanceCalcName(std::string const &name);
+    
+    /// Changes name of TFileService
+    void SetFileServiceName(std::string const &name);
+    
+    /// Changes name of the plugin that computes kinematic quantities of jets
+    void SetJetKinematicsName(std::string const &name);
+    
+    /// Changes name of the plugin that provides jets and MET
+    void SetJetMETPluginName(std::string const &name);
+    
+    /**
+     * \brief Requests that variables are written into the tree of the given SharedTree plugin
+     * 
+     * Then the tree name set with SetTreeName is ignored, and the shared tree is filled by a
+     * SharedTreeFiller rather than by this plugin.
+     */
+    void SetSharedTreeName(std::string const &name);
+    
     /**
      * \brief Specifies name for the output tree
      * 
@@ -72,6 +94,15 @@ private:
     /// Non-owning pointer to a plugin that produces jets and MET
     JetMETReader const *jetmetPlugin;
     
+    /// Non-owning pointer to jets from the above plugin in the columnar layout
+    JetBlock const *jetBlock;
+    
+    /// Name of a plugin that computes kinematic quantities of jets
+    std::string jetKinematicsName;
+    
+    /// Non-owning pointer to a plugin that computes kinematic quantities of jets
+    JetKinematics const *jetKinematics;
+    
     /// Name of a plugin that computes balance observables
     std::string balanceCalcName;
     
@@ -81,6 +112,9 @@ private:
     /// Name of the output tree and in-file directory
     std::string treeName, directoryName;
     
+    /// Name of a SharedTree plugin whose tree is used, or an empty string for a dedicated tree
+    std::string sharedTreeName;
+    
     /// Non-owning pointer to output tree
     TTree *tree;
     
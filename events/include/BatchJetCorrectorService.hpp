@@ -0,0 +1,183 @@
+#pragma once
+
+#include <JetCorrectionLevel.hpp>
+#include <RunIntervalIndex.hpp>
+
+#include <mensura/Service.hpp>
+
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/**
+ * \class BatchJetCorrectorService
+ * \brief Evaluates jet corrections for all jets in an event at once
+ *
+ * This service provides two chains of jet corrections, the full one and the one used in the
+ * type 1 correction to missing pt (normally, L1 only). Both are evaluated for a batch of jets with
+ * a single call to method Eval. The corrections are read from text files in the standard JERC
+ * format with the help of JetCorrectionLevel, and the formulas are evaluated for all jets in the
+ * batch simultaneously. Levels in each chain are applied sequentially, so that pt used to evaluate
+ * a given level includes corrections from all previous ones.
+ *
+ * Uncertainties and JER smearing are not supported. Use JetCorrectorService when they are needed.
+ *
+ * Different corrections can be specified for different intervals of validity (IOV), in the same
+ * way as in JetCorrectorService. Parsed corrections are shared among clones of the service.
+ * Optionally, they can be read in the background, see SetDeferredLoading.
+ */
+class BatchJetCorrectorService: public Service
+{
+private:
+    /// Corrections for a single IOV
+    struct IOV
+    {
+        /// Label of the IOV
+        std::string label;
+
+        /// Chains of corrections
+        std::vector<std::shared_ptr<JetCorrectionLevel const>> fullLevels, l1Levels;
+
+        /**
+         * \brief Full and L1 chains of corrections that are being read in the background
+         *
+         * Only valid between a call to SetJEC with the deferred loading and FinishLoading.
+         */
+        std::shared_future<std::pair<std::vector<std::shared_ptr<JetCorrectionLevel const>>,
+          std::vector<std::shared_ptr<JetCorrectionLevel const>>>> pendingLevels;
+    };
+
+public:
+    /// Creates a service with the given name
+    BatchJetCorrectorService(std::string const &name = "BatchJetCorrector");
+
+public:
+    /**
+     * \brief Makes sure all corrections have been read
+     *
+     * Reimplemented from Service.
+     */
+    virtual void BeginRun(Dataset const &) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Service.
+     */
+    virtual BatchJetCorrectorService *Clone() const override;
+
+    /**
+     * \brief Evaluates full and L1 corrections for the given batch of jets
+     *
+     * Correction factors are written into the provided arrays, which must contain at least
+     * input.size elements. If no L1 corrections have been specified, the corresponding factors
+     * are set to 1.
+     */
+    void Eval(JetCorrectionInput const &input, double *fullFactors, double *l1Factors) const;
+
+    /**
+     * \brief Waits until corrections read in the background are available
+     *
+     * Exceptions thrown while reading the corrections are rethrown here. This method is called
+     * automatically from BeginRun.
+     */
+    void FinishLoading();
+
+    /**
+     * \brief Returns an upper bound on the full correction factor in the selected IOV
+     *
+     * Computed as the product of bounds for individual levels, see
+     * JetCorrectionLevel::GetMaxFactor.
+     */
+    double GetMaxFullFactor() const;
+
+    /**
+     * \brief Registers a new IOV
+     *
+     * The range of runs is inclusive. If IOVs are registered, a suitable IOV must be selected
+     * for each event with method SelectIOV.
+     */
+    void RegisterIOV(std::string const &label, unsigned long minRun, unsigned long maxRun);
+
+    /**
+     * \brief Selects the IOV that includes the given run
+     *
+     * Throws an exception if no such IOV has been registered. Does nothing if no IOVs have been
+     * registered.
+     */
+    void SelectIOV(unsigned long run) const;
+
+    /**
+     * \brief Requests that corrections are read in the background
+     *
+     * When enabled, each call to SetJEC starts an asynchronous task that reads the given files,
+     * and corrections for different IOVs are read in parallel. This allows to overlap the reading
+     * with other initialization. Only affects subsequent calls to SetJEC.
+     */
+    void SetDeferredLoading(bool enable = true);
+
+    /**
+     * \brief Specifies corrections for the given IOV
+     *
+     * The IOV must have been registered beforehand. Each vector contains names of files with
+     * individual levels of corrections, in the order in which they should be applied. The paths
+     * are resolved with the FileInPath service under a subdirectory "JERC".
+     */
+    void SetJEC(std::string const &iovLabel, std::vector<std::string> const &fullLevels,
+      std::vector<std::string> const &l1Levels);
+
+    /**
+     * \brief Specifies corrections to be used for all runs
+     *
+     * Can only be used when no IOVs are registered.
+     */
+    void SetJEC(std::vector<std::string> const &fullLevels,
+      std::vector<std::string> const &l1Levels);
+
+private:
+    /// Reads corrections for the given IOV, either immediately or in the background
+    void LoadLevels(IOV &iov, std::vector<std::string> const &fullLevels,
+      std::vector<std::string> const &l1Levels) const;
+
+    /**
+     * \brief Applies the given chain of corrections to a batch of jets
+     *
+     * Combined correction factors are written into the given array.
+     */
+    void EvalChain(std::vector<std::shared_ptr<JetCorrectionLevel const>> const &levels,
+      JetCorrectionInput const &input, double *factors) const;
+
+    /**
+     * \brief Returns the IOV to be used for the current event
+     *
+     * Throws an exception if IOVs have been registered but none has been selected. The argument
+     * is the name of the calling method, to be included in the error message.
+     */
+    IOV const &GetCurrentIOV(char const *caller) const;
+
+    /// Reads corrections from the given files
+    static std::vector<std::shared_ptr<JetCorrectionLevel const>> ReadLevels(
+      std::vector<std::string> const &fileNames);
+
+private:
+    /// Registered IOVs indexed by the ranges of runs they cover
+    RunIntervalIndex<IOV> iovs;
+
+    /// IOV used when no IOVs have been registered
+    IOV defaultIOV;
+
+    /// Currently selected IOV
+    mutable IOV const *currentIOV;
+
+    /// Indicates whether corrections are read in the background
+    bool deferredLoading;
+
+    /// Buffers used in the evaluation
+    mutable JetCorrectionLevel::Buffers buffers;
+
+    /// Corrected pt and correction factors for individual levels
+    mutable std::vector<double> curPt, levelFactors;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+
+class TAxis;
+
+
+/**
+ * \class BinnedAxis
+ * \brief Light-weight copy of a ROOT histogram axis for fast lookups
+ *
+ * Bins are numbered in the same way as in TAxis: regular bins have indices from 1 to GetNumBins(),
+ * while the underflow and overflow bins have indices 0 and GetNumBins() + 1. For an axis with
+ * equal bins, the index is computed with the same arithmetic as in TAxis::FindFixBin. Otherwise a
+ * binary search in bin edges is performed.
+ */
+class BinnedAxis
+{
+public:
+    /// Copies binning from the given ROOT axis
+    BinnedAxis(TAxis const &axis);
+
+    /**
+     * \brief Constructs an axis from the given bin edges
+     *
+     * The edges must be sorted. The bins are treated as non-uniform.
+     */
+    BinnedAxis(std::vector<double> const &edges);
+
+public:
+    /// Checks if the two axes have the same binning
+    bool operator==(BinnedAxis const &other) const
+    {
+        return numBins == other.numBins and minEdge == other.minEdge and
+          maxEdge == other.maxEdge and uniform == other.uniform and edges == other.edges;
+    }
+
+    /// Returns index of the bin that contains the given value
+    unsigned FindBin(double x) const
+    {
+        if (x < minEdge)
+            return 0;
+
+        if (x >= maxEdge)
+            return numBins + 1;
+
+        if (uniform)
+            return 1 + unsigned(numBins * (x - minEdge) / (maxEdge - minEdge));
+        else
+            return std::upper_bound(edges.begin(), edges.end(), x) - edges.begin();
+    }
+
+    /// Returns the number of regular bins
+    unsigned GetNumBins() const
+    {
+        return numBins;
+    }
+
+private:
+    /// Number of regular bins
+    unsigned numBins;
+
+    /// Lower edge of the first bin and upper edge of the last bin
+    double minEdge, maxEdge;
+
+    /// Indicates whether all bins have the same width
+    bool uniform;
+
+    /// Edges of all bins; only filled if bins are not uniform
+    std::vector<double> edges;
+};
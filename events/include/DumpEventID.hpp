@@ -40,6 +40,17 @@ public:
      */
     virtual Plugin *Clone() const override;
     
+    /// Changes name of TFileService
+    void SetFileServiceName(std::string const &name);
+    
+    /**
+     * \brief Requests that variables are written into the tree of the given SharedTree plugin
+     * 
+     * Then the tree name set with SetTreeName is ignored, and the shared tree is filled by a
+     * SharedTreeFiller rather than by this plugin.
+     */
+    void SetSharedTreeName(std::string const &name);
+    
     /**
      * \brief Specifies name for the output tree
      * 
@@ -71,6 +82,9 @@ private:
     /// Name of the output tree and in-file directory
     std::string treeName, directoryName;
     
+    /// Name of a SharedTree plugin whose tree is used, or an empty string for a dedicated tree
+    std::string sharedTreeName;
+    
     /// Non-owning pointer to the output tree
     TTree *tree;
     
@@ -1,15 +1,19 @@
 #pragma once
 
+#include <RunIntervalIndex.hpp>
+
 #include <mensura/AnalysisPlugin.hpp>
 
 #include <TH2Poly.h>
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 
 class EventIDReader;
+class JetBlock;
 class JetMETReader;
 
 
@@ -21,6 +25,11 @@ class JetMETReader;
  * excluded region in the (eta, phi) plane, for the given run range. This plugin relies on the
  * presence of a EventIDReader with a default name "InputData" and a JetMETReader with a default
  * name "JetMET".
+ * 
+ * Run ranges of all regions split runs into intervals within which the same regions apply. In
+ * BeginRun, regions for each interval are compiled into a Raster, which is shared among all
+ * plugins with identical regions, including clones. Rasters are looked up with a RunIntervalIndex,
+ * which only performs a search when the run leaves the interval of the previous event.
  */
 class EtaPhiFilter: public AnalysisPlugin
 {
@@ -74,6 +83,81 @@ private:
         
         /// 2D map in (eta, phi)
         std::shared_ptr<TH2Poly> map;
+        
+        /// Text representation of the definition, used to identify shared rasters
+        std::string key;
+    };
+    
+    /**
+     * \class Raster
+     * \brief Regions for a run interval, compiled into a fine bitmap in (eta, phi)
+     * 
+     * Each cell of the bitmap is either fully outside of all regions, fully inside one of them,
+     * or on a border. Only for points in border cells regions are checked exactly. A cell is
+     * classified as inside or outside only when this holds with a small safety margin. Therefore
+     * results are identical to checking all regions directly.
+     * 
+     * A cell of a TH2Poly map can only be inside if it is covered by a single rectangular bin,
+     * which is the case for standard cleaning maps. Maps with non-zero content outside of their
+     * bins are not rasterized and are always checked exactly.
+     */
+    class Raster
+    {
+    private:
+        /// Classification of a cell
+        enum class CellState: std::uint8_t
+        {
+            Outside = 0,
+            Border = 1,
+            Inside = 2
+        };
+        
+    public:
+        /// Compiles given regions
+        Raster(std::vector<Region> const &regions);
+        
+    public:
+        /**
+         * \brief Checks if given point (eta, phi) is included in at least one of the regions
+         * 
+         * The phi coordinate must be in the range [-pi, pi].
+         */
+        bool Contains(double eta, double phi) const;
+        
+    private:
+        /// Marks cells overlapping with a rectangular region
+        void AddRectangle(Region const &region);
+        
+        /// Marks cells overlapping with bins of a TH2Poly map
+        void AddMap(TH2Poly &map);
+        
+        /// Updates state of a cell unless it already has a higher one
+        void Mark(unsigned iEta, unsigned iPhi, CellState state);
+        
+        /// Checks if the given TH2Poly map can be rasterized
+        static bool IsRasterizable(TH2Poly const &map);
+        
+    private:
+        /// Size of cells in eta
+        static constexpr double cellSize = 0.01;
+        
+        /// Safety margin for the classification of cells
+        static constexpr double margin = 1e-6;
+        
+        /// Regions that are rasterized and regions that are always checked exactly
+        std::vector<Region> rasterRegions, exactRegions;
+        
+        /// Lower boundary of the bitmap in eta
+        double minEta;
+        
+        /// Number of cells in eta and phi
+        unsigned numEtaCells, numPhiCells;
+        
+        /// Size of cells in phi, which is close to cellSize
+        double phiCellSize;
+        
+        /// States of cells, with index iEta * numPhiCells + iPhi
+        std::vector<CellState> cells;
     };
     
 public:
@@ -117,7 +201,7 @@ public:
       std::string const histName = "");
     
     /**
-     * \brief Saves pointer to the jet reader
+     * \brief Saves pointer to the jet reader and compiles regions for all run intervals
      * 
      * Reimplemented from Plugin.
      */
@@ -130,7 +214,13 @@ public:
      */
     virtual Plugin *Clone() const override;
     
+    /// Changes name of the plugin that provides jets and MET
+    void SetJetMETPluginName(std::string const &name);
+    
 private:
+    /// Splits runs into intervals and builds rasters for them
+    void BuildRasters();
+    
     /**
      * \brief Performs selection on the leading jet
      * 
@@ -151,6 +241,9 @@ private:
     /// Non-owning pointer to the plugin that produces jets
     JetMETReader const *jetmetPlugin;
     
+    /// Non-owning pointer to jets from the above plugin in the columnar layout
+    JetBlock const *jetBlock;
+    
     /// Minimal jet pt
     double minPt;
     
@@ -158,9 +251,9 @@ private:
     std::vector<Region> regions;
     
     /**
-     * \brief Pointers to regions selected for the current event
+     * \brief Compiled regions for run intervals
      * 
-     * Placed in the class definition in order to avoid memory allocation for each event.
+     * Only intervals to which at least one region applies are included.
      */
-    mutable std::vector<Region const *> selectedRegions;
+    RunIntervalIndex<std::shared_ptr<Raster const>> rasters;
 };
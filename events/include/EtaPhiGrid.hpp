@@ -0,0 +1,146 @@
+#pragma once
+
+#include <TVector2.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+/**
+ * \class EtaPhiGrid
+ * \brief Spatial index of objects in the (eta, phi) plane
+ *
+ * Objects are assigned to rectangular cells whose sizes in eta and phi are not smaller than the
+ * search radius given at construction. Then all objects within this radius from a given point are
+ * contained in the cell of the point and its eight neighbours. In phi, the cells wrap around.
+ * This reduces the matching between two collections from a comparison of all pairs to a
+ * comparison with a few nearby objects.
+ *
+ * The index is meant to be rebuilt in each event with method Build, which reuses allocated
+ * memory. Pseudorapidities and azimuthal angles of indexed objects are cached.
+ */
+class EtaPhiGrid
+{
+public:
+    /// Constructs a grid for the given search radius
+    EtaPhiGrid(double radius);
+
+public:
+    /**
+     * \brief Indexes the given collection of objects
+     *
+     * The objects must provide methods Eta and Phi. In method ForEachNeighbour they are identified
+     * by their positions in the collection.
+     */
+    template<typename Collection>
+    void Build(Collection const &objects);
+
+    /**
+     * \brief Calls the given function for all indexed objects close to the given point
+     *
+     * The function is called as f(index, dR2), where index is the position of the object in the
+     * collection given to Build and dR2 is its squared angular distance from the point. It is
+     * called for all objects with dR2 < radius^2 and some objects further away, but never more
+     * than once for the same object. The order of the calls is not specified.
+     */
+    template<typename F>
+    void ForEachNeighbour(double eta, double phi, F &&f) const;
+
+private:
+    /// Sorts indexed objects in cells
+    void BuildCells();
+
+    /// Returns index of the phi cell that contains the given angle
+    int FindPhiCell(double phi) const;
+
+private:
+    /// Minimal size of cells in eta and phi, which is equal to the search radius
+    double cellSize;
+
+    /// Number of cells in phi and their size
+    int numPhiCells;
+    double phiCellSize;
+
+    /// Number of cells in eta and the lower boundary of the first one
+    int numEtaCells;
+    double minEta;
+
+    /// Pseudorapidities and azimuthal angles of indexed objects
+    std::vector<double> etas, phis;
+
+    /**
+     * \brief Positions in \ref sortedIndices of the first object in each cell
+     *
+     * Cells are numbered as iEta * numPhiCells + iPhi. The last element is the total number of
+     * objects.
+     */
+    std::vector<unsigned> cellStarts;
+
+    /// Indices of objects sorted in cells
+    std::vector<unsigned> sortedIndices;
+
+    /// Buffer with indices of cells of all objects, used in BuildCells
+    std::vector<unsigned> objectCells;
+};
+
+
+template<typename Collection>
+void EtaPhiGrid::Build(Collection const &objects)
+{
+    etas.clear();
+    phis.clear();
+
+    for (auto const &object: objects)
+    {
+        etas.emplace_back(object.Eta());
+        phis.emplace_back(object.Phi());
+    }
+
+    BuildCells();
+}
+
+
+template<typename F>
+void EtaPhiGrid::ForEachNeighbour(double eta, double phi, F &&f) const
+{
+    if (etas.empty())
+        return;
+
+    double const etaPos = std::floor((eta - minEta) / cellSize);
+
+    if (not (etaPos >= -1. and etaPos <= numEtaCells))
+        return;
+
+    int const etaCell = int(etaPos);
+    int const firstEtaCell = std::max(etaCell - 1, 0);
+    int const lastEtaCell = std::min(etaCell + 1, numEtaCells - 1);
+
+
+    // When there are fewer than three cells in phi, check all of them to avoid visiting the same
+    //cell twice
+    int firstPhiCell = 0, numVisitedPhiCells = numPhiCells;
+
+    if (numPhiCells >= 3)
+    {
+        firstPhiCell = FindPhiCell(phi) - 1 + numPhiCells;
+        numVisitedPhiCells = 3;
+    }
+
+
+    for (int iEta = firstEtaCell; iEta <= lastEtaCell; ++iEta)
+    {
+        for (int k = 0; k < numVisitedPhiCells; ++k)
+        {
+            unsigned const cell = iEta * numPhiCells + (firstPhiCell + k) % numPhiCells;
+
+            for (unsigned i = cellStarts[cell]; i < cellStarts[cell + 1]; ++i)
+            {
+                unsigned const index = sortedIndices[i];
+                double const dR2 = std::pow(eta - etas[index], 2) +
+                  std::pow(TVector2::Phi_mpi_pi(phi - phis[index]), 2);
+                f(index, dR2);
+            }
+        }
+    }
+}
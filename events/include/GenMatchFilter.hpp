@@ -8,6 +8,7 @@
 
 
 class GenJetMETReader;
+class JetBlock;
 class JetMETReader;
 
 
@@ -47,6 +48,9 @@ public:
      */
     virtual Plugin *Clone() const override;
     
+    /// Changes name of the plugin that provides jets and MET
+    void SetJetMETPluginName(std::string const &name);
+    
 private:
     /**
      * \brief Performs selection based on matching for the leading jet
@@ -62,6 +66,9 @@ private:
     /// Non-owning pointer to the plugin that produces jets
     JetMETReader const *jetmetPlugin;
     
+    /// Non-owning pointer to jets from the above plugin in the columnar layout
+    JetBlock const *jetBlock;
+    
     /// Name of a plugin that produces generator-level jets
     std::string genJetPluginName;
     
@@ -47,12 +47,59 @@ public:
      */
     virtual GenWeights *Clone() const override;
 
+    /**
+     * \brief Returns relative up and down variations in the factorization scale in ME
+     *
+     * The pointed-to values are updated in each event. Only available if a generator reader has
+     * been specified.
+     */
+    Float_t const *GetMEFactWeights() const
+    {
+        return bfWeightMEFact;
+    }
+
+    /**
+     * \brief Returns relative up and down variations in the renormalization scale in ME
+     *
+     * Same comments as for GetMEFactWeights apply.
+     */
+    Float_t const *GetMERenormWeights() const
+    {
+        return bfWeightMERenorm;
+    }
+
+    /// Returns the full nominal generator-level weight for the current event
+    double GetWeight() const
+    {
+        return bfWeightGen;
+    }
+
+    /// Checks if variations in ME scales are evaluated
+    bool HasMEWeights() const
+    {
+        return not generatorPluginName.empty();
+    }
+
+    /// Changes name of TFileService
+    void SetFileServiceName(std::string const &name)
+    {
+        fileServiceName = name;
+    }
+
     /// Specifies the name of a PECGeneratorReader plugin
     void SetGeneratorReader(std::string const &name)
     {
         generatorPluginName = name;
     }
     
+    /**
+     * \brief Requests that variables are written into the tree of the given SharedTree plugin
+     * 
+     * Then the tree name set with SetTreeName is ignored, and the shared tree is filled by a
+     * SharedTreeFiller rather than by this plugin.
+     */
+    void SetSharedTreeName(std::string const &name);
+    
     /**
      * \brief Specifies the name for the output tree
      * 
@@ -88,6 +135,9 @@ private:
     /// Common weight from the data set
     double weightDataset;
     
+    /// Name of a SharedTree plugin whose tree is used, or an empty string for a dedicated tree
+    std::string sharedTreeName;
+    
     /// Non-owning pointer to output tree
     TTree *tree;
     
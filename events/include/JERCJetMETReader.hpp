@@ -1,5 +1,7 @@
 #pragma once
 
+#include <EtaPhiGrid.hpp>
+#include <JetBlock.hpp>
 #include <PhysicsObjects.hpp>
 
 #include <mensura/JetMETReader.hpp>
@@ -34,9 +36,14 @@ class PECInputData;
  * If the name of a plugin that reads generator-level jets is provided with the help of the method
  * SetGenJetReader, angular matching to them is performed. The maximal allowed angular distance for
  * matching is set to half of the radius parameter of reconstructed jets. User can additionally
- * impose a cut on the difference between pt of the two jets via method SetGenPtMatching.
+ * impose a cut on the difference between pt of the two jets via method SetGenPtMatching. To avoid
+ * checking all pairs of jets, generator-level jets are indexed with an EtaPhiGrid.
+ * 
+ * Jets are built in a columnar JetBlock, which is available via method GetJetBlock. The standard
+ * collection returned by JetMETReader::GetJets is filled from it unless this is disabled with
+ * method SetFillStandardJets (see JetBlockProvider).
  */
-class JERCJetMETReader: public JetMETReader
+class JERCJetMETReader: public JetMETReader, public JetBlockProvider
 {
 public:
     /**
@@ -96,14 +103,21 @@ public:
      */
     virtual double GetJetRadius() const override;
     
+    /**
+     * \brief Returns jets in the current event in the columnar layout
+     * 
+     * Implemented from JetBlockProvider.
+     */
+    virtual JetBlock const &GetJetBlock() const override;
+    
     /**
      * \brief Specifies whether jet ID selection should be applied or not
      * 
      * The selection is applied or not depending on the value of the given flag; by default, the
      * plugin is configured to apply it. If the selection is applied, jets that fail loose ID are
-     * rejected. Otherwise all jets are written to the output collection, and for each jet a
-     * UserInt with label "ID" is added whose value is 1 or 0 depending on whether the jet passes
-     * the ID selection or not.
+     * rejected. Otherwise all jets are written to the output collection. In both cases, for each
+     * jet a UserInt with label "ID" is added whose value is 1 or 0 depending on whether the jet
+     * passes the ID selection or not.
      */
     void SetApplyJetID(bool applyJetID);
     
@@ -140,7 +154,8 @@ public:
      * 
      * Provided selector is applied to fully constructed jets. If it returns false, the jet is
      * dropped from the collection. Can be used together with the version with rectangular cut on
-     * jet pt and eta.
+     * jet pt and eta. Since a Jet object needs to be constructed for each jet, this selection is
+     * more expensive than the rectangular one.
      */
     void SetSelection(std::function<bool(Jet const &)> jetSelector);
     
@@ -168,6 +183,9 @@ private:
     /// Non-owning pointer to buffer to read missing pt
     jec::MET *bfMET;
     
+    /// Jets in the current event in the columnar layout
+    JetBlock jetBlock;
+    
     /// Minimal allowed transverse momentum
     double minPt;
     
@@ -207,6 +225,9 @@ private:
     /// Non-owning pointer to a plugin that produces generator-level jets
     GenJetMETReader const *genJetPlugin;
     
+    /// Spatial index of generator-level jets in the current event
+    EtaPhiGrid genJetGrid;
+    
     /// Name of the plugin that provides information about pileup
     std::string puPluginName;
     
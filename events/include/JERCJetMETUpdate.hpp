@@ -1,11 +1,16 @@
 #pragma once
 
+#include <JetBlock.hpp>
+
 #include <mensura/JetMETReader.hpp>
 
 #include <mensura/SystService.hpp>
 #include <mensura/JetCorrectorService.hpp>
 
+#include <vector>
+
 
+class BatchJetCorrectorService;
 class EventIDReader;
 class PileUpReader;
 
@@ -26,9 +31,26 @@ class PileUpReader;
  * If a SystService with a non-trivial name is provided (by default, the plugin looks for a service
  * with name "Systematics"), plugin checks the requested systematics and applies variations in JEC
  * or JER as needed. However, systematic variations are never applied to jets with L1 corrections
- * that are used in the type 1 MET correction.
+ * that are used in the type 1 MET correction. Alternatively, the variation can be specified
+ * explicitly with method SetSystematics, which allows to run several instances of this plugin
+ * with different variations in the same job.
+ * 
+ * Instead of a pair of JetCorrectorService objects, a BatchJetCorrectorService can be used, which
+ * evaluates full and L1 corrections for all jets in the event with a single call. This is faster
+ * but does not support systematic variations in the corrections or JER smearing.
+ * 
+ * The source JetMETReader must implement JetBlockProvider. Corrected jets are stored in a JetBlock
+ * too. As in JERCJetMETReader, the standard collection returned by JetMETReader::GetJets is filled
+ * from it unless this is disabled with method SetFillStandardJets.
+ * 
+ * When most events are rejected based on the leading jet, a lazy mode can be enabled with method
+ * SetLazyLeadingJetCut. In this mode, jets from the source collection are corrected in small
+ * groups, in the order of decreasing original pt, until the leading corrected jet is found. If it
+ * fails the given selection, other jets are not corrected, and only the leading jet is provided,
+ * while MET is set to the raw MET. Such events must be rejected downstream by a FirstJetFilter with
+ * the same selection. Otherwise, all jets are corrected and MET is computed as usual.
  */
-class JERCJetMETUpdate: public JetMETReader
+class JERCJetMETUpdate: public JetMETReader, public JetBlockProvider
 {
 public:
     /**
@@ -68,9 +90,48 @@ public:
      */
     virtual double GetJetRadius() const override;
     
+    /**
+     * \brief Returns corrected jets in the current event in the columnar layout
+     * 
+     * Implemented from JetBlockProvider.
+     */
+    virtual JetBlock const &GetJetBlock() const override;
+    
+    /**
+     * \brief Requests that corrections are evaluated with a BatchJetCorrectorService
+     * 
+     * If this method is called, services given in the constructor are not used, and their names
+     * may be empty. Systematic variations must not be requested. An empty name restores the
+     * default behaviour.
+     */
+    void SetBatchCorrector(std::string const &name);
+    
+    /**
+     * \brief Enables the lazy mode with the given selection on the leading jet
+     * 
+     * The leading jet passes the selection if its pt >= minPt and |eta| <= maxAbsEta, which is the
+     * convention of FirstJetFilter. The search for the leading jet stops when the remaining jets
+     * cannot overtake it, even if they receive the largest correction factor allowed by the
+     * loaded correction tables (see BatchJetCorrectorService::GetMaxFullFactor). For this bound
+     * to hold, jets in the source collection must be ordered in raw pt, which is the case when
+     * they are not corrected, as in JERCJetMETReader.
+     * 
+     * Only supported with a BatchJetCorrectorService. With JetCorrectorService, the stochastic JER
+     * smearing would make the results depend on the mode.
+     */
+    void SetLazyLeadingJetCut(double minPt, double maxAbsEta);
+    
     /// Specifies desired selection on jets
     void SetSelection(double minPt, double maxAbsEta);
     
+    /**
+     * \brief Requests the given systematic variation explicitly
+     * 
+     * After this method has been called, the SystService is not consulted.
+     */
+    void SetSystematics(JetCorrectorService::SystType systType,
+      SystService::VarDirection systDirection);
+    
     /**
      * \brief Sets the pt threshold used in the (smoothed) type 1 correction
      * 
@@ -89,6 +150,24 @@ private:
      */
     virtual bool ProcessEvent() override;
     
+    /**
+     * \brief Corrects source jets until the leading one is found and checks if it passes the
+     * selection of the lazy mode
+     * 
+     * Sets numCorrected and leadIndex.
+     */
+    bool CheckLeadingJet(double rho);
+    
+    /**
+     * \brief Evaluates full and L1 correction factors for jets with indices in the range [begin,
+     * end) in the source collection
+     * 
+     * The factors are written into corrFull and corrL1, which must have been resized to the size
+     * of the source collection. The L1 factors are only guaranteed to be computed for jets whose
+     * fully corrected pt exceeds the threshold in the type 1 correction.
+     */
+    void EvalCorrections(double rho, std::size_t begin, std::size_t end);
+    
     /**
      * \brief Computes jet weight for the computation of smoothed type 1 correction
      * 
@@ -102,15 +181,34 @@ private:
     JetMETReader const *jetmetPlugin;
     std::string jetmetPluginName;
     
+    /// Non-owning pointer to jets from the source plugin in the columnar layout
+    JetBlock const *srcJetBlock;
+    
+    /// Corrected jets in the current event in the columnar layout
+    JetBlock jetBlock;
+    
     /// Non-owning pointer to a plugin that reports event ID
     EventIDReader const *eventIDPlugin;
     std::string eventIDPluginName;
     
+    /**
+     * \brief Run for which IOVs have been selected in jet correctors
+     * 
+     * Consecutive events almost always come from the same run, so the selection is only updated
+     * when the run changes. The flag shows whether the run number is valid.
+     */
+    unsigned long iovRun;
+    bool iovRunValid;
+    
     /// Non-owning pointer to and name of a plugin that reads information about pile-up
     PileUpReader const *puPlugin;
     std::string puPluginName;
     
-    /// Name of a service that reports requested systematics
+    /**
+     * \brief Name of a service that reports requested systematics
+     * 
+     * Empty if the variation has been specified explicitly.
+     */
     std::string systServiceName;
     
     /// Non-owning pointer to and name of a service to recorrect jets
@@ -125,6 +223,33 @@ private:
     JetCorrectorService const *jetCorrL1;
     std::string jetCorrL1Name;
     
+    /**
+     * \brief Non-owning pointer to and name of service to evaluate corrections for all jets at
+     * once
+     * 
+     * The name is empty if JetCorrectorService objects are used instead.
+     */
+    BatchJetCorrectorService const *batchCorr;
+    std::string batchCorrName;
+    
+    /// Raw momenta and areas of source jets in the current event, as input for batch corrections
+    std::vector<double> rawPt, rawEta, area;
+    
+    /// Full and L1 correction factors for source jets in the current event
+    std::vector<double> corrFull, corrL1;
+    
+    /// Indicates whether the lazy mode is enabled
+    bool lazyMode;
+    
+    /// Selection on the leading jet in the lazy mode
+    double lazyMinPt, lazyMaxAbsEta;
+    
+    /// Number of source jets corrected so far in the current event
+    std::size_t numCorrected;
+    
+    /// Index of the leading corrected jet in the source collection or -1 if there is none
+    long leadIndex;
+    
     /// Minimal allowed transverse momentum
     double minPt;
     
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <mensura/PhysicsObjects.hpp>
+
+#include <cstdint>
+#include <vector>
+
+
+class JetMETReader;
+class Plugin;
+
+
+/**
+ * \class JetBlock
+ * \brief Collection of jets stored in a columnar layout
+ *
+ * Properties of jets are stored in contiguous arrays, one array per property, which avoids
+ * constructing a Jet object with a TLorentzVector for every jet in an event. Jets are accessed by
+ * index, e.g. block.Pt()[i] and block.Eta()[i]. Stored momenta are fully corrected. Raw momenta
+ * can be obtained by multiplying them by factors given by RawFactor.
+ *
+ * Standard jet objects are only built when requested, with method GetJets or Export. This allows
+ * to provide both representations from the same plugin without paying for the standard one when
+ * no consumer needs it.
+ */
+class JetBlock
+{
+public:
+    /// Constructs an empty collection
+    JetBlock();
+
+public:
+    /**
+     * \brief Adds a new jet at the end of the collection
+     *
+     * The given momentum must be fully corrected. The raw factor converts it into the raw
+     * momentum.
+     */
+    void Add(double pt, double eta, double phi, double mass, double area, double rawFactor, bool id,
+      GenJet const *matchedGenJet = nullptr);
+
+    /// Returns jet areas
+    std::vector<double> const &Area() const
+    {
+        return area;
+    }
+
+    /**
+     * \brief Constructs a standard jet object for the jet with the given index
+     *
+     * The object includes a UserInt with label "ID", whose value is 1 or 0 depending on whether
+     * the jet passes the ID selection or not.
+     */
+    Jet BuildJet(std::size_t index) const;
+
+    /// Removes all jets, keeping allocated memory
+    void Clear();
+
+    /// Returns pseudorapidities of jets
+    std::vector<double> const &Eta() const
+    {
+        return eta;
+    }
+
+    /**
+     * \brief Fills the given vector with standard jet objects
+     *
+     * The vector is cleared first. The order of jets is preserved. See BuildJet for details.
+     */
+    void Export(std::vector<Jet> &jets) const;
+
+    /**
+     * \brief Returns standard jet objects for all jets in the collection
+     *
+     * The objects are built on the first call after the collection has been modified and reused
+     * in subsequent calls. See BuildJet for details.
+     */
+    std::vector<Jet> const &GetJets() const;
+
+    /// Returns number of jets in the collection
+    std::size_t GetSize() const
+    {
+        return pt.size();
+    }
+
+    /// Returns flags showing whether jets pass the ID selection
+    std::vector<std::uint8_t> const &ID() const
+    {
+        return id;
+    }
+
+    /// Returns masses of jets
+    std::vector<double> const &Mass() const
+    {
+        return mass;
+    }
+
+    /**
+     * \brief Returns matched generator-level jets
+     *
+     * A pointer is null if there is no match.
+     */
+    std::vector<GenJet const *> const &MatchedGenJet() const
+    {
+        return matchedGenJet;
+    }
+
+    /// Returns azimuthal angles of jets
+    std::vector<double> const &Phi() const
+    {
+        return phi;
+    }
+
+    /// Returns transverse momenta of jets
+    std::vector<double> const &Pt() const
+    {
+        return pt;
+    }
+
+    /// Returns factors that convert corrected momenta of jets into raw momenta
+    std::vector<double> const &RawFactor() const
+    {
+        return rawFactor;
+    }
+
+    /// Removes the last jet from the collection
+    void RemoveLast();
+
+    /// Orders jets in the decreasing order in pt
+    void SortByPt();
+
+private:
+    /// Reorders given array according to \ref order, using the given buffer
+    template<typename T>
+    void Permute(std::vector<T> &values, std::vector<T> &buffer) const;
+
+private:
+    /// Properties of jets
+    std::vector<double> pt, eta, phi, mass, area, rawFactor;
+
+    /// Flags for the ID selection
+    std::vector<std::uint8_t> id;
+
+    /// Non-owning pointers to matched generator-level jets
+    std::vector<GenJet const *> matchedGenJet;
+
+    /**
+     * \brief Buffers used in sorting
+     *
+     * Stored as members in order to avoid memory allocation for each event.
+     */
+    std::vector<unsigned> order;
+    std::vector<double> doubleBuffer;
+    std::vector<std::uint8_t> idBuffer;
+    std::vector<GenJet const *> genJetBuffer;
+
+    /// Standard jet objects built by GetJets
+    mutable std::vector<Jet> builtJets;
+
+    /// Indicates whether \ref builtJets are up to date
+    mutable bool jetsBuilt;
+};
+
+
+/**
+ * \class JetBlockProvider
+ * \brief Interface for plugins that provide jets in the columnar layout
+ *
+ * By default, a JetMETReader that implements this interface also fills its standard collection of
+ * jets, so that JetMETReader::GetJets keeps working. This requires building a Jet object for every
+ * jet in every event and can be disabled with method SetFillStandardJets when no consumer reads
+ * the standard collection directly. Consumers can always obtain standard jet objects with the free
+ * function GetJets, which builds them from the JetBlock on the first access in an event if the
+ * standard collection is not filled.
+ */
+class JetBlockProvider
+{
+public:
+    /// Constructor
+    JetBlockProvider();
+
+    virtual ~JetBlockProvider() = default;
+
+public:
+    /// Returns jets in the current event
+    virtual JetBlock const &GetJetBlock() const = 0;
+
+    /// Checks whether the standard collection of jets is filled
+    bool IsFillingStandardJets() const
+    {
+        return fillStandardJets;
+    }
+
+    /**
+     * \brief Specifies whether the standard collection of jets should be filled
+     *
+     * If disabled, JetMETReader::GetJets returns an empty collection. Standard jet objects are
+     * then only available via the free function GetJets.
+     */
+    void SetFillStandardJets(bool enable);
+
+protected:
+    /// Indicates whether the standard collection of jets should be filled
+    bool fillStandardJets;
+};
+
+
+/**
+ * \brief Returns jets in the columnar layout from the given plugin
+ *
+ * Throws an exception if the plugin does not implement JetBlockProvider. The returned reference
+ * remains valid for the lifetime of the plugin.
+ */
+JetBlock const &GetJetBlock(Plugin const *plugin);
+
+
+/**
+ * \brief Returns standard jet objects from the given JetMETReader
+ *
+ * If the plugin implements JetBlockProvider and does not fill its standard collection of jets, the
+ * objects are built from its JetBlock on the first access in the current event. Otherwise the
+ * collection is returned by JetMETReader::GetJets.
+ */
+std::vector<Jet> const &GetJets(JetMETReader const *plugin);
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+ * \class JetCorrectionFormula
+ * \brief Formula from a jet correction text file, evaluated for many jets at once
+ *
+ * The formula is written in the subset of the TFormula syntax used in files with jet corrections
+ * produced by the JERC group. Variables are denoted as x, y, z, and t, and parameters as [0], [1],
+ * and so on. Supported operators are +, -, *, /, and ^ (power). Supported functions are exp, log,
+ * log10, pow, sqrt, abs, max, min, atan, tanh, cos, and sin, also with the "TMath::" prefix and
+ * capitalized as in TMath.
+ *
+ * The expression is compiled into a program for a stack machine. Each instruction is applied to
+ * a batch of jets at once, so that it is executed as a simple loop over contiguous arrays that the
+ * compiler can vectorize. The compiled program can be exported with method Pack and used later to
+ * construct the formula without parsing the expression again.
+ *
+ * Files with jet corrections use only a handful of functional forms. If the compiled program is
+ * identical to the program of one of these known forms, the formula is evaluated instead with a
+ * dedicated function, in which the whole expression is computed in a single loop over jets. The
+ * function performs the same operations in the same order as the program, so the results are
+ * identical. The comparison is done for compiled programs, which makes it insensitive to spaces,
+ * redundant parentheses, and spelling of function names.
+ */
+class JetCorrectionFormula
+{
+public:
+    /**
+     * \brief Instruction of the compiled program in a form suitable for storing in binary files
+     *
+     * The layout does not depend on the definition of the operation codes in this class, and the
+     * size of the structure is a multiple of the alignment of double.
+     */
+    struct PackedInstruction
+    {
+        /// Code of the operation
+        std::uint32_t code;
+
+        /// Index of the variable or the parameter
+        std::uint32_t index;
+
+        /// Value of the constant
+        double value;
+    };
+
+public:
+    /**
+     * \brief Compiles the given expression
+     *
+     * \param expression  Expression in the TFormula syntax.
+     * \param numVariables  Number of variables that can be used in the expression.
+     *
+     * Throws an exception if the expression cannot be parsed.
+     */
+    JetCorrectionFormula(std::string const &expression, unsigned numVariables);
+
+    /**
+     * \brief Constructs the formula from a program exported with method Pack
+     *
+     * \param expression  Original expression, which is only stored.
+     * \param numVariables  Number of variables that can be used in the program.
+     * \param program  Array of instructions.
+     * \param programSize  Number of instructions in the array.
+     *
+     * Throws an exception if the program is not valid.
+     */
+    JetCorrectionFormula(std::string const &expression, unsigned numVariables,
+      PackedInstruction const *program, std::size_t programSize);
+
+public:
+    /**
+     * \brief Evaluates the formula for a batch of jets
+     *
+     * \param size  Number of jets in the batch.
+     * \param variables  Arrays of values of the variables, one array per variable. Each array
+     *     must contain at least size elements.
+     * \param parameters  Arrays of values of the parameters, one array per parameter.
+     * \param result  Array into which the values of the formula are written.
+     * \param stack  Buffer used in the evaluation. It is resized as needed.
+     */
+    void Evaluate(std::size_t size, double const *const *variables,
+      double const *const *parameters, double *result, std::vector<double> &stack) const;
+
+    /// Returns the original expression
+    std::string const &GetExpression() const
+    {
+        return expression;
+    }
+
+    /// Returns the number of parameters used in the formula, i.e. the largest index plus one
+    unsigned GetNumParameters() const
+    {
+        return numParameters;
+    }
+
+    /// Returns the number of variables that can be used in the formula
+    unsigned GetNumVariables() const
+    {
+        return numVariables;
+    }
+
+    /// Exports the compiled program
+    std::vector<PackedInstruction> Pack() const;
+
+private:
+    /// Operations supported by the stack machine
+    enum class OpCode: std::uint8_t
+    {
+        Constant,
+        Variable,
+        Parameter,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Power,
+        Max,
+        Min,
+        Negate,
+        Exp,
+        Log,
+        Log10,
+        Sqrt,
+        Abs,
+        Atan,
+        Tanh,
+        Cos,
+        Sin
+    };
+
+    /// Single instruction of the stack machine
+    struct Instruction
+    {
+        OpCode code;
+
+        /// Index of the variable or the parameter
+        unsigned index;
+
+        /// Value of the constant
+        double value;
+    };
+
+    /**
+     * \brief Function that evaluates a formula of a known form for a batch of jets
+     *
+     * The arguments have the same meaning as in method Evaluate.
+     */
+    using Kernel = void (*)(std::size_t size, double const *const *variables,
+      double const *const *parameters, double *result);
+
+    /// Tag to construct a formula without an attempt to recognize its form
+    struct NoFormRecognition
+    {};
+
+    /// Recursive-descent parser that translates an expression into a list of instructions
+    class Parser;
+
+private:
+    /// Compiles the given expression without an attempt to recognize its form
+    JetCorrectionFormula(std::string const &expression, unsigned numVariables,
+      NoFormRecognition);
+
+private:
+    /// Appends an instruction to the program and updates the bookkeeping of the stack depth
+    void Emit(OpCode code, unsigned index = 0, double value = 0.);
+
+    /**
+     * \brief Returns the kernel for the known form whose program is identical to the current one
+     *
+     * If there is no such form, returns a null pointer.
+     */
+    Kernel FindKernel() const;
+
+private:
+    /// Original expression
+    std::string expression;
+
+    /// Number of variables that can be used in the formula
+    unsigned numVariables;
+
+    /// Number of parameters used in the formula
+    unsigned numParameters;
+
+    /// Compiled program
+    std::vector<Instruction> program;
+
+    /// Current and maximal depth of the stack
+    unsigned depth, maxDepth;
+
+    /// Dedicated function to evaluate the formula, or null if the program must be executed
+    Kernel kernel;
+};
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <JetCorrectionFormula.hpp>
+#include <MappedFile.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/**
+ * \struct JetCorrectionInput
+ * \brief Properties of a batch of jets needed to evaluate jet corrections
+ *
+ * All arrays contain size elements. Momenta must be raw.
+ */
+struct JetCorrectionInput
+{
+    /// Number of jets
+    std::size_t size;
+
+    /// Raw transverse momenta, pseudorapidities, and areas of jets
+    double const *pt, *eta, *area;
+
+    /// Mean angular pt density in the event
+    double rho;
+};
+
+
+/**
+ * \class JetCorrectionLevel
+ * \brief A single level of jet corrections read from a text file
+ *
+ * Reads a text file in the standard format adopted by the JERC group and evaluates the correction
+ * for a batch of jets. The file is expected to contain a single section. Supported variables are
+ * JetPt, JetEta, JetA, and Rho. The lookup and evaluation follow the conventions of
+ * SimpleJetCorrector in CMSSW: a jet is assigned to the bin whose ranges include the values of all
+ * binning variables, with the lower edge included and the upper one excluded; if no bin is found,
+ * the correction is 1; values of the parametrization variables are clamped to the range given in
+ * the bin.
+ *
+ * Parsing a text file can be avoided by compiling it beforehand into a binary file with method
+ * WriteCompiled (see program compile_jec). Such a file contains tables of bins and parameters in
+ * the native binary representation and the compiled program of the formula. It is placed next to
+ * the text file and is picked up by method Load when it is up to date. Tables from a compiled
+ * file are used in place, through a read-only memory mapping, so they are shared among all jobs
+ * that use the same file on a node.
+ */
+class JetCorrectionLevel
+{
+public:
+    /// Buffers used in the evaluation, kept between calls to avoid memory allocations
+    struct Buffers
+    {
+        std::vector<unsigned> lanes;
+        std::vector<int> bins;
+        std::vector<double> variables, parameters, values, rho;
+        std::vector<double const *> variablePointers, parameterPointers;
+        std::vector<double> stack;
+    };
+
+    /// Supported variables
+    enum class Variable
+    {
+        JetPt,
+        JetEta,
+        JetA,
+        Rho
+    };
+
+public:
+    /**
+     * \brief Reads the level from the given file
+     *
+     * The path must be fully resolved. Throws an exception if the file cannot be read or has an
+     * unsupported format.
+     */
+    JetCorrectionLevel(std::string const &path);
+
+private:
+    /**
+     * \brief Constructs the level from the given compiled file
+     *
+     * The path refers to the source text file. Throws an exception if the compiled file is
+     * corrupted.
+     */
+    JetCorrectionLevel(std::string const &path, std::shared_ptr<MappedFile const> compiledFile);
+
+public:
+    /**
+     * \brief Evaluates corrections for a batch of jets
+     *
+     * \param input  Properties of jets. Momenta in it are ignored.
+     * \param pt  Transverse momenta of jets to be used in the evaluation. They are expected to
+     *     include corrections of all previous levels.
+     * \param factors  Array into which correction factors are written.
+     * \param buffers  Buffers used in the evaluation.
+     */
+    void Eval(JetCorrectionInput const &input, double const *pt, double *factors,
+      Buffers &buffers) const;
+
+    /**
+     * \brief Returns path of the compiled file that corresponds to the given text file
+     *
+     * It is obtained by replacing the extension with ".jecbin".
+     */
+    static std::string GetCompiledPath(std::string const &path);
+
+    /**
+     * \brief Returns values of the given variable at which the correction can change abruptly
+     *
+     * These are the edges of the bins and of the ranges of the parametrization variables, sorted
+     * and without duplicates. Intended for validation.
+     */
+    std::vector<double> GetEdges(Variable variable) const;
+
+    /**
+     * \brief Returns an upper bound on the correction factor for any jet
+     *
+     * The bound is found when the level is read, by evaluating the formula in every bin on a grid
+     * that spans the ranges of the parametrization variables, which is logarithmic in pt. Since
+     * values of these variables are clamped to the ranges, the corners of the ranges are included
+     * in the grid, and the bin edges only select the parameters, the grid covers all jets except
+     * for values between grid points. To account for them, the largest difference between
+     * neighbouring grid points along each variable is added to the largest sampled value. This is
+     * twice the excess allowed for a formula whose derivative does not change much within a cell
+     * of the grid, which holds for the smooth formulas used in jet corrections. The bound is not
+     * rigorous for formulas that oscillate on the scale of the cells. It can be checked with the
+     * program validate_jec. Jets outside of all bins are not corrected, so the bound is at least
+     * 1.
+     */
+    double GetMaxFactor() const
+    {
+        return maxFactor;
+    }
+
+    /// Returns the name of the level as given in the file
+    std::string const &GetName() const
+    {
+        return name;
+    }
+
+    /// Checks if the level has been read from a compiled file
+    bool IsCompiled() const
+    {
+        return bool(compiledFile);
+    }
+
+    /**
+     * \brief Reads the level from the given text file or its compiled version
+     *
+     * The compiled file is used if it exists and has been produced from a text file with the same
+     * size and modification time. Otherwise the text file is parsed.
+     */
+    static std::shared_ptr<JetCorrectionLevel const> Load(std::string const &path);
+
+    /**
+     * \brief Writes the level into a compiled file with the given path
+     *
+     * The file records the size and the modification time of the source text file. It is first
+     * written under a temporary name and then renamed, so that it can be replaced safely while
+     * other jobs are reading it.
+     */
+    void WriteCompiled(std::string const &compiledPath) const;
+
+private:
+    /// Computes \ref maxFactor
+    void ComputeMaxFactor();
+
+    /**
+     * \brief Returns index of the bin that contains the given jet or -1 if there is no such bin
+     *
+     * The first argument contains arrays of values of binning variables for all jets in the
+     * batch.
+     */
+    int FindBin(double const *const *binValues, std::size_t jet) const;
+
+    /// Returns values of the given variable for the batch of jets
+    static double const *GetValues(Variable variable, JetCorrectionInput const &input,
+      double const *pt, Buffers &buffers);
+
+    /// Converts name of a variable in the header of the file into Variable
+    static Variable ParseVariable(std::string const &name, std::string const &path);
+
+private:
+    /// Path to the source file
+    std::string path;
+
+    /// Name of the level
+    std::string name;
+
+    /// Variables used to define bins and variables used in the parametrization
+    std::vector<Variable> binVariables, parVariables;
+
+    /// Formula of the parametrization
+    std::unique_ptr<JetCorrectionFormula> formula;
+
+    /// Number of bins
+    unsigned numBins;
+
+    /**
+     * \brief Storage for the tables below when they have been read from a text file
+     *
+     * Contains concatenated binEdges, parRanges, and parameters.
+     */
+    std::vector<double> tables;
+
+    /// Compiled file that holds the tables below, if the level has been read from it
+    std::shared_ptr<MappedFile const> compiledFile;
+
+    /**
+     * \brief Edges of the bins
+     *
+     * For bin i and binning variable j, the range is given by elements 2 * (i * nVar + j) and the
+     * following one, where nVar is the number of binning variables.
+     */
+    double const *binEdges;
+
+    /// Ranges of the parametrization variables, in the same layout as for binEdges
+    double const *parRanges;
+
+    /**
+     * \brief Parameters of the formula
+     *
+     * Stored as a matrix of size numBins x formula->GetNumParameters().
+     */
+    double const *parameters;
+
+    /**
+     * \brief Indicates that the bins are defined with a single variable, sorted, and do not
+     * overlap
+     *
+     * In this case the lookup is performed with a binary search.
+     */
+    bool sortedBins;
+
+    /// Upper bound on the correction factor, see GetMaxFactor
+    double maxFactor;
+};
@@ -7,6 +7,7 @@
 #include <string>
 
 
+class JetBlock;
 class JetMETReader;
 
 
@@ -42,6 +43,9 @@ public:
      */
     virtual Plugin *Clone() const override;
     
+    /// Changes name of the plugin that provides jets and MET
+    void SetJetMETPluginName(std::string const &name);
+    
 private:
     /**
      * \brief Performs selection on the leading jet
@@ -57,6 +61,9 @@ private:
     /// Non-owning pointer to the plugin that produces jets
     JetMETReader const *jetmetPlugin;
     
+    /// Non-owning pointer to jets from the above plugin in the columnar layout
+    JetBlock const *jetBlock;
+    
     /// Requested selection on pt
     double minPt;
 };
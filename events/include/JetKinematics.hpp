@@ -0,0 +1,155 @@
+#pragma once
+
+#include <mensura/AnalysisPlugin.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+class JetBlock;
+class JetMETReader;
+
+
+/**
+ * \class JetKinematics
+ * \brief Computes kinematic quantities of jets shared by several downstream plugins
+ *
+ * Plugins that compute balance observables, fill histograms, and apply angular cuts need the same
+ * components of jet momenta, their projections onto the direction of the leading jet, angles
+ * between leading jets, and the recoil. This plugin computes them once per event and stores them
+ * in contiguous arrays, so that plugins instantiated for each trigger bin do not repeat the
+ * trigonometry.
+ *
+ * All jets are considered, without any pt threshold. Jets are expected to be ordered in pt. This
+ * plugin relies on the presence of a JetMETReader with a default name "JetMET". It never rejects
+ * events.
+ */
+class JetKinematics: public AnalysisPlugin
+{
+public:
+    /// Constructs a plugin with the given name
+    JetKinematics(std::string const &name = "JetKinematics");
+
+public:
+    /**
+     * \brief Saves pointer to the jet reader
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void BeginRun(Dataset const &) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Plugin.
+     */
+    virtual JetKinematics *Clone() const override;
+
+    /**
+     * \brief Returns absolute value of Delta(phi) between the two leading jets
+     *
+     * The angle is in the range [0, pi]. Zero if there are fewer than two jets.
+     */
+    double GetDPhi12() const
+    {
+        return dPhi12;
+    }
+
+    /**
+     * \brief Returns absolute value of Delta(phi) between the second and third jets
+     *
+     * The angle is in the range [0, pi]. Zero if there are fewer than three jets.
+     */
+    double GetDPhi23() const
+    {
+        return dPhi23;
+    }
+
+    /**
+     * \brief Returns projection of missing pt onto the direction of the leading jet
+     *
+     * Zero if there are no jets.
+     */
+    double GetMETLeadProjection() const
+    {
+        return metLeadProjection;
+    }
+
+    /// Returns number of jets in the current event
+    std::size_t GetNumJets() const
+    {
+        return px.size();
+    }
+
+    /**
+     * \brief Returns pt of the vectorial sum of all jets except for the leading one with pt not
+     * smaller than the given threshold
+     *
+     * Zero if there are no such jets.
+     */
+    double GetRecoilPt(double minPt) const;
+
+    /**
+     * \brief Returns projections of momenta of jets onto the direction of the leading jet
+     *
+     * The projection for jet j is pt_j * cos(phi_j - phi_lead). The first element is pt of the
+     * leading jet.
+     */
+    std::vector<double> const &LeadProjection() const
+    {
+        return leadProjection;
+    }
+
+    /// Returns x components of momenta of jets
+    std::vector<double> const &Px() const
+    {
+        return px;
+    }
+
+    /// Returns y components of momenta of jets
+    std::vector<double> const &Py() const
+    {
+        return py;
+    }
+
+    /// Changes name of the plugin that provides jets and MET
+    void SetJetMETPluginName(std::string const &name);
+
+private:
+    /**
+     * \brief Computes kinematic quantities for the current event
+     *
+     * Implemented from Plugin.
+     */
+    virtual bool ProcessEvent() override;
+
+private:
+    /// Name of the plugin that produces jets and MET
+    std::string jetmetPluginName;
+
+    /// Non-owning pointer to the plugin that produces jets and MET
+    JetMETReader const *jetmetPlugin;
+
+    /// Non-owning pointer to jets from the above plugin in the columnar layout
+    JetBlock const *jetBlock;
+
+    /// Components of momenta of jets
+    std::vector<double> px, py;
+
+    /// Projections of momenta of jets onto the direction of the leading jet
+    std::vector<double> leadProjection;
+
+    /**
+     * \brief Cumulative sums of components of momenta of jets, starting from the second one
+     *
+     * Element k is the sum over k jets that follow the leading one. The first element is zero.
+     */
+    std::vector<double> recoilPx, recoilPy;
+
+    /// Angles between leading jets
+    double dPhi12, dPhi23;
+
+    /// Projection of missing pt onto the direction of the leading jet
+    double metLeadProjection;
+};
@@ -1,11 +1,11 @@
 #pragma once
 
+#include <BinnedAxis.hpp>
+
 #include <mensura/AnalysisPlugin.hpp>
 
 #include <mensura/JetMETReader.hpp>
 
-#include <TH1.h>
-
 #include <array>
 #include <map>
 #include <memory>
@@ -13,52 +13,152 @@
 #include <vector>
 
 
+class JetBlock;
+class TH1;
+
+
 /**
  * \brief Computes L1T prefiring weights
  *
  * This plugin should be run on simulation only. For each event it computes probabilities that it
  * has not been self-vetoed because of the L1T prefiring. The probabilities are computed for all
  * requested data-taking periods. Systematic variations are also provided.
+ *
+ * Jets are read from a JetMETReader with a default name "JetMET", which must implement
+ * JetBlockProvider. Weights for all periods are updated in a single pass over jets, in which jets
+ * outside of the range in eta affected by the prefiring are skipped. Periods whose prefiring maps
+ * have the same binning are grouped together, so that the bin of a jet is found only once for
+ * each group.
  */
 class L1TPrefiringWeights: public AnalysisPlugin
 {
 private:
-    /// Auxiliary class to compute weight for a single data-taking period
+    /**
+     * \brief Auxiliary class to compute weights for a group of data-taking periods whose
+     * prefiring maps have the same binning
+     *
+     * The prefiring maps are converted into a flat table that stores, for each bin in (eta, pt)
+     * and each period in the group, probabilities for a jet not to cause prefiring with the
+     * nominal, increased, and decreased prefiring probability. They are padded with a unit factor
+     * to four values. Factors for all periods in a bin are stored next to each other, so that the
+     * event weights for the whole group are updated with a single bin lookup per jet and a loop
+     * over contiguous arrays. This loop is only vectorized by the compiler in optimized builds,
+     * which is why CMakeLists.txt selects build type Release unless another one is requested.
+     */
     class WeightCalc
     {
-    private:
-        /// Supported systematic variations for prefiring probabilities
-        enum class Variation
-        {
-            Nominal,
-            Up,
-            Down
-        };
+    public:
+        /// Non-prefiring probabilities or event weights for the three variations plus padding
+        using Factors = std::array<double, 4>;
 
     public:
-        /// Constructor from a prefiring map
-        WeightCalc(TH1 *prefiringMap_):
-            prefiringMap{prefiringMap_}
-        {}
+        /**
+         * \brief Constructor from the prefiring map of the first period in the group
+         *
+         * The map is parameterized with (eta, pt) of jets; overflows in pt are filled properly.
+         */
+        WeightCalc(TH1 const &prefiringMap);
 
     public:
-        /// Computes event weights with given jets
-        std::array<double, 3> ComputeWeights(std::vector<Jet> const &jets) const;
+        /**
+         * \brief Adds a period with the given prefiring map to the group
+         *
+         * The binning of the map must be the same as for the first period, which can be checked
+         * with method HasSameBinning. Returns the index of the period within the group.
+         */
+        unsigned AddPeriod(TH1 const &prefiringMap);
 
-    private:
-        /// Computes event weight for given systematic variation
-        double ComputeWeight(std::vector<Jet> const &jets, Variation variation) const;
+        /**
+         * \brief Multiplies event weights by non-prefiring probabilities for the given jet
+         *
+         * The weights for all periods in the group are updated. The argument must point to an
+         * array of GetNumPeriods() elements, ordered in the same way as the periods have been
+         * added. Jets outside of the range in eta where the prefiring probability is non-zero
+         * in at least one of the periods are skipped.
+         */
+        void ApplyJet(double eta, double pt, Factors *weights) const
+        {
+            if (eta < minActiveEta or eta >= maxActiveEta)
+                return;
+
+            Factors const *probs = &nonPrefiringProbs[numPeriods *
+              (etaAxis.FindBin(eta) + (etaAxis.GetNumBins() + 2) * ptAxis.FindBin(pt))];
+
+            for (unsigned p = 0; p < numPeriods; ++p)
+                for (unsigned i = 0; i < probs[p].size(); ++i)
+                    weights[p][i] *= probs[p][i];
+        }
+
+        /// Returns the lower boundary of the range in eta where prefiring can occur
+        double GetMinActiveEta() const
+        {
+            return minActiveEta;
+        }
+
+        /// Returns the upper boundary of the range in eta where prefiring can occur
+        double GetMaxActiveEta() const
+        {
+            return maxActiveEta;
+        }
 
-        /// Returns prefiring probability for given jet
-        double GetPrefiringProbability(Jet const &jet, Variation variation) const;
+        /// Returns the number of periods in the group
+        unsigned GetNumPeriods() const
+        {
+            return numPeriods;
+        }
+
+        /// Checks if the given prefiring map has the same binning as maps in the group
+        bool HasSameBinning(TH1 const &prefiringMap) const;
 
     private:
+        /// Binning of the prefiring maps in eta and pt
+        BinnedAxis etaAxis, ptAxis;
+
+        /// Number of periods in the group
+        unsigned numPeriods;
+
+        /**
+         * \brief Non-prefiring probabilities for the nominal, up, and down variations
+         *
+         * Indexed with numPeriods * (etaBin + (etaAxis.GetNumBins() + 2) * ptBin) + period,
+         * where the global bin index includes the underflow and overflow bins, as in ROOT
+         * histograms.
+         */
+        std::vector<Factors> nonPrefiringProbs;
+
+        /**
+         * \brief Range in eta, [min, max), outside of which all prefiring probabilities are zero
+         * in all periods of the group
+         */
+        double minActiveEta, maxActiveEta;
+    };
+
+    /**
+     * \brief Tables for all data-taking periods
+     *
+     * Shared among all instances of this plugin that use the same configuration.
+     */
+    struct Tables
+    {
+        /// Objects to compute prefiring weights in groups of data-taking periods
+        std::vector<WeightCalc> calcs;
+
         /**
-         * \brief Prefiring map
+         * \brief Index of the first period of each group
          *
-         * Parameterized with (eta, pt) of jets; overflows in pt are filled properly.
+         * Periods of each group occupy a contiguous range of indices, in the same order as within
+         * the group.
          */
-        std::unique_ptr<TH1> prefiringMap;
+        std::vector<unsigned> calcOffsets;
+
+        /// Total number of periods
+        unsigned numPeriods;
+
+        /// Maps period labels into period indices
+        std::map<std::string, unsigned> periodLabelMap;
+
+        /// Range in eta, [min, max), outside of which jets do not prefire in any period
+        double minActiveEta, maxActiveEta;
     };
 
 public:
@@ -99,6 +199,9 @@ public:
      */
     unsigned FindPeriodIndex(std::string const &periodLabel) const;
 
+    /// Changes name of the plugin that provides jets
+    void SetJetMETPluginName(std::string const &name);
+
     /**
      * \brief Returns L1T prefiring weights for the period with the given index
      *
@@ -107,7 +210,8 @@ public:
      */
     std::array<double, 3> GetWeights(unsigned periodIndex) const
     {
-        return cachedWeights.at(periodIndex);
+        auto const &weights = cachedWeights.at(periodIndex);
+        return {weights[0], weights[1], weights[2]};
     }
 
     /// Version of GetWeights(unsigned) that identifies a period by its label
@@ -117,8 +221,8 @@ public:
     }
 
 private:
-    /// Construct WeightCalc objects for all periods
-    void BuildCalcs(std::string const &configPath);
+    /// Constructs WeightCalc objects for all groups of periods
+    std::shared_ptr<Tables const> BuildTables(std::string const &configPath) const;
     
     /// Computes prefiring weights for the current event
     virtual bool ProcessEvent() override;
@@ -130,21 +234,12 @@ private:
     /// Non-owning pointer to a plugin that produces jets
     JetMETReader const *jetmetPlugin;
 
-    /**
-     * \brief Objects to compute prefiring weights in different data-taking periods
-     *
-     * Shared among all clones of this plugin.
-     */
-    std::shared_ptr<std::vector<WeightCalc>> calcs;
+    /// Non-owning pointer to jets in the columnar layout
+    JetBlock const *jetBlock;
 
-    /**
-     * \brief Maps period labels into indices of \ref calcs
-     *
-     * Shared among all clones of this plugin.
-     */
-    std::shared_ptr<std::map<std::string, unsigned>> periodLabelMap;
+    /// Tables for all periods, obtained from SharedResources
+    std::shared_ptr<Tables const> tables;
 
-    /// Cached results for WeightCalc::GetWeights for all data-taking periods
-    std::vector<std::array<double, 3>> cachedWeights;
+    /// Weights for all data-taking periods in the current event
+    std::vector<WeightCalc::Factors> cachedWeights;
 };
-
@@ -5,8 +5,10 @@
 #include <string>
 
 
+class JetBlock;
 class JetMETReader;
 class PECTriggerObjectReader;
+class SkimCacheReader;
 
 
 /**
@@ -25,6 +27,11 @@ class PECTriggerObjectReader;
  *   }
  * For each trigger the corresponding trigger name is provided along with two pt ranges. Specific
  * pt range is chosen based on the configuration of the plugin.
+ * 
+ * Trigger objects are read from a PECTriggerObjectReader with a default name "TriggerObjects". When
+ * events are replayed from a skim cache, a SkimCacheReader can be given instead with method
+ * SetTriggerObjectsPluginName. In that case the results of the trigger matching stored in the
+ * cache are used.
  */
 class LeadJetTriggerFilter: public AnalysisPlugin
 {
@@ -63,6 +70,16 @@ public:
      */
     virtual Plugin *Clone() const override;
     
+    /// Changes name of the plugin that provides jets and MET
+    void SetJetMETPluginName(std::string const &name);
+    
+    /**
+     * \brief Changes name of the plugin that provides trigger objects
+     * 
+     * It must be either a PECTriggerObjectReader or a SkimCacheReader.
+     */
+    void SetTriggerObjectsPluginName(std::string const &name);
+    
 private:
     /**
      * \brief Computes variables and fills the output tree
@@ -78,16 +95,26 @@ private:
     /// Non-owning pointer to the plugin that produces jets and MET
     JetMETReader const *jetmetPlugin;
     
+    /// Non-owning pointer to jets from the above plugin in the columnar layout
+    JetBlock const *jetBlock;
+    
     /// Name of a plugin that reads trigger objects
     std::string triggerObjectsPluginName;
     
     /// Non-owning pointer to the plugin that reads trigger objects
     PECTriggerObjectReader const *triggerObjectsPlugin;
     
+    /**
+     * \brief Non-owning pointer to the plugin that reads a skim cache
+     * 
+     * Only one of this pointer and triggerObjectsPlugin is not null.
+     */
+    SkimCacheReader const *skimCachePlugin;
+    
     /// Name of trigger filter
     std::string triggerFilter;
     
-    /// Cached index of trigger filter in PECTriggerObjectReader
+    /// Cached index of trigger filter in PECTriggerObjectReader or SkimCacheReader
     unsigned triggerFilterIndex;
     
     /// Allowed range of pt for the leading jet
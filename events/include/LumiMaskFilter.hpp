@@ -0,0 +1,124 @@
+#pragma once
+
+#include <mensura/AnalysisPlugin.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+class Config;
+class EventIDReader;
+
+
+/**
+ * \class LumiMaskFilter
+ * \brief Selects events from certified luminosity blocks
+ *
+ * The mask is read from a JSON file in the standard certification format, which maps run numbers
+ * to arrays of inclusive ranges of luminosity blocks, such as {"273158": [[1, 1283]]}. This allows
+ * to apply a new mask to input files that were produced without it or with an older one.
+ *
+ * The mask is stored in a compact form, with ranges of all runs kept in a single sorted array, and
+ * is shared among all filters that use the same file, including clones. The verdict for the
+ * current range of luminosity blocks, or the gap between two ranges, is remembered, so that the
+ * mask is only searched when an event falls outside of it. For consecutive events from the same
+ * luminosity block, the check reduces to a few comparisons.
+ *
+ * The filter relies on the presence of a EventIDReader with a default name "InputData".
+ */
+class LumiMaskFilter: public AnalysisPlugin
+{
+private:
+    /// Inclusive range of luminosity blocks
+    struct LumiRange
+    {
+        unsigned long first, last;
+    };
+
+    /// Certified luminosity blocks for all runs
+    struct Mask
+    {
+        /// Reads the mask from the given parsed certification file
+        Mask(Config const &config);
+
+        /// Certified runs, sorted
+        std::vector<unsigned long> runs;
+
+        /**
+         * \brief Positions in \ref ranges of the first range for each run
+         *
+         * Contains an additional element equal to the total number of ranges.
+         */
+        std::vector<std::size_t> runStarts;
+
+        /// Sorted non-overlapping ranges of luminosity blocks for all runs
+        std::vector<LumiRange> ranges;
+    };
+
+public:
+    /// Creates a filter with the given name that applies mask from the given file
+    LumiMaskFilter(std::string const &name, std::string const &maskPath);
+
+    /// A short-cut for the above version with a default name "LumiMaskFilter"
+    LumiMaskFilter(std::string const &maskPath);
+
+public:
+    /**
+     * \brief Saves pointer to the plugin that provides event ID
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void BeginRun(Dataset const &) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Plugin.
+     */
+    virtual LumiMaskFilter *Clone() const override;
+
+    /// Changes name of the plugin that provides event ID
+    void SetEventIDPluginName(std::string const &name);
+
+private:
+    /**
+     * \brief Checks if the luminosity block of the current event is certified
+     *
+     * Implemented from Plugin.
+     */
+    virtual bool ProcessEvent() override;
+
+    /// Finds ranges of luminosity blocks for the given run and resets the cached verdict
+    void SelectRun(unsigned long run);
+
+    /// Finds the range or gap that contains the given luminosity block in the current run
+    void SelectLumi(unsigned long lumi);
+
+private:
+    /// Name of the plugin that provides access to event ID
+    std::string eventIDPluginName;
+
+    /// Non-owning pointer to the plugin that provides access to event ID
+    EventIDReader const *eventIDPlugin;
+
+    /// Certified luminosity blocks
+    std::shared_ptr<Mask const> mask;
+
+    /// Run of the previous event
+    unsigned long curRun;
+
+    /// Ranges of luminosity blocks of the current run, given by positions in Mask::ranges
+    std::size_t curRangesBegin, curRangesEnd;
+
+    /**
+     * \brief Range of luminosity blocks for which the verdict has been found, inclusive
+     *
+     * This is either a certified range or a gap between certified ranges.
+     */
+    unsigned long curMinLumi, curMaxLumi;
+
+    /// Decision for luminosity blocks in the above range
+    bool curVerdict;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+
+/**
+ * \class MappedFile
+ * \brief Read-only memory mapping of a file
+ *
+ * The whole file is mapped into memory with a shared mapping, so that its pages are loaded
+ * lazily and are shared via the page cache among all threads and processes that map the same
+ * file. The mapping is released in the destructor.
+ */
+class MappedFile
+{
+public:
+    /**
+     * \brief Maps the given file
+     *
+     * Throws an exception if the file cannot be opened or mapped.
+     */
+    MappedFile(std::string const &path);
+
+    MappedFile(MappedFile const &) = delete;
+    MappedFile &operator=(MappedFile const &) = delete;
+
+    /// Releases the mapping
+    ~MappedFile();
+
+public:
+    /// Returns pointer to the beginning of the mapped content
+    char const *GetData() const
+    {
+        return data;
+    }
+
+    /// Returns the path to the file
+    std::string const &GetPath() const
+    {
+        return path;
+    }
+
+    /// Returns size of the file in bytes
+    std::size_t GetSize() const
+    {
+        return size;
+    }
+
+private:
+    /// Path to the file
+    std::string path;
+
+    /// Beginning of the mapped content
+    char const *data;
+
+    /// Size of the file in bytes
+    std::size_t size;
+};
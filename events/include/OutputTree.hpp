@@ -0,0 +1,37 @@
+#pragma once
+
+#include <TTree.h>
+
+#include <string>
+
+
+class TFileService;
+
+
+/**
+ * \class OutputTree
+ * \brief Creates output trees with common I/O settings
+ *
+ * Trees produced by different plugins for the same trigger bin contain the same events and are
+ * read together as friends. By default, ROOT flushes a tree to the file when the accumulated size
+ * of its baskets reaches a threshold, so trees with different numbers of branches are split into
+ * clusters at different entries. Then every cluster boundary in any friend tree forces a new
+ * read in the others. To avoid this, all output trees are flushed after the same fixed number of
+ * entries, which aligns their clusters. Entries are accumulated in per-branch baskets in memory
+ * until then, and each tree is only written by the thread that owns its output file.
+ */
+class OutputTree
+{
+public:
+    /**
+     * \brief Creates a tree in the given in-file directory with the help of TFileService
+     *
+     * The directory can be empty. The returned tree is owned by the file.
+     */
+    static TTree *Create(TFileService const &fileService, std::string const &directory,
+      std::string const &name, std::string const &title);
+
+public:
+    /// Number of entries after which all output trees are flushed
+    static constexpr Long64_t clusterSize = 20000;
+};
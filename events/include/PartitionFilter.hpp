@@ -0,0 +1,100 @@
+#pragma once
+
+#include <PartitionIndex.hpp>
+
+#include <mensura/AnalysisPlugin.hpp>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+class PECInputData;
+class TTree;
+
+/**
+ * \class PartitionFilter
+ * \brief Selects entries of input files that belong to requested partitions
+ *
+ * This plugin allows to process a partition of an input file described by a PartitionIndex
+ * without splitting the file physically. For each input file, ranges of entries to be selected
+ * are given with method AddFile. Since the same file can contain entries from several partitions
+ * and each partition is a separate data set, the ranges are specified for a pair of a data set ID
+ * and a file path. All entries in files not registered with this method are accepted.
+ *
+ * The number of the current entry is taken from the tree with event IDs, which is read through a
+ * PECInputData with a default name "InputData". It does not depend on the position of the plugin
+ * in the path. However, the plugin should be placed immediately after the PECInputData, so that
+ * entries from other partitions are rejected before any other trees are read.
+ */
+class PartitionFilter: public AnalysisPlugin
+{
+public:
+    /// Creates a plugin with the given name
+    PartitionFilter(std::string const &name = "PartitionFilter");
+
+public:
+    /**
+     * \brief Specifies ranges of entries to be selected in the given input file when it is read
+     * as a part of the data set with the given ID
+     *
+     * The ranges must be ordered and must not overlap. An empty vector means that the file
+     * should be skipped entirely.
+     */
+    void AddFile(std::string const &datasetID, std::string const &path,
+      std::vector<PartitionIndex::Range> const &ranges);
+
+    /**
+     * \brief Finds ranges of entries for the current input file and sets up reading of the tree
+     * with event IDs
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void BeginRun(Dataset const &dataset) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Plugin.
+     */
+    virtual PartitionFilter *Clone() const override;
+
+private:
+    /**
+     * \brief Checks if the current entry is included in the selected ranges
+     *
+     * Implemented from Plugin.
+     */
+    virtual bool ProcessEvent() override;
+
+private:
+    /// Name of the tree with event IDs
+    static std::string const eventIDTreeName;
+
+    /// Name of the plugin that reads input files
+    std::string inputDataPluginName;
+
+    /// Non-owning pointer to the plugin that reads input files
+    PECInputData const *inputDataPlugin;
+
+    /**
+     * \brief Non-owning pointer to the tree with event IDs in the current file
+     *
+     * Null if all entries of the current file are accepted.
+     */
+    TTree *eventIDTree;
+
+    /// Selected ranges of entries for registered pairs of data set IDs and file paths
+    std::map<std::pair<std::string, std::string>, std::vector<PartitionIndex::Range>> fileRanges;
+
+    /**
+     * \brief Selected ranges in the current file
+     *
+     * Null if all entries are accepted.
+     */
+    std::vector<PartitionIndex::Range> const *curRanges;
+
+    /// Index of the first range in the current file that has not been passed yet
+    unsigned curRangeIndex;
+};
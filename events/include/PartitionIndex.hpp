@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+ * \class PartitionIndex
+ * \brief Describes how entries in an input file are split into partitions based on run numbers
+ *
+ * This is an alternative to splitting files physically with program partition_runs. The index is
+ * stored in a small JSON file next to the input file, with the name given by method GetPath. It
+ * lists ranges of entries with the partition that each range belongs to, together with the first
+ * and the last run number in the range:
+ *   {
+ *     "boundaries": [278802],
+ *     "ranges": [
+ *       {"partition": 1, "begin": 0, "end": 52113, "runs": [277772, 278801]},
+ *       {"partition": 2, "begin": 52113, "end": 80312, "runs": [278802, 278808]}
+ *     ]
+ *   }
+ * Partitions are numbered from 1, in the same way as output files of partition_runs. Partition i
+ * includes runs from boundaries[i - 2], inclusive, to boundaries[i - 1], exclusive. Ranges of
+ * entries are given as [begin, end).
+ */
+class PartitionIndex
+{
+public:
+    /// Range of entries that belong to the same partition
+    struct Range
+    {
+        /// Index of the partition, starting from 1
+        unsigned partition;
+
+        /// Entries included in the range, [begin, end)
+        std::int64_t begin, end;
+
+        /// First and last run numbers in the range
+        unsigned long firstRun, lastRun;
+    };
+
+public:
+    /// Constructs an empty index for the given partition boundaries
+    PartitionIndex(std::vector<unsigned long> const &boundaries);
+
+public:
+    /// Adds an entry with the given run number at the end of the index
+    void AddEntry(unsigned long run);
+
+    /// Returns partition boundaries
+    std::vector<unsigned long> const &GetBoundaries() const
+    {
+        return boundaries;
+    }
+
+    /// Returns path to the index file for the given input file
+    static std::string GetPath(std::string const &inputPath);
+
+    /// Returns all ranges in the index
+    std::vector<Range> const &GetRanges() const
+    {
+        return ranges;
+    }
+
+    /**
+     * \brief Returns ranges of entries that belong to the given partition
+     *
+     * The partition is numbered from 1. The returned vector is empty if the partition contains no
+     * entries.
+     */
+    std::vector<Range> GetRanges(unsigned partition) const;
+
+    /**
+     * \brief Reads the index from the given file
+     *
+     * Throws an exception if the file cannot be read or has an unexpected format.
+     */
+    static PartitionIndex Read(std::string const &path);
+
+    /**
+     * \brief Writes the index into the given file
+     *
+     * Throws an exception if the file cannot be created.
+     */
+    void Write(std::string const &path) const;
+
+private:
+    /// Sorted partition boundaries
+    std::vector<unsigned long> boundaries;
+
+    /// Ranges of entries, ordered in entry numbers
+    std::vector<Range> ranges;
+};
@@ -2,6 +2,7 @@
 
 #include <mensura/AnalysisPlugin.hpp>
 
+#include <BinnedAxis.hpp>
 #include <L1TPrefiringWeights.hpp>
 
 #include <mensura/Config.hpp>
@@ -15,6 +16,8 @@
 #include <filesystem>
 #include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 
 /**
@@ -35,6 +38,29 @@
 class PeriodWeights: public AnalysisPlugin
 {
 private:
+    /**
+     * \brief Ratio between normalized pileup profiles in data and simulation
+     *
+     * The ratio is tabulated in bins defined by the union of bin edges of the two profiles, so it
+     * can be evaluated with a single lookup. Tables are obtained from SharedResources and thus
+     * shared among all instances of this plugin that use the same pair of profiles, including
+     * those for different triggers.
+     */
+    struct PileUpRatioTable
+    {
+        /// Returns the ratio for the given expected pileup
+        double Eval(double mu) const
+        {
+            return ratios[axis.FindBin(mu)];
+        }
+
+        /// Binning of the table
+        BinnedAxis axis;
+
+        /// Ratios for all bins of the axis, including the underflow and overflow
+        std::vector<double> ratios;
+    };
+
     /// An aggregate of period-specific data
     struct Period
     {
@@ -43,8 +69,11 @@ private:
         /// Integrated luminosity, in 1/pb
         double luminosity;
 
-        /// Pileup profile in data
-        std::unique_ptr<TH1> dataPileupProfile;
+        /// Path to the pileup profile in data, relative to \ref profilesDir
+        std::string dataPileupProfile;
+
+        /// Ratio between pileup profiles in data and simulation for the current data set
+        std::shared_ptr<PileUpRatioTable const> pileupRatios;
 
         /**
          * \brief Main weight for the current period
@@ -91,9 +120,44 @@ public:
      */
     virtual PeriodWeights *Clone() const override;
 
+    /// Returns labels of all periods in alphabetic order
+    std::vector<std::string> GetPeriodLabels() const;
+
+    /**
+     * \brief Returns relative up and down variations in the prefiring weight for given period
+     *
+     * The pointed-to values are updated in each event and stay valid until the next call to
+     * BeginRun. Only meaningful if a prefiring plugin has been specified.
+     */
+    Float_t const *GetPrefiringWeightSyst(std::string const &periodLabel) const;
+
+    /**
+     * \brief Returns a reference to the nominal weight for given period
+     *
+     * Same comments as for GetPrefiringWeightSyst apply.
+     */
+    Float_t const &GetWeight(std::string const &periodLabel) const;
+
+    /// Checks if prefiring weights are evaluated
+    bool HasPrefiringWeights() const
+    {
+        return not prefiringPluginName.empty();
+    }
+
+    /// Changes name of TFileService
+    void SetFileServiceName(std::string const &name);
+
     /// Specifies name of L1TPrefiringWeights plugin
     void SetPrefiringWeightPlugin(std::string const &name);
 
+    /**
+     * \brief Requests that variables are written into the tree of the given SharedTree plugin
+     * 
+     * Then the tree name set with SetTreeName is ignored, and the shared tree is filled by a
+     * SharedTreeFiller rather than by this plugin.
+     */
+    void SetSharedTreeName(std::string const &name);
+    
     /**
      * \brief Specifies the name for the output tree
      * 
@@ -106,6 +170,21 @@ private:
     /// Fills map \ref periods
     void ConstructPeriods();
 
+    /// Returns period with the given label or throws an exception if it does not exist
+    Period const &FindPeriod(std::string const &periodLabel, std::string const &caller) const;
+
+    /**
+     * \brief Returns ratio table for the given profiles in simulation and data
+     *
+     * The paths are resolved in the same way as in ReadProfile.
+     */
+    std::shared_ptr<PileUpRatioTable const> GetRatioTable(std::filesystem::path const &simProfile,
+      std::filesystem::path const &dataProfile);
+
+    /// Builds a new ratio table for the given profiles
+    std::shared_ptr<PileUpRatioTable const> BuildRatioTable(
+      std::filesystem::path const &simProfile, std::filesystem::path const &dataProfile);
+
     /**
      * \brief Computes variables and fills the output tree
      * 
@@ -122,8 +201,8 @@ private:
     TH1 *ReadProfile(std::filesystem::path path);
     
 private:
-    /// Parsed configuration
-    Config config;
+    /// Parsed configuration, obtained from SharedResources
+    std::shared_ptr<Config const> config;
 
     /// Directory with pileup profiles
     std::filesystem::path profilesDir;
@@ -158,15 +237,12 @@ private:
     
     /// Name of the output tree and its in-file directory
     std::string treeName, directoryName;
-
-    /**
-     * \brief Pileup profile in simulation for current data set
-     *
-     * Normalized to a unit integral.
-     */
-    std::unique_ptr<TH1> simPileupProfile;
+    
+    /// Name of a SharedTree plugin whose tree is used, or an empty string for a dedicated tree
+    std::string sharedTreeName;
     
     /// Non-owning pointer to output tree
     TTree *tree;
+
 };
 
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <mensura/Service.hpp>
+
+#include <chrono>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+/**
+ * \class PluginStatsService
+ * \brief Collects wall and CPU time and event counts for individual plugins
+ *
+ * The measurements are done by pairs of TimingProbe plugins placed immediately before and after
+ * each instrumented plugin. The first probe calls method Start, and the second one calls Stop if
+ * the plugin has accepted the event. If the plugin rejects the event, the second probe is not
+ * executed, and the time interval is closed only when the next instrumented plugin starts, which
+ * normally happens in the next event, or at the end of the dataset. The time attributed to
+ * rejected events therefore also includes the overhead of the framework between the two events,
+ * as well as any plugins that are not instrumented and run before the next instrumented one. To
+ * make this visible, time in rejected events is additionally reported separately, and the JSON
+ * file contains a note about it. Time spent in plugins that are not instrumented is otherwise not
+ * recorded. CPU time is measured for the current thread.
+ *
+ * Each thread uses its own clone of the service. At the end of each dataset, the clone adds its
+ * measurements to a summary shared among all clones, which can be written to a JSON file with
+ * method WriteJSON after the processing has finished.
+ */
+class PluginStatsService: public Service
+{
+private:
+    /// Measurements for a single plugin
+    struct Record
+    {
+        /// Name of the plugin
+        std::string name;
+
+        /// Number of events processed by the plugin and the number of accepted events
+        unsigned long numEvents, numAccepted;
+
+        /// Accumulated wall and CPU time, in seconds
+        double wallTime, cpuTime;
+
+        /// Part of the wall and CPU time accumulated in events rejected by the plugin
+        double rejectedWallTime, rejectedCpuTime;
+    };
+
+    /// Summary shared among all clones
+    struct Summary
+    {
+        /// Mutex to protect the summary
+        std::mutex mutex;
+
+        /// Number of threads for which indices have been assigned
+        unsigned numThreads = 0;
+
+        /// Measurements for each thread
+        std::map<unsigned, std::vector<Record>> threadRecords;
+    };
+
+    /// Point in time, in terms of wall and CPU time
+    struct TimePoint
+    {
+        std::chrono::steady_clock::time_point wall;
+        double cpu;
+    };
+
+public:
+    /// Creates a service with the given name
+    PluginStatsService(std::string const &name = "PluginStats");
+
+public:
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * The clone shares the summary with this service but gets its own measurements.
+     *
+     * Implemented from Service.
+     */
+    virtual PluginStatsService *Clone() const override;
+
+    /**
+     * \brief Closes an unfinished time interval and adds measurements to the shared summary
+     *
+     * Reimplemented from Service.
+     */
+    virtual void EndRun() override;
+
+    /**
+     * \brief Registers a plugin to be instrumented
+     *
+     * Returns an index to be given to methods Start and Stop. Repeated calls with the same name
+     * return the same index.
+     */
+    unsigned RegisterPlugin(std::string const &pluginName) const;
+
+    /// Notifies that the plugin with the given index is about to process an event
+    void Start(unsigned index) const;
+
+    /// Notifies that the plugin with the given index has accepted the current event
+    void Stop(unsigned index) const;
+
+    /**
+     * \brief Writes the summary into a JSON file
+     *
+     * The file contains measurements for each thread and their sum over all threads, together
+     * with a note on how time in rejected events is measured. Must be called after the processing
+     * has finished.
+     */
+    void WriteJSON(std::string const &path) const;
+
+private:
+    /// Closes the current time interval and attributes it to the running plugin
+    void CloseInterval(bool accepted) const;
+
+    /// Returns the current point in time
+    static TimePoint Now();
+
+    /// Writes the given measurements as a JSON array
+    static void WriteJSONRecords(std::ostream &out, std::vector<Record> const &records,
+      std::string const &indent);
+
+private:
+    /// Shared summary
+    std::shared_ptr<Summary> summary;
+
+    /// Index of the thread that uses this clone, or -1 if not assigned yet
+    mutable int threadIndex;
+
+    /// Measurements for instrumented plugins since the last call to EndRun
+    mutable std::vector<Record> records;
+
+    /// Index of the plugin that is currently running, or -1 if there is none
+    mutable int runningIndex;
+
+    /// Start of the current time interval
+    mutable TimePoint startTime;
+};
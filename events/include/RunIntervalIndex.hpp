@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+/**
+ * \class RunIntervalIndex
+ * \brief Maps non-overlapping intervals of runs to payloads of type T
+ *
+ * Intervals are kept sorted, and the interval that contains a given run is found with a binary
+ * search. The last interval found, or the gap between intervals, is remembered, so that lookups
+ * for consecutive events from the same run only require two comparisons. Because of this cache,
+ * lookups in the same object must not be done concurrently from different threads. Each thread
+ * should use its own copy, as is the case for data members of cloned plugins and services.
+ */
+template<typename T>
+class RunIntervalIndex
+{
+public:
+    /// An interval of runs with its payload
+    struct Interval
+    {
+        /// Range of runs, inclusive
+        unsigned long minRun, maxRun;
+
+        /// Payload associated with the interval
+        T payload;
+    };
+
+public:
+    /// Constructs an empty index
+    RunIntervalIndex();
+
+public:
+    /**
+     * \brief Adds a new interval and returns a reference to its payload
+     *
+     * The range of runs is inclusive. Throws an exception if it overlaps with a previously added
+     * interval. Invalidates references and pointers to other payloads.
+     */
+    T &Add(unsigned long minRun, unsigned long maxRun, T payload);
+
+    /// Iterators over intervals, sorted in runs
+    typename std::vector<Interval>::iterator begin()
+    {
+        return intervals.begin();
+    }
+
+    typename std::vector<Interval>::const_iterator begin() const
+    {
+        return intervals.begin();
+    }
+
+    typename std::vector<Interval>::iterator end()
+    {
+        return intervals.end();
+    }
+
+    typename std::vector<Interval>::const_iterator end() const
+    {
+        return intervals.end();
+    }
+
+    /// Removes all intervals
+    void Clear();
+
+    /**
+     * \brief Returns payload of the interval that contains the given run
+     *
+     * Returns a null pointer if there is no such interval.
+     */
+    T const *Find(unsigned long run) const;
+
+    /// Returns the interval that overlaps with the given range of runs, or null if there is none
+    Interval const *FindOverlap(unsigned long minRun, unsigned long maxRun) const;
+
+    /// Checks if the index contains no intervals
+    bool IsEmpty() const
+    {
+        return intervals.empty();
+    }
+
+private:
+    /// Value of \ref cachedIndex that denotes a gap between intervals
+    static constexpr std::size_t gap = std::numeric_limits<std::size_t>::max();
+
+    /// Intervals sorted in runs
+    std::vector<Interval> intervals;
+
+    /**
+     * \brief Range of runs found in the last lookup, inclusive
+     *
+     * This is either one of the intervals or a gap between them. The range is empty initially.
+     */
+    mutable unsigned long cachedMinRun, cachedMaxRun;
+
+    /**
+     * \brief Index of the interval found in the last lookup
+     *
+     * An index rather than a pointer is stored so that copies of this object remain valid.
+     */
+    mutable std::size_t cachedIndex;
+};
+
+
+template<typename T>
+RunIntervalIndex<T>::RunIntervalIndex():
+    cachedMinRun{1}, cachedMaxRun{0}, cachedIndex{gap}
+{}
+
+
+template<typename T>
+T &RunIntervalIndex<T>::Add(unsigned long minRun, unsigned long maxRun, T payload)
+{
+    if (auto const *overlap = FindOverlap(minRun, maxRun))
+    {
+        std::ostringstream message;
+        message << "RunIntervalIndex::Add: Interval [" << minRun << ", " << maxRun <<
+          "] overlaps with interval [" << overlap->minRun << ", " << overlap->maxRun << "].";
+        throw std::runtime_error(message.str());
+    }
+
+    auto const pos = std::upper_bound(intervals.begin(), intervals.end(), minRun,
+      [](unsigned long run, Interval const &interval){return run < interval.minRun;});
+    auto const inserted = intervals.insert(pos, Interval{minRun, maxRun, std::move(payload)});
+
+    cachedMinRun = 1;
+    cachedMaxRun = 0;
+    return inserted->payload;
+}
+
+
+template<typename T>
+void RunIntervalIndex<T>::Clear()
+{
+    intervals.clear();
+    cachedMinRun = 1;
+    cachedMaxRun = 0;
+}
+
+
+template<typename T>
+T const *RunIntervalIndex<T>::Find(unsigned long run) const
+{
+    if (run < cachedMinRun or run > cachedMaxRun)
+    {
+        // Find the first interval that starts after the given run. The run can only be contained
+        //in the preceding one. Otherwise it falls into the gap between them.
+        auto const next = std::upper_bound(intervals.begin(), intervals.end(), run,
+          [](unsigned long r, Interval const &interval){return r < interval.minRun;});
+
+        if (next != intervals.begin() and run <= (next - 1)->maxRun)
+        {
+            cachedMinRun = (next - 1)->minRun;
+            cachedMaxRun = (next - 1)->maxRun;
+            cachedIndex = next - 1 - intervals.begin();
+        }
+        else
+        {
+            cachedMinRun = (next == intervals.begin()) ? 0 : (next - 1)->maxRun + 1;
+            cachedMaxRun = (next == intervals.end()) ?
+              std::numeric_limits<unsigned long>::max() : next->minRun - 1;
+            cachedIndex = gap;
+        }
+    }
+
+    return (cachedIndex == gap) ? nullptr : &intervals[cachedIndex].payload;
+}
+
+
+template<typename T>
+typename RunIntervalIndex<T>::Interval const *RunIntervalIndex<T>::FindOverlap(
+  unsigned long minRun, unsigned long maxRun) const
+{
+    for (auto const &interval: intervals)
+    {
+        if (minRun <= interval.maxRun and maxRun >= interval.minRun)
+            return &interval;
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+
+
+class Config;
+class TH1;
+
+
+/**
+ * \class SharedResources
+ * \brief Process-wide cache of read-only configuration objects, histograms, and tables derived
+ * from them
+ *
+ * Plugins that are instantiated for several triggers or systematic variations, and their clones
+ * in different threads, often need the same configuration files and histograms. This class reads
+ * each of them only once and hands out shared pointers to constant objects. The cache only keeps
+ * weak references, so a resource is released when the last object that uses it is destroyed, and
+ * it is read again if requested after that. A plugin that needs a resource throughout its life
+ * should therefore keep the returned pointer as a data member, which also makes its clones share
+ * the resource.
+ *
+ * All methods are thread-safe. Builders given to method Get may request other resources.
+ */
+class SharedResources
+{
+public:
+    /**
+     * \brief Returns an object of type T identified by the given key
+     *
+     * If the object is not in the cache, it is constructed by calling the given builder, which
+     * must return a pointer convertible to std::shared_ptr<T const>. A null pointer returned by
+     * the builder is passed to the caller and not cached. Objects of different types are cached
+     * independently.
+     */
+    template<typename T, typename Builder>
+    static std::shared_ptr<T const> Get(std::string const &key, Builder build);
+
+    /**
+     * \brief Returns parsed JSON configuration from the given file
+     *
+     * The path is interpreted in the same way as by the constructor of Config. Exceptions thrown by
+     * the latter are propagated.
+     */
+    static std::shared_ptr<Config const> GetConfig(std::string const &path);
+
+    /**
+     * \brief Returns histogram with the given in-file path from the given ROOT file
+     *
+     * The path to the file must have been resolved by the caller. The histogram is detached from
+     * the file. Returns a null pointer if the file cannot be opened or does not contain a histogram
+     * with the given name.
+     */
+    static std::shared_ptr<TH1 const> GetHistogram(std::string const &path,
+      std::string const &inFilePath);
+
+private:
+    /// Mutex that protects the cache
+    static std::recursive_mutex mutex;
+
+    /// Cached objects, indexed with the names of their types and keys
+    static std::map<std::string, std::weak_ptr<void const>> objects;
+};
+
+
+template<typename T, typename Builder>
+std::shared_ptr<T const> SharedResources::Get(std::string const &key, Builder build)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    // References to elements of std::map remain valid if the builder adds new elements
+    auto &entry = objects[std::string{typeid(T).name()} + ':' + key];
+    auto object = std::static_pointer_cast<T const>(entry.lock());
+
+    if (not object)
+    {
+        object = build();
+        entry = object;
+    }
+
+    return object;
+}
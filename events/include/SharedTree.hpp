@@ -0,0 +1,80 @@
+#pragma once
+
+#include <mensura/AnalysisPlugin.hpp>
+
+#include <string>
+
+
+class TFileService;
+class TTree;
+
+
+/**
+ * \class SharedTree
+ * \brief Creates an output tree into which several plugins write their variables
+ *
+ * By default, each plugin that produces variables for a trigger bin (BalanceVars, PileUpVars,
+ * etc.) writes them into its own tree, and the trees have to be read as friends. Instead, such
+ * plugins can be told to add their branches to the tree created by this plugin (see their methods
+ * SetSharedTreeName), which results in a single tree per trigger bin. Branches from each producer
+ * are kept together, in the order in which the producers are registered.
+ *
+ * This plugin must be placed before all producers that use its tree, and a SharedTreeFiller must
+ * be placed after them to fill the tree once per event. The tree is created with OutputTree.
+ */
+class SharedTree: public AnalysisPlugin
+{
+public:
+    /**
+     * \brief Constructor
+     *
+     * \param name  Name for the plugin.
+     * \param treeName  Name of the tree. It can include name of an in-file directory.
+     */
+    SharedTree(std::string const &name, std::string const &treeName);
+
+public:
+    /**
+     * \brief Creates the tree
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void BeginRun(Dataset const &) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Plugin.
+     */
+    virtual SharedTree *Clone() const override;
+
+    /// Returns the tree for the current dataset
+    TTree *GetTree() const
+    {
+        return tree;
+    }
+
+    /// Changes name of TFileService
+    void SetFileServiceName(std::string const &name);
+
+private:
+    /**
+     * \brief Does nothing
+     *
+     * Implemented from Plugin.
+     */
+    virtual bool ProcessEvent() override;
+
+private:
+    /// Name of TFileService
+    std::string fileServiceName;
+
+    /// Non-owning pointer to TFileService
+    TFileService const *fileService;
+
+    /// Name of the tree and its in-file directory
+    std::string treeName, directoryName;
+
+    /// Non-owning pointer to the tree
+    TTree *tree;
+};
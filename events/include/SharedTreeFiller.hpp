@@ -0,0 +1,52 @@
+#pragma once
+
+#include <mensura/AnalysisPlugin.hpp>
+
+#include <string>
+
+
+class SharedTree;
+
+
+/**
+ * \class SharedTreeFiller
+ * \brief Fills the tree of a SharedTree plugin
+ *
+ * Must be placed after all plugins that write into the tree. It never rejects events.
+ */
+class SharedTreeFiller: public AnalysisPlugin
+{
+public:
+    /// Constructs a plugin that fills the tree of the SharedTree with the given name
+    SharedTreeFiller(std::string const &name, std::string const &sharedTreeName);
+
+public:
+    /**
+     * \brief Saves pointer to the SharedTree plugin
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void BeginRun(Dataset const &) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Plugin.
+     */
+    virtual SharedTreeFiller *Clone() const override;
+
+private:
+    /**
+     * \brief Fills the tree
+     *
+     * Implemented from Plugin.
+     */
+    virtual bool ProcessEvent() override;
+
+private:
+    /// Name of the SharedTree plugin
+    std::string sharedTreeName;
+
+    /// Non-owning pointer to the SharedTree plugin
+    SharedTree const *sharedTree;
+};
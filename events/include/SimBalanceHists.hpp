@@ -0,0 +1,151 @@
+#pragma once
+
+#include <mensura/AnalysisPlugin.hpp>
+
+#include <TProfile.h>
+
+#include <string>
+#include <vector>
+
+
+class BalanceCalc;
+class GenWeights;
+class JetBlock;
+class PeriodWeights;
+class TFileService;
+
+
+/**
+ * \class SimBalanceHists
+ * \brief Produces weighted profiles of balance observables in simulation
+ *
+ * This is a counterpart of BalanceHists for simulation. It fills profiles of ptlead, pt balance,
+ * and MPF versus ptlead for each data-taking period defined in the PeriodWeights plugin. Events are
+ * weighted with the product of the nominal generator-level weight from GenWeights and the weight
+ * for the period. If available, the profiles are also filled for up and down variations in the ME
+ * renormalization and factorization scales and the L1T prefiring weight, which are applied on top
+ * of the nominal weights.
+ *
+ * Profiles are named "PtLeadProfile_<period>", "PtBalProfile_<period>", and "MPFProfile_<period>",
+ * with suffixes "_MERenormUp", "_MERenormDown", "_MEFactUp", "_MEFactDown", "_L1TPrefiringUp", and
+ * "_L1TPrefiringDown" for the variations. They store the sums of squared weights, so that
+ * neighbouring bins can be merged exactly.
+ *
+ * The GenWeights and PeriodWeights plugins must precede this one in the path.
+ */
+class SimBalanceHists: public AnalysisPlugin
+{
+private:
+    /// Profiles filled with a single choice of event weight
+    struct HistSet
+    {
+        /// Weight for the period
+        Float_t const *periodWeight;
+
+        /**
+         * \brief Relative variation applied on top of the nominal weight
+         *
+         * Null for the nominal weight.
+         */
+        Float_t const *variation;
+
+        /// Profiles of ptlead, pt balance, and MPF versus ptlead
+        TProfile *profPtLead, *profPtBal, *profMPF;
+    };
+
+public:
+    /// Constructs a plugin with the given name
+    SimBalanceHists(std::string const &name = "SimBalanceHists");
+
+public:
+    /**
+     * \brief Saves pointers to required plugins and services and creates profiles
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void BeginRun(Dataset const &) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Plugin.
+     */
+    virtual SimBalanceHists *Clone() const override;
+
+    /// Changes name of the plugin that computes balance observables
+    void SetBalanceCalcName(std::string const &name);
+
+    /// Sets binning in ptlead
+    void SetBinningPtLead(std::vector<double> const &binning);
+
+    /**
+     * \brief Specifies name for the output in-file directory
+     *
+     * By default the name of the plugin is used.
+     */
+    void SetDirectoryName(std::string const &name);
+
+    /// Changes name of TFileService
+    void SetFileServiceName(std::string const &name);
+
+    /// Changes name of the GenWeights plugin
+    void SetGenWeightsName(std::string const &name);
+
+    /// Changes name of the plugin that provides jets and MET
+    void SetJetMETPluginName(std::string const &name);
+
+    /// Changes name of the PeriodWeights plugin
+    void SetPeriodWeightsName(std::string const &name);
+
+private:
+    /// Creates profiles for the given period and variation and adds them to \ref histSets
+    void BookHists(std::string const &period, std::string const &variationLabel,
+      Float_t const *variation);
+
+    /**
+     * \brief Fills profiles
+     *
+     * Implemented from Plugin.
+     */
+    virtual bool ProcessEvent() override;
+
+private:
+    /// Name of TFileService
+    std::string fileServiceName;
+
+    /// Non-owning pointer to TFileService
+    TFileService const *fileService;
+
+    /// Name of a plugin that produces jets and MET
+    std::string jetmetPluginName;
+
+    /// Non-owning pointer to jets in the columnar layout
+    JetBlock const *jetBlock;
+
+    /// Name of a plugin that computes balance observables
+    std::string balanceCalcName;
+
+    /// Non-owning pointer to a plugin that computes balance observables
+    BalanceCalc const *balanceCalc;
+
+    /// Name of the GenWeights plugin
+    std::string genWeightsName;
+
+    /// Non-owning pointer to the GenWeights plugin
+    GenWeights const *genWeights;
+
+    /// Name of the PeriodWeights plugin
+    std::string periodWeightsName;
+
+    /// Non-owning pointer to the PeriodWeights plugin
+    PeriodWeights const *periodWeights;
+
+    /// Name for the output directory
+    std::string outDirectoryName;
+
+    /// Binning in ptlead
+    std::vector<double> ptLeadBinning;
+
+    /// Profiles for all periods and weight variations
+    std::vector<HistSet> histSets;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+
+/**
+ * \class SkimCache
+ * \brief Definitions shared by the writer and the readers of skim cache files
+ *
+ * A skim cache file contains events from a single input file that have passed the event selection
+ * up to the point where SkimCacheWriter is placed in the path. For each event it stores
+ * everything that the downstream plugins need in real data: event ID, pileup information,
+ * corrected jets and MET, and flags showing whether the leading jet is matched to trigger objects
+ * for a number of trigger filters. Subsequent runs can replay events from it with the help of
+ * SkimCacheReader, SkimCacheJetMETReader, and SkimCachePileUpReader, which avoids reading the
+ * input files and reevaluating jet corrections.
+ *
+ * The name of a cache file is built from a hash of a configuration key, the ID of the data set, and
+ * the path, size, and modification time of the input file. The data set ID is included because the
+ * same file can be read partially as a part of several data sets. The configuration key must
+ * reflect everything that affects the content of the cache. Files are written as a header followed
+ * by a sequence of event records. Numbers are stored in the native binary representation, so cache
+ * files are not portable between architectures.
+ */
+class SkimCache
+{
+public:
+    /// Returns FNV-1a hash of the given string, continuing from the given hash value
+    static std::uint64_t Hash(std::string const &text, std::uint64_t seed = hashSeed);
+
+    /**
+     * \brief Returns hash of the content of the given file, continuing from the given hash value
+     *
+     * Throws an exception if the file cannot be read.
+     */
+    static std::uint64_t HashFile(std::string const &path, std::uint64_t seed = hashSeed);
+
+    /// Returns the path of the cache file for the given input file in the given data set
+    static std::string GetPath(std::string const &directory, std::uint64_t configKey,
+      std::string const &datasetID, std::string const &inputPath);
+
+public:
+    /// Initial value for the hash function
+    static constexpr std::uint64_t hashSeed = 0xcbf29ce484222325ULL;
+
+    /// Marker at the start of each cache file
+    static constexpr char magic[8] = {'M', 'J', 'S', 'K', 'I', 'M', '\0', '\0'};
+
+    /**
+     * \brief Version of the file format
+     *
+     * Must be increased whenever the format or the content of cached events changes.
+     */
+    static constexpr std::uint32_t formatVersion = 1;
+
+    /// Maximal number of trigger filters whose matching flags can be stored
+    static constexpr unsigned maxTriggerFilters = 64;
+};
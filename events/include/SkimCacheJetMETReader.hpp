@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JetBlock.hpp>
+
+#include <mensura/JetMETReader.hpp>
+
+#include <string>
+
+
+class SkimCacheReader;
+
+
+/**
+ * \class SkimCacheJetMETReader
+ * \brief Provides jets and MET replayed from a skim cache
+ *
+ * Jets and MET are taken from a SkimCacheReader with a default name "InputData". They are the
+ * fully corrected ones, as produced by the JetMETReader that was used when the cache was written.
+ * The corrected MET and the raw one are both provided. The standard collection of jets is filled
+ * from the cached JetBlock unless this is disabled with method SetFillStandardJets.
+ */
+class SkimCacheJetMETReader: public JetMETReader, public JetBlockProvider
+{
+public:
+    /// Creates plugin with the given name
+    SkimCacheJetMETReader(std::string const &name = "JetMET");
+
+public:
+    /**
+     * \brief Saves pointer to the SkimCacheReader
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void BeginRun(Dataset const &) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Plugin.
+     */
+    virtual SkimCacheJetMETReader *Clone() const override;
+
+    /**
+     * \brief Returns jets in the current event in the columnar layout
+     *
+     * Implemented from JetBlockProvider.
+     */
+    virtual JetBlock const &GetJetBlock() const override;
+
+    /**
+     * \brief Returns jet radius recorded in the cache
+     *
+     * Implemented from JetMETReader.
+     */
+    virtual double GetJetRadius() const override;
+
+private:
+    /**
+     * \brief Copies jets and MET of the current event from the SkimCacheReader
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual bool ProcessEvent() override;
+
+private:
+    /// Non-owning pointer to and name of the plugin that reads the cache
+    SkimCacheReader const *cachePlugin;
+    std::string cachePluginName;
+};
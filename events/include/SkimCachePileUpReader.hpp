@@ -0,0 +1,52 @@
+#pragma once
+
+#include <mensura/PileUpReader.hpp>
+
+#include <string>
+
+
+class SkimCacheReader;
+
+
+/**
+ * \class SkimCachePileUpReader
+ * \brief Provides pileup information replayed from a skim cache
+ *
+ * The number of primary vertices and rho are taken from a SkimCacheReader with a default name
+ * "InputData". The expected pileup is not stored in the cache since it is only defined in
+ * simulation, and it is set to zero.
+ */
+class SkimCachePileUpReader: public PileUpReader
+{
+public:
+    /// Creates plugin with the given name
+    SkimCachePileUpReader(std::string const &name = "PileUp");
+
+public:
+    /**
+     * \brief Saves pointer to the SkimCacheReader
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void BeginRun(Dataset const &) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Plugin.
+     */
+    virtual SkimCachePileUpReader *Clone() const override;
+
+private:
+    /**
+     * \brief Copies pileup information of the current event from the SkimCacheReader
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual bool ProcessEvent() override;
+
+private:
+    /// Non-owning pointer to and name of the plugin that reads the cache
+    SkimCacheReader const *cachePlugin;
+    std::string cachePluginName;
+};
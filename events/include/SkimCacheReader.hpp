@@ -0,0 +1,171 @@
+#pragma once
+
+#include <JetBlock.hpp>
+
+#include <mensura/EventIDReader.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+/**
+ * \class SkimCacheReader
+ * \brief Reads events from skim cache files
+ *
+ * This plugin replaces the reader of input files when events are replayed from skim cache files
+ * written by SkimCacheWriter. For each input file in a dataset, it opens the corresponding cache
+ * file and reads events from it. It provides event ID directly, and the rest of the content of
+ * the cache is exposed to dedicated plugins SkimCacheJetMETReader and SkimCachePileUpReader and
+ * to LeadJetTriggerFilter. An exception is thrown if the cache file is missing or has been written
+ * with a different configuration.
+ */
+class SkimCacheReader: public EventIDReader
+{
+public:
+    /**
+     * \brief Constructor
+     *
+     * The directory and the configuration key must be the same as given to the SkimCacheWriter
+     * that produced the cache. User is encouraged to keep the default name "InputData" so that
+     * the plugin is found by plugins that need event ID.
+     */
+    SkimCacheReader(std::string const &name, std::string const &directory,
+      std::uint64_t configKey);
+
+    /// Copy constructor that does not copy the state of the input file
+    SkimCacheReader(SkimCacheReader const &src);
+
+public:
+    /**
+     * \brief Opens the cache file for the current input file and checks its header
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void BeginRun(Dataset const &dataset) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Plugin.
+     */
+    virtual SkimCacheReader *Clone() const override;
+
+    /**
+     * \brief Closes the cache file
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void EndRun() override;
+
+    /**
+     * \brief Returns the index of the given trigger filter in the cache
+     *
+     * Throws an exception if the filter is not stored in the cache.
+     */
+    unsigned GetFilterIndex(std::string const &filter) const;
+
+    /// Returns jets in the current event
+    JetBlock const &GetJetBlock() const
+    {
+        return jetBlock;
+    }
+
+    /// Returns the jet radius recorded in the cache
+    double GetJetRadius() const
+    {
+        return jetRadius;
+    }
+
+    /// Returns pt and phi of the corrected missing pt in the current event
+    double GetMETPt() const
+    {
+        return metPt;
+    }
+
+    double GetMETPhi() const
+    {
+        return metPhi;
+    }
+
+    /// Returns the number of reconstructed primary vertices in the current event
+    unsigned GetNumVertices() const
+    {
+        return numVertices;
+    }
+
+    /// Returns pt and phi of the raw missing pt in the current event
+    double GetRawMETPt() const
+    {
+        return rawMETPt;
+    }
+
+    double GetRawMETPhi() const
+    {
+        return rawMETPhi;
+    }
+
+    /// Returns rho in the current event
+    double GetRho() const
+    {
+        return rho;
+    }
+
+    /// Checks if the leading jet is matched to a trigger object for the given filter
+    bool IsTriggerMatched(unsigned filterIndex) const
+    {
+        return (triggerBits >> filterIndex) & 1;
+    }
+
+private:
+    /**
+     * \brief Reads the next event from the cache file
+     *
+     * Returns false when there are no more events in the file.
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual bool ProcessEvent() override;
+
+    /// Reads binary representation of a value
+    template<typename T>
+    void Read(T &value);
+
+    /// Reads binary representation of an array of the given size
+    template<typename T>
+    void ReadArray(std::vector<T> &values, std::size_t size);
+
+    /// Throws an exception reporting that the current cache file is malformed
+    [[noreturn]] void ReportCorruptedFile(std::string const &reason) const;
+
+private:
+    /// Directory with cache files
+    std::string directory;
+
+    /// Hash of the configuration
+    std::uint64_t configKey;
+
+    /// Path to and stream for the current cache file
+    std::string path;
+    std::ifstream file;
+
+    /// Jet radius recorded in the cache
+    double jetRadius;
+
+    /// Names of trigger filters stored in the cache
+    std::vector<std::string> triggerFilters;
+
+    /// Properties of the current event
+    unsigned numVertices;
+    double rho;
+    double metPt, metPhi, rawMETPt, rawMETPhi;
+    std::uint64_t triggerBits;
+
+    /// Jets in the current event
+    JetBlock jetBlock;
+
+    /// Buffers to read properties of jets
+    std::vector<double> pt, eta, phi, mass, area, rawFactor;
+    std::vector<std::uint8_t> id;
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <mensura/AnalysisPlugin.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+class EventIDReader;
+class JetBlock;
+class JetMETReader;
+class PECTriggerObjectReader;
+class PileUpReader;
+
+
+/**
+ * \class SkimCacheWriter
+ * \brief Writes events that reach this plugin into a skim cache file
+ *
+ * The format of the file is described in the documentation for class SkimCache. A separate cache
+ * file is written for each input file. It is first written under a temporary name and only
+ * renamed when the input file has been processed fully, so that an interrupted job does not leave
+ * behind an incomplete cache.
+ *
+ * For each of the given trigger filters, the plugin checks if the leading jet is matched to a
+ * trigger object, using the same criterion as LeadJetTriggerFilter, and stores the result.
+ *
+ * This plugin relies on the presence of an EventIDReader with a default name "InputData", a
+ * PileUpReader with a default name "PileUp", a JetMETReader with a default name "JetMET", which
+ * must implement JetBlockProvider, and a PECTriggerObjectReader with a default name
+ * "TriggerObjects". It never rejects events.
+ */
+class SkimCacheWriter: public AnalysisPlugin
+{
+public:
+    /**
+     * \brief Constructor
+     *
+     * \param name  Name for the plugin.
+     * \param directory  Directory in which cache files are written. It must exist.
+     * \param configKey  Hash of the configuration that affects the content of the cache.
+     * \param triggerFilters  Names of trigger filters for which matching flags are stored.
+     */
+    SkimCacheWriter(std::string const &name, std::string const &directory,
+      std::uint64_t configKey, std::vector<std::string> const &triggerFilters);
+
+    /// Copy constructor that does not copy the state of the output file
+    SkimCacheWriter(SkimCacheWriter const &src);
+
+public:
+    /**
+     * \brief Saves pointers to dependencies and opens a new cache file
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void BeginRun(Dataset const &dataset) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Plugin.
+     */
+    virtual SkimCacheWriter *Clone() const override;
+
+    /**
+     * \brief Closes the cache file and gives it the final name
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void EndRun() override;
+
+    /// Specifies name of the plugin that provides jets and MET
+    void SetJetMETPluginName(std::string const &name);
+
+private:
+    /**
+     * \brief Writes the current event into the cache file
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual bool ProcessEvent() override;
+
+    /// Writes binary representation of the given value
+    template<typename T>
+    void Write(T const &value);
+
+    /// Writes binary representation of the given array
+    template<typename T>
+    void WriteArray(std::vector<T> const &values);
+
+private:
+    /// Directory for cache files
+    std::string directory;
+
+    /// Hash of the configuration
+    std::uint64_t configKey;
+
+    /// Names of trigger filters for which matching is checked
+    std::vector<std::string> triggerFilters;
+
+    /// Indices of the trigger filters in the PECTriggerObjectReader
+    std::vector<unsigned> triggerFilterIndices;
+
+    /// Non-owning pointers to and names of plugins that provide content of the cache
+    EventIDReader const *eventIDPlugin;
+    std::string eventIDPluginName;
+
+    PileUpReader const *puPlugin;
+    std::string puPluginName;
+
+    JetMETReader const *jetmetPlugin;
+    std::string jetmetPluginName;
+
+    JetBlock const *jetBlock;
+
+    PECTriggerObjectReader const *triggerObjectsPlugin;
+    std::string triggerObjectsPluginName;
+
+    /// Final and temporary paths of the current cache file
+    std::string path, tmpPath;
+
+    /// Current cache file
+    std::ofstream file;
+};
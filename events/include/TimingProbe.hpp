@@ -0,0 +1,81 @@
+#pragma once
+
+#include <mensura/AnalysisPlugin.hpp>
+
+#include <string>
+
+
+class PluginStatsService;
+
+
+/**
+ * \class TimingProbe
+ * \brief Reports the start or the end of the processing of an event by another plugin
+ *
+ * A pair of probes is placed around an instrumented plugin: one in mode Start before it and
+ * another one in mode Stop after it. They forward the notifications to a PluginStatsService with
+ * a default name "PluginStats". The probe never rejects events, so it does not change the event
+ * selection when the plugins that follow it depend on it instead of the instrumented plugin.
+ */
+class TimingProbe: public AnalysisPlugin
+{
+public:
+    /// Position of the probe with respect to the instrumented plugin
+    enum class Mode
+    {
+        Start,
+        Stop
+    };
+
+public:
+    /**
+     * \brief Constructor
+     *
+     * \param name  Name for the probe.
+     * \param targetName  Name of the instrumented plugin.
+     * \param mode  Position of the probe with respect to the instrumented plugin.
+     */
+    TimingProbe(std::string const &name, std::string const &targetName, Mode mode);
+
+public:
+    /**
+     * \brief Saves pointer to the PluginStatsService and registers the instrumented plugin
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void BeginRun(Dataset const &) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Plugin.
+     */
+    virtual TimingProbe *Clone() const override;
+
+    /// Changes name of the PluginStatsService
+    void SetStatsServiceName(std::string const &name);
+
+private:
+    /**
+     * \brief Notifies the PluginStatsService
+     *
+     * Implemented from Plugin.
+     */
+    virtual bool ProcessEvent() override;
+
+private:
+    /// Name of the instrumented plugin
+    std::string targetName;
+
+    /// Position of the probe
+    Mode mode;
+
+    /// Name of the PluginStatsService
+    std::string statsServiceName;
+
+    /// Non-owning pointer to the PluginStatsService
+    PluginStatsService const *statsService;
+
+    /// Index of the instrumented plugin in the PluginStatsService
+    unsigned targetIndex;
+};
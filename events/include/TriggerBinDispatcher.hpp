@@ -0,0 +1,155 @@
+#pragma once
+
+#include <mensura/AnalysisPlugin.hpp>
+
+#include <string>
+#include <vector>
+
+
+class JetBlock;
+class JetMETReader;
+class PECTriggerObjectReader;
+class SkimCacheReader;
+
+
+/**
+ * \class TriggerBinDispatcher
+ * \brief Assigns events to trigger bins based on the leading jet
+ *
+ * This plugin implements the same selection as LeadJetTriggerFilter but for all trigger bins at
+ * once. It reads the configuration file described in the documentation for LeadJetTriggerFilter.
+ * Bins are sorted in the lower boundary of their pt ranges, and for each event candidate bins are
+ * found with a binary search in pt of the leading jet. Matching to trigger objects is only
+ * performed for these candidates. Since the ranges do not overlap, or only overlap for adjacent
+ * bins, this is at most two bins per event regardless of the total number of bins.
+ *
+ * Results are exposed with method IsAccepted. Per-bin event paths are started with light-weight
+ * TriggerBinGate plugins, which only look up the corresponding flag. The dispatcher itself rejects
+ * events that do not fall into any bin.
+ *
+ * Trigger objects are read from a PECTriggerObjectReader with a default name "TriggerObjects" or,
+ * when events are replayed from a skim cache, from a SkimCacheReader. Jets are read from a
+ * JetMETReader with a default name "JetMET", which must implement JetBlockProvider.
+ */
+class TriggerBinDispatcher: public AnalysisPlugin
+{
+private:
+    /// Selection for a single trigger bin
+    struct Bin
+    {
+        /// Name of the trigger
+        std::string triggerName;
+
+        /// Name of the trigger filter
+        std::string filter;
+
+        /// Allowed range of pt of the leading jet
+        double minPt, maxPt;
+
+        /// Largest upper boundary among this bin and all bins preceding it in the sorted order
+        double reachPt;
+
+        /// Cached index of the trigger filter in the plugin that provides trigger objects
+        unsigned filterIndex;
+
+        /// Index of the bin in the configuration, which is used to report results
+        unsigned configIndex;
+    };
+
+public:
+    /**
+     * \brief Constructor
+     *
+     * The configuration file and the flag useMargin have the same meaning as for
+     * LeadJetTriggerFilter.
+     */
+    TriggerBinDispatcher(std::string const &name, std::string const &configFileName,
+      bool useMargin = true);
+
+public:
+    /**
+     * \brief Saves pointers to required plugins and caches indices of trigger filters
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void BeginRun(Dataset const &) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Plugin.
+     */
+    virtual TriggerBinDispatcher *Clone() const override;
+
+    /**
+     * \brief Returns index of the bin for the given trigger
+     *
+     * Throws an exception if the trigger is not present in the configuration.
+     */
+    unsigned GetBinIndex(std::string const &triggerName) const;
+
+    /// Returns names of all triggers in the order defined by bin indices
+    std::vector<std::string> GetTriggerNames() const;
+
+    /// Checks if the current event has been assigned to the bin with the given index
+    bool IsAccepted(unsigned binIndex) const
+    {
+        return accepted[binIndex];
+    }
+
+    /// Changes name of the plugin that provides jets and MET
+    void SetJetMETPluginName(std::string const &name);
+
+    /**
+     * \brief Changes name of the plugin that provides trigger objects
+     *
+     * It must be either a PECTriggerObjectReader or a SkimCacheReader.
+     */
+    void SetTriggerObjectsPluginName(std::string const &name);
+
+private:
+    /// Checks if the leading jet is matched to a trigger object for the given bin
+    bool IsMatched(Bin const &bin, double etaLead, double phiLead) const;
+
+    /**
+     * \brief Finds bins for the current event
+     *
+     * Returns false if the event is not assigned to any bin.
+     *
+     * Implemented from Plugin.
+     */
+    virtual bool ProcessEvent() override;
+
+private:
+    /// Name of a plugin that produces jets and MET
+    std::string jetmetPluginName;
+
+    /// Non-owning pointer to the plugin that produces jets and MET
+    JetMETReader const *jetmetPlugin;
+
+    /// Non-owning pointer to jets in the columnar layout
+    JetBlock const *jetBlock;
+
+    /// Name of a plugin that reads trigger objects
+    std::string triggerObjectsPluginName;
+
+    /**
+     * \brief Non-owning pointers to the plugin that provides trigger objects
+     *
+     * Only one of them is not null.
+     */
+    PECTriggerObjectReader const *triggerObjectsPlugin;
+    SkimCacheReader const *skimCachePlugin;
+
+    /// Trigger bins sorted in the lower boundary of the pt range
+    std::vector<Bin> bins;
+
+    /// Lower boundaries of pt ranges of sorted bins, used in the binary search
+    std::vector<double> minPts;
+
+    /// Flags showing whether the current event is assigned to each bin, in configuration order
+    std::vector<bool> accepted;
+
+    /// Maximal dR distance (squared) for matching
+    double maxDR2;
+};
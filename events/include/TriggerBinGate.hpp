@@ -0,0 +1,66 @@
+#pragma once
+
+#include <mensura/AnalysisPlugin.hpp>
+
+#include <string>
+
+
+class TriggerBinDispatcher;
+
+
+/**
+ * \class TriggerBinGate
+ * \brief Selects events assigned to a given trigger bin by a TriggerBinDispatcher
+ *
+ * Intended to start the event path for a trigger bin. All the work is done by the dispatcher, and
+ * this plugin only looks up the result for its bin.
+ */
+class TriggerBinGate: public AnalysisPlugin
+{
+public:
+    /**
+     * \brief Constructor
+     *
+     * \param name  Name for the plugin.
+     * \param dispatcherName  Name of the TriggerBinDispatcher.
+     * \param triggerName  Name of the trigger that defines the bin.
+     */
+    TriggerBinGate(std::string const &name, std::string const &dispatcherName,
+      std::string const &triggerName);
+
+public:
+    /**
+     * \brief Saves pointer to the dispatcher and finds index of the bin
+     *
+     * Reimplemented from Plugin.
+     */
+    virtual void BeginRun(Dataset const &) override;
+
+    /**
+     * \brief Creates a newly configured clone
+     *
+     * Implemented from Plugin.
+     */
+    virtual TriggerBinGate *Clone() const override;
+
+private:
+    /**
+     * \brief Checks if the current event has been assigned to the bin
+     *
+     * Implemented from Plugin.
+     */
+    virtual bool ProcessEvent() override;
+
+private:
+    /// Name of the dispatcher
+    std::string dispatcherName;
+
+    /// Non-owning pointer to the dispatcher
+    TriggerBinDispatcher const *dispatcher;
+
+    /// Name of the trigger that defines the bin
+    std::string triggerName;
+
+    /// Index of the bin in the dispatcher
+    unsigned binIndex;
+};
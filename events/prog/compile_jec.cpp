@@ -0,0 +1,120 @@
+/**
+ * \file compile_jec.cpp
+ *
+ * A program to compile text files with jet corrections into a binary format that can be read
+ * without parsing. Each compiled file is written next to the source file, with the extension
+ * replaced by ".jecbin", and is picked up automatically by JetCorrectionLevel::Load as long as the
+ * source file is not modified. See documentation for class JetCorrectionLevel.
+ *
+ * Arguments can be files or directories. For a directory, all files with extension ".txt" in it
+ * are compiled, and files that are not in a supported format (such as uncertainties or JER
+ * parameters) are skipped with a message.
+ */
+
+#include <JetCorrectionLevel.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace fs = std::filesystem;
+namespace po = boost::program_options;
+
+
+/**
+ * \brief Compiles the given text file
+ *
+ * Returns false if this fails. Files that are up to date are not compiled again unless force is
+ * true.
+ */
+bool Compile(fs::path const &path, bool force);
+
+
+int main(int argc, char **argv)
+{
+    po::options_description options("Supported options");
+    options.add_options()
+      ("inputs", po::value<std::vector<std::string>>(), "Text files or directories")
+      ("help,h", "Prints help message")
+      ("force,f", "Recompile files that are up to date");
+
+    po::positional_options_description positionalOptions;
+    positionalOptions.add("inputs", -1);
+
+    po::command_line_parser parser(argc, argv);
+    parser.options(options);
+    parser.positional(positionalOptions);
+
+    po::variables_map optionMap;
+    po::store(parser.run(), optionMap);
+
+    if (optionMap.count("help"))
+    {
+        std::cerr << "Usage: compile_jec [options] inputs\n";
+        std::cerr << options << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (not optionMap.count("inputs"))
+    {
+        std::cerr << "No input files provided." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+
+    bool const force = optionMap.count("force");
+    bool success = true;
+
+    for (auto const &input: optionMap["inputs"].as<std::vector<std::string>>())
+    {
+        if (not fs::is_directory(input))
+        {
+            success = Compile(input, force) and success;
+            continue;
+        }
+
+        // Failures are expected in a directory since it can contain files of other types
+        for (auto const &entry: fs::directory_iterator(input))
+        {
+            if (entry.is_regular_file() and entry.path().extension() == ".txt")
+                Compile(entry.path(), force);
+        }
+    }
+
+
+    return (success) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+bool Compile(fs::path const &path, bool force)
+{
+    std::string const compiledPath = JetCorrectionLevel::GetCompiledPath(path);
+
+    try
+    {
+        auto const level = (force) ? std::make_shared<JetCorrectionLevel const>(path) :
+          JetCorrectionLevel::Load(path);
+
+        if (level->IsCompiled())
+        {
+            std::cout << "File " << path << " is up to date." << std::endl;
+            return true;
+        }
+
+        level->WriteCompiled(compiledPath);
+        std::cout << "Compiled " << path << " into \"" << compiledPath << "\"." << std::endl;
+        return true;
+    }
+    catch (std::exception const &e)
+    {
+        std::cerr << "Skipping " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+}
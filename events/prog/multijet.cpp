@@ -13,6 +13,7 @@
 #include <BalanceFilter.hpp>
 #include <BalanceHists.hpp>
 #include <BalanceVars.hpp>
+#include <BatchJetCorrectorService.hpp>
 #include <DumpEventID.hpp>
 #include <EtaPhiFilter.hpp>
 #include <FirstJetFilter.hpp>
@@ -21,11 +22,27 @@
 #include <JERCJetMETReader.hpp>
 #include <JERCJetMETUpdate.hpp>
 #include <JetIDFilter.hpp>
+#include <JetKinematics.hpp>
 #include <L1TPrefiringWeights.hpp>
-#include <LeadJetTriggerFilter.hpp>
+#include <LumiMaskFilter.hpp>
 #include <MPIMatchFilter.hpp>
+#include <PartitionFilter.hpp>
+#include <PartitionIndex.hpp>
 #include <PeriodWeights.hpp>
 #include <PileUpVars.hpp>
+#include <PluginStatsService.hpp>
+#include <SharedResources.hpp>
+#include <SharedTree.hpp>
+#include <SharedTreeFiller.hpp>
+#include <SimBalanceHists.hpp>
+#include <SkimCache.hpp>
+#include <SkimCacheJetMETReader.hpp>
+#include <SkimCachePileUpReader.hpp>
+#include <SkimCacheReader.hpp>
+#include <SkimCacheWriter.hpp>
+#include <TimingProbe.hpp>
+#include <TriggerBinDispatcher.hpp>
+#include <TriggerBinGate.hpp>
 
 #include <mensura/Config.hpp>
 #include <mensura/Dataset.hpp>
@@ -47,10 +64,15 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/program_options.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <filesystem>
+#include <initializer_list>
+#include <iomanip>
 #include <iostream>
 #include <list>
+#include <map>
 #include <set>
 #include <sstream>
 #include <stdexcept>
@@ -62,6 +84,11 @@ namespace po = boost::program_options;
 using namespace std;
 
 
+/// Ranges of entries to be read from partially included files, for pairs of data set IDs and paths
+using PartitionRanges =
+  std::map<std::pair<std::string, std::string>, std::vector<PartitionIndex::Range>>;
+
+
 /// Supported systematic uncertainties
 enum class SystType
 {
@@ -72,6 +99,102 @@ enum class SystType
 };
 
 
+/// Systematic variation, which combines a type of uncertainty and a direction
+struct Variation
+{
+    SystType type;
+    SystService::VarDirection direction;
+};
+
+
+/// Data-taking period with distinct jet energy corrections
+struct JECPeriod
+{
+    std::string label;
+    
+    /// Range of runs, inclusive
+    unsigned long minRun, maxRun;
+};
+
+
+/// Rectangular region in (eta, phi) vetoed by EtaPhiFilter
+struct EtaPhiRegion
+{
+    /// Range of runs, inclusive
+    unsigned long minRun, maxRun;
+    
+    double startEta, endEta, startPhi, endPhi;
+};
+
+
+// Run-dependent configuration for data. All run intervals that affect the processing of data are
+//collected here.
+std::vector<JECPeriod> const jecPeriods{
+    {"BCD", 272007, 276811},
+    {"EF", 276831, 278801},
+    {"GH", 278802, 284044}
+};
+
+// Definition from 06.12.2017
+std::vector<EtaPhiRegion> const etaPhiRegions{
+    {272007, 275376, -2.250, -1.930, 2.200, 2.500},
+    {275657, 276283, -3.489, -3.139, 2.237, 2.475},
+    {276315, 276811, -3.600, -3.139, 2.237, 2.475}
+};
+
+
+/**
+ * \brief Measures wall time spent in phases of the initialization
+ *
+ * Each call to EndPhase attributes the time elapsed since the previous call (or construction) to
+ * the phase with the given label. Repeated labels are accumulated.
+ */
+class StartupTimer
+{
+public:
+    StartupTimer():
+        start{std::chrono::steady_clock::now()}, last{start}
+    {}
+    
+public:
+    /// Ends the current phase
+    void EndPhase(std::string const &label)
+    {
+        auto const now = std::chrono::steady_clock::now();
+        double const duration = std::chrono::duration<double>(now - last).count();
+        last = now;
+        
+        auto res = std::find_if(phases.begin(), phases.end(),
+          [&label](auto const &phase){return phase.first == label;});
+        
+        if (res != phases.end())
+            res->second += duration;
+        else
+            phases.emplace_back(label, duration);
+    }
+    
+    /// Prints durations of all phases and the total time
+    void Print(std::ostream &out) const
+    {
+        out << "Initialization time, s:\n";
+        
+        for (auto const &[label, duration]: phases)
+            out << "  " << std::left << std::setw(40) << label << std::right << std::fixed <<
+              std::setprecision(3) << std::setw(9) << duration << '\n';
+        
+        out << "  " << std::left << std::setw(40) << "Total" << std::right << std::setw(9) <<
+          std::chrono::duration<double>(last - start).count() << '\n';
+    }
+    
+private:
+    /// Start of the initialization and end of the last phase
+    std::chrono::steady_clock::time_point start, last;
+    
+    /// Labels and durations of phases, in seconds
+    std::vector<std::pair<std::string, double>> phases;
+};
+
+
 /**
  * \brief Constructs input data sets
  *
@@ -81,8 +204,32 @@ enum class SystType
  *     ID and all the following ones as paths to input files. Relative paths are resolved with
  *     respect to the base directory of the underlying DatasetBuilder.
  * \param[in] config  Object that provides an access to the configuration.
+ * \param[out] partitionRanges  Ranges of entries to be read from input files that are only
+ *     partially included in data sets, for pairs of data set IDs and file paths. A data set in a
+ *     sample group can be defined as a partition of another data set, in section
+ *     "samples/partitions" of the configuration. It then includes only files that contain entries
+ *     from this partition, according to their PartitionIndex. Files that only contain entries
+ *     from this partition are read in full and are not included in the map.
+ */
+std::list<Dataset> BuildDatasets(std::vector<std::string> const &inputs, Config const &config,
+  PartitionRanges &partitionRanges);
+
+/**
+ * \brief Parses requested systematic variations
+ *
+ * \param[in] systArg  Value of the command line option. An empty string is interpreted as the
+ *     nominal configuration. Otherwise this is a comma-separated list of variations, such as
+ *     "jer_up,l2res_down", in which label "nominal" is also allowed. The special value "all"
+ *     requests the nominal configuration together with all variations that have an effect for the
+ *     given type of input data.
+ * \param[in] isSim  Indicates whether simulation or real data is being processed.
+ *
+ * Terminates the program if a variation is not recognized.
  */
-std::list<Dataset> BuildDatasets(std::vector<std::string> const &inputs, Config const &config);
+std::vector<Variation> ParseVariations(std::string const &systArg, bool isSim);
+
+/// Returns a label for the given variation, such as "nominal" or "jer_up"
+std::string GetVariationLabel(Variation const &variation);
 
 
 std::string systTypeToString(SystType systType)
@@ -115,11 +262,19 @@ int main(int argc, char **argv)
       ("help,h", "Prints help message")
       ("sample_def", po::value<vector<string>>(), "Definition of input samples (required)")
       ("config,c", po::value<string>()->default_value("main.json"), "Configuration file")
-      ("syst,s", po::value<string>()->default_value(""), "Systematic shift")
+      ("syst,s", po::value<string>()->default_value(""),
+        "Systematic shift, comma-separated list of shifts, or \"all\"")
       ("l3-res", "Enables L3 residual corrections")
       ("wide", "Loosen selection to |eta(j1)| < 2.4")
       ("output,o", po::value<string>()->default_value("."), "Name for output directory")
-      ("threads,t", po::value<int>()->default_value(1), "Number of threads to run in parallel");
+      ("skim-cache", po::value<string>(), "Directory for skim cache (real data only)")
+      ("lumi-mask", po::value<string>(), "Certification JSON file to select luminosity blocks "
+        "(real data only)")
+      ("threads,t", po::value<int>()->default_value(1), "Number of threads to run in parallel")
+      ("plugin-stats", po::value<string>(),
+        "Write per-plugin timing and event counts to given JSON file")
+      ("benchmark-startup", "Report time spent in initialization phases and exit")
+      ("merged-trees", "Write a single tree per trigger bin instead of a tree per producer");
     
     po::positional_options_description positionalOptions;
     positionalOptions.add("sample_def", -1);
@@ -146,6 +301,10 @@ int main(int argc, char **argv)
     }
     
 
+    // Measure durations of initialization phases. They are only reported if requested.
+    StartupTimer startupTimer;
+    
+    
     // Load the main configuration and include additional locations to search for files
     char const *installPath = getenv("MULTIJET_JEC_INSTALL");
     
@@ -165,281 +324,609 @@ int main(int argc, char **argv)
     for (unsigned i = 0; i < addLocationsNode.size(); ++i)
         FileInPath::AddLocation(addLocationsNode[i].asString());
     
+    startupTimer.EndPhase("Main configuration");
     
-    // Parse requested systematic uncertainty
-    SystType systType(SystType::None);
-    SystService::VarDirection systDirection = SystService::VarDirection::Undefined;
     
-    std::string const systArg{optionsMap["syst"].as<string>()};
+    // Input datasets
+    PartitionRanges partitionRanges;
+    std::list<Dataset> const datasets = BuildDatasets(
+      optionsMap["sample_def"].as<std::vector<std::string>>(), config, partitionRanges);
 
-    if (not systArg.empty())
+    // Use the first data set to determine whether real data or simulation is being processed. All
+    // other data sets must be the same.
+    bool const isSim = datasets.front().IsMC();
+    startupTimer.EndPhase("Input data sets");
+    
+    
+    // Parse requested systematic variations. If more than one variation is requested, they are
+    //evaluated in a single pass over input files. Readers are then shared among all variations,
+    //while the rest of the event processing is performed by a dedicated chain of plugins for each
+    //variation. Names of these plugins and services are decorated with labels of the variations,
+    //and outputs are written into per-variation subdirectories.
+    std::vector<Variation> const variations =
+      ParseVariations(optionsMap["syst"].as<string>(), isSim);
+    bool const multiSyst = (variations.size() > 1);
+    
+    
+    // Find requested trigger bins. The parsed configuration is shared with plugins constructed
+    //below since this pointer keeps it in the cache.
+    fs::path const triggerConfigPath = config.Get({"trigger_config"}).asString();
+    auto const triggerConfig = SharedResources::GetConfig(triggerConfigPath);
+    std::vector<std::string> triggerNames, triggerFilters;
+
+    for (auto const &trigger: triggerConfig->Get().getMemberNames())
     {
-        std::string const systArgLower{boost::to_lower_copy(systArg)};
-        
-        std::regex systRegex("(l1res|l2res|jer)[-_]?(up|down)", std::regex::extended);
-        std::smatch matchResult;
+        triggerNames.emplace_back(trigger);
+        triggerFilters.emplace_back(triggerConfig->Get()[trigger]["filter"].asString());
+    }
+    
+    startupTimer.EndPhase("Trigger configuration");
+    
+    
+    // Optional certification mask for real data. As above, the parsed file is kept in the cache
+    //for the filter constructed below.
+    std::shared_ptr<Config const> lumiMaskConfig;
+    
+    if (optionsMap.count("lumi-mask"))
+    {
+        if (isSim)
+        {
+            cerr << "Luminosity mask can only be applied to real data.\n";
+            return EXIT_FAILURE;
+        }
         
-        if (not std::regex_match(systArgLower, matchResult, systRegex))
+        lumiMaskConfig = SharedResources::GetConfig(optionsMap["lumi-mask"].as<string>());
+    }
+    
+    
+    // Optional skim cache. Events that pass the selection on jets are written into it. If cache
+    //files exist for all input files, events are replayed from them instead, and reading of input
+    //files, jet corrections, and the selection that precedes the cache are skipped. The key for the
+    //cache includes options and configuration files that affect its content. Changes in the
+    //source code are not tracked; if they affect the cache, SkimCache::formatVersion must be
+    //increased, or the cache directory cleared.
+    bool const useSkimCache = optionsMap.count("skim-cache");
+    bool replaySkim = false;
+    std::string skimCacheDir;
+    std::uint64_t skimCacheKey = 0;
+    
+    if (useSkimCache)
+    {
+        if (isSim or multiSyst)
         {
-            cerr << "Cannot recognize systematic variation \"" << systArg << "\".\n";
+            cerr << "Skim cache can only be used with real data and a single variation.\n";
             return EXIT_FAILURE;
         }
-        else
+        
+        skimCacheDir = optionsMap["skim-cache"].as<string>();
+        fs::create_directories(skimCacheDir);
+        
+        std::ostringstream settings;
+        settings << SkimCache::formatVersion << ' ' << GetVariationLabel(variations.front()) <<
+          ' ' << optionsMap.count("l3-res") << ' ' << optionsMap.count("wide");
+        
+        // Entries selected in partially included files also affect the content of the cache
+        for (auto const &[file, ranges]: partitionRanges)
         {
-            if (matchResult[1] == "l1res")
-                systType = SystType::L1Res;
-            else if (matchResult[1] == "l2res")
-                systType = SystType::L2Res;
-            else if (matchResult[1] == "jer")
-                systType = SystType::JER;
+            settings << ' ' << file.first << ' ' << file.second;
             
-            if (matchResult[2] == "up")
-                systDirection = SystService::VarDirection::Up;
-            else if (matchResult[2] == "down")
-                systDirection = SystService::VarDirection::Down;
+            for (auto const &range: ranges)
+                settings << ' ' << range.begin << ' ' << range.end;
         }
+        
+        skimCacheKey = SkimCache::Hash(settings.str());
+        skimCacheKey = SkimCache::HashFile(config.FilePath(), skimCacheKey);
+        skimCacheKey = SkimCache::HashFile(triggerConfig->FilePath(), skimCacheKey);
+        
+        if (lumiMaskConfig)
+            skimCacheKey = SkimCache::HashFile(lumiMaskConfig->FilePath(), skimCacheKey);
+        
+        replaySkim = true;
+        
+        for (auto const &dataset: datasets)
+            for (auto const &file: dataset.GetFiles())
+            {
+                if (not fs::exists(SkimCache::GetPath(skimCacheDir, skimCacheKey,
+                  dataset.GetSourceDatasetID(), file.name)))
+                    replaySkim = false;
+            }
+        
+        if (replaySkim)
+            std::cout << "Events will be replayed from skim cache in \"" << skimCacheDir <<
+              "\".\n";
+        
+        startupTimer.EndPhase("Skim cache lookup");
     }
     
     
-    // Input datasets
-    std::list<Dataset> const datasets = BuildDatasets(
-      optionsMap["sample_def"].as<std::vector<std::string>>(), config);
-
-    // Use the first data set to determine whether real data or simulation is being processed. All
-    // other data sets must be the same.
-    bool const isSim = datasets.front().IsMC();
-    
     // Construct the run manager
     RunManager manager(datasets.begin(), datasets.end());
     
     
-    // Register services and plugins
-    manager.RegisterService(new TFileService(optionsMap["output"].as<string>() + "/%"));
-    
-    manager.RegisterPlugin(new PECInputData);
-    manager.RegisterPlugin(new PECPileUpReader);
+    // Optional instrumentation. If requested, each plugin is surrounded by a pair of timing
+    //probes, which report to a PluginStatsService. Plugins that follow it depend on the second
+    //probe, which accepts all events that reach it, so the event selection is not changed.
+    PluginStatsService *pluginStats = nullptr;
     
+    if (optionsMap.count("plugin-stats"))
+    {
+        pluginStats = new PluginStatsService;
+        manager.RegisterService(pluginStats);
+    }
     
-    // Jet corrections
-    if (not isSim)
+    auto registerPlugin = [&manager, pluginStats](Plugin *plugin,
+      std::initializer_list<std::string> const &dependencies = {})
     {
-        // Read original jets and MET, which have outdated corrections
-        JERCJetMETReader *jetmetReader = new JERCJetMETReader("OrigJetMET");
-        jetmetReader->SetSelection(0., 5.);
-        jetmetReader->ConfigureLeptonCleaning("");  // Disabled
-        jetmetReader->SetApplyJetID(false);
-        manager.RegisterPlugin(jetmetReader);
-        
-        
-        // Corrections to be applied to jets. The full correction will also be propagated into
-        //missing pt.
-        JetCorrectorService *jetCorrFull = new JetCorrectorService("JetCorrFull");
-        JetCorrectorService *jetCorrL1 = new JetCorrectorService("JetCorrL1");
-        
-        for (auto jetCorr: {jetCorrFull, jetCorrL1})
+        if (not pluginStats)
         {
-            // Periods for jet corrections are not aligned perfectly with data-taking eras: the
-            //period "2016GH" includes few last runs from era 2016F
-            jetCorr->RegisterIOV("2016BCD", 272007, 276811);
-            jetCorr->RegisterIOV("2016EF", 276831, 278801);
-            jetCorr->RegisterIOV("2016GH", 278802, 284044);
+            manager.RegisterPlugin(plugin, dependencies);
+            return;
         }
         
-        for (string const &period: {"BCD", "EF", "GH"})
+        std::string const name = plugin->GetName();
+        manager.RegisterPlugin(new TimingProbe("TimingStart_" + name, name,
+          TimingProbe::Mode::Start), dependencies);
+        manager.RegisterPlugin(plugin);
+        manager.RegisterPlugin(new TimingProbe("TimingStop_" + name, name,
+          TimingProbe::Mode::Stop));
+    };
+    
+    
+    // Register common services and readers
+    if (replaySkim)
+    {
+        registerPlugin(new SkimCacheReader("InputData", skimCacheDir, skimCacheKey));
+        registerPlugin(new SkimCachePileUpReader);
+    }
+    else
+    {
+        registerPlugin(new PECInputData);
+        
+        // Select entries from the requested partitions before the remaining trees are read
+        if (not partitionRanges.empty())
         {
-            string const jecVersion = "Summer16_07Aug2017" + period + "_V11";
+            auto *partitionFilter = new PartitionFilter;
             
-            vector<string> jecLevels{jecVersion + "_DATA_L1FastJet_AK4PFchs.txt",
-              jecVersion + "_DATA_L2Relative_AK4PFchs.txt",
-              jecVersion + "_DATA_L3Absolute_AK4PFchs.txt"};
+            for (auto const &[file, ranges]: partitionRanges)
+                partitionFilter->AddFile(file.first, file.second, ranges);
             
-            if (not optionsMap.count("no-res"))
-            {
-                if (optionsMap.count("l3-res"))
-                    jecLevels.emplace_back(jecVersion + "_DATA_L2L3Residual_AK4PFchs.txt");
-                else
-                {
-                    jecLevels.emplace_back(jecVersion + "_DATA_L2Residual_AK4PFchs.txt");
-                    
-                    if (systType == SystType::JER)
-                    {
-                        // Add closure-style L2Res corrections obtained with varied JER [1]
-                        // [1] https://indico.cern.ch/event/724150/#14-dijet-with-2016-legacy-data
-                        std::string const namePrefix{
-                            "Summer16_07Aug2017_V6_MPF_LOGLIN_L2Residual_pythia8_AK4PFchs_"};
-
-                        if (systDirection == SystService::VarDirection::Up)
-                            jecLevels.emplace_back(namePrefix + "JERup.txt");
-                        else
-                            jecLevels.emplace_back(namePrefix + "JERdown.txt");
-                    }
-                }
-            }
-            
-            jetCorrFull->SetJEC("2016" + period, jecLevels);
-            jetCorrL1->SetJEC("2016" + period, {jecVersion + "_DATA_L1RC_AK4PFchs.txt"});
+            registerPlugin(partitionFilter);
         }
         
-        manager.RegisterService(jetCorrFull);
-        manager.RegisterService(jetCorrL1);
+        // Reject uncertified luminosity blocks before the remaining readers. Replayed events have
+        //passed the same mask, which is included in the key of the skim cache.
+        if (lumiMaskConfig)
+            registerPlugin(new LumiMaskFilter(optionsMap["lumi-mask"].as<string>()));
+        
+        registerPlugin(new PECPileUpReader);
     }
-    else
+    
+    if (isSim)
     {
-        manager.RegisterService(new SystService(
-          (systType == SystType::None or systType == SystType::JER) ?
-            systTypeToString(systType) : "JEC"s,
-          systDirection));
-        
-        manager.RegisterPlugin(new PECGenJetMETReader);
+        if (not multiSyst)
+            manager.RegisterService(new SystService(
+              (variations.front().type == SystType::None or
+                variations.front().type == SystType::JER) ?
+                systTypeToString(variations.front().type) : "JEC"s,
+              variations.front().direction));
         
-        
-        // Read original jets and MET
+        registerPlugin(new PECGenJetMETReader);
+    }
+    
+    
+    if (not replaySkim)
+    {
+        // Read original jets and MET. In real data they have outdated corrections.
         JERCJetMETReader *jetmetReader = new JERCJetMETReader("OrigJetMET");
         jetmetReader->SetSelection(0., 5.);
         jetmetReader->ConfigureLeptonCleaning("");  // Disabled
-        jetmetReader->SetGenJetReader();  // Default one
+        
+        if (isSim)
+            jetmetReader->SetGenJetReader();  // Default one
+        
         jetmetReader->SetApplyJetID(false);
-        manager.RegisterPlugin(jetmetReader);
-        
-        
-        string const jecVersion("Summer16_07Aug2017_V11");
-        
-        // Corrections to be applied to jets and also to be propagated to MET. Although original
-        //jets in simulation already have up-to-date corrections, they will be reapplied in order
-        //to have a consistent impact on MET from the stochastic JER smearing. The random-number
-        //seed for the smearing is fixed for the sake of reproducibility.
-        JetCorrectorService *jetCorrFull = new JetCorrectorService("JetCorrFull");
-        jetCorrFull->SetJEC({jecVersion + "_MC_L1FastJet_AK4PFchs.txt",
-          jecVersion + "_MC_L2Relative_AK4PFchs.txt",
-          jecVersion + "_MC_L3Absolute_AK4PFchs.txt"});
-        jetCorrFull->SetJER("Summer16_25nsV1_MC_SF_AK4PFchs.txt",
-          "Summer16_25nsV1_MC_PtResolution_AK4PFchs.txt");
-        
-        if (systType == SystType::L1Res)
-            jetCorrFull->SetJECUncertainty(jecVersion + "_MC_UncertaintySources_AK4PFchs.txt",
-              {"PileUpPtBB", "PileUpPtEC1", "PileUpPtEC2", "PileUpPtHF", "PileUpDataMC"});
-        else if (systType == SystType::L2Res)
-            jetCorrFull->SetJECUncertainty(jecVersion + "_MC_UncertaintySources_AK4PFchs.txt",
-              {"RelativePtBB", "RelativePtEC1", "RelativePtEC2", "RelativePtHF",
-               "RelativeBal", "RelativeSample", "RelativeFSR",
-               "RelativeStatFSR", "RelativeStatEC", "RelativeStatHF"});
-        
-        manager.RegisterService(jetCorrFull);
-        
-        // L1 corrections to be used in T1 MET corrections
-        JetCorrectorService *jetCorrL1 = new JetCorrectorService("JetCorrL1");
-        jetCorrL1->SetJEC({jecVersion + "_MC_L1RC_AK4PFchs.txt"});
-        manager.RegisterService(jetCorrL1);
+        
+        // All consumers of jets in this program read them from the JetBlock or with the free
+        //function GetJets, so standard collections of jets are not filled
+        jetmetReader->SetFillStandardJets(false);
+        registerPlugin(jetmetReader);
     }
     
     
-    // Recorrect jets and apply T1 MET corrections to raw MET
-    JERCJetMETUpdate *jetmetUpdater = new JERCJetMETUpdate("JetCorrFull", "JetCorrL1");
-    jetmetUpdater->SetT1Threshold(15., 20.);
-    manager.RegisterPlugin(jetmetUpdater);
-    
-    
-    if (optionsMap.count("wide"))
-        manager.RegisterPlugin(new FirstJetFilter(150., 2.4));
-    else
-        manager.RegisterPlugin(new FirstJetFilter(150., 1.3));
+    // L1 corrections to be used in T1 MET corrections in simulation. They are not affected by
+    //systematic variations. In real data they are evaluated together with the full corrections
+    //by a BatchJetCorrectorService (see below).
+    if (isSim)
+    {
+        JetCorrectorService *jetCorrL1 = new JetCorrectorService("JetCorrL1");
+        jetCorrL1->SetJEC({"Summer16_07Aug2017_V11_MC_L1RC_AK4PFchs.txt"});
+        manager.RegisterService(jetCorrL1);
+    }
     
-    manager.RegisterPlugin(new JetIDFilter("JetIDFilter", 15.));
     
-    if (not isSim)
+    // In the multi-variation mode, readers that are normally run for selected events only, need to
+    //be run for all events since they are shared among all variations
+    if (multiSyst)
     {
-        EtaPhiFilter *etaPhiFilter = new EtaPhiFilter(15.);
-        
-        // Definition from 06.12.2017
-        etaPhiFilter->AddRegion(272007, 275376, -2.250, -1.930, 2.200, 2.500);
-        etaPhiFilter->AddRegion(275657, 276283, -3.489, -3.139, 2.237, 2.475);
-        etaPhiFilter->AddRegion(276315, 276811, -3.600, -3.139, 2.237, 2.475);
+        if (isSim)
+        {
+            registerPlugin(new PECGenParticleReader);
+            
+            auto *generatorReader = new PECGeneratorReader;
+            generatorReader->RequestAltWeights();
+            registerPlugin(generatorReader);
+        }
         
-        manager.RegisterPlugin(etaPhiFilter);
+        registerPlugin(new PECTriggerObjectReader);
     }
-    else
-    {
-        manager.RegisterPlugin(new PECGenParticleReader);
-        manager.RegisterPlugin(new GenMatchFilter(0.2, 0.5));
-        manager.RegisterPlugin(new MPIMatchFilter(0.4));
-    }
-    
-    // Set angular selection based on [1-3]
-    //[1] https://indico.cern.ch/event/749862/#2-l3res-multijet-update
-    //[2] https://indico.cern.ch/event/759977/#28-ideas-on-multijet
-    AngularFilter *angularFilter = new AngularFilter;
-    angularFilter->SetDPhi12Cut(2., 2.9);
-    angularFilter->SetDPhi23Cut(0., 1.);
-    manager.RegisterPlugin(angularFilter);
     
-    manager.RegisterPlugin(new BalanceCalc(30., 33.));
     
-    // Remove strongly imbalanced events in the high-pt region. This is a temporary solution to the
-    //problem described in [1].
-    //[1] https://indico.cern.ch/event/720429/#7-unhealthy-high-pt-electrons
-    BalanceFilter *balanceFilter = new BalanceFilter(0.5, 1.5);
-    balanceFilter->SetMinPtLead(1000.);
-    manager.RegisterPlugin(balanceFilter);
-
-
-    if (isSim)
-    {
-        auto *generatorReader = new PECGeneratorReader;
-        generatorReader->RequestAltWeights();
-        manager.RegisterPlugin(generatorReader);
-
-        manager.RegisterPlugin(new L1TPrefiringWeights(
-          config.Get({"period_weight_config"}).asString()));
-    }
-
-
-    // Find requested trigger bins
-    fs::path const triggerConfigPath = config.Get({"trigger_config"}).asString();
-    Config triggerConfig(triggerConfigPath);
-    std::vector<std::string> triggerNames;
-
-    for (auto const &trigger: triggerConfig.Get().getMemberNames())
-        triggerNames.emplace_back(trigger);
+    startupTimer.EndPhase("Common plugins and services");
     
     
-    manager.RegisterPlugin(new PECTriggerObjectReader);
+    // Register a chain of plugins for each variation. Services that read jet corrections for
+    //real data in the background are collected to wait for them in the benchmark mode. The
+    //initialization time is reported separately for each variation.
+    std::vector<BatchJetCorrectorService *> batchCorrectors;
     
-    for (auto const &trigger: triggerNames)
+    for (auto const &variation: variations)
     {
-        manager.RegisterPlugin(new LeadJetTriggerFilter("TriggerFilter"s + trigger, trigger,
-          triggerConfigPath, isSim), {"BalanceFilter"});
+        SystType const systType = variation.type;
+        SystService::VarDirection const systDirection = variation.direction;
+        std::string const suffix = (multiSyst) ? "_" + GetVariationLabel(variation) : "";
+        std::string const phaseSuffix =
+          (multiSyst) ? " (" + GetVariationLabel(variation) + ")" : "";
         
-        BalanceVars *balanceVars = new BalanceVars("BalanceVars"s + trigger, 30.);
-        balanceVars->SetTreeName(trigger + "/BalanceVars");
-        manager.RegisterPlugin(balanceVars, {"TriggerFilter"s + trigger});
         
-        PileUpVars *puVars = new PileUpVars("PileUpVars"s + trigger);
-        puVars->SetTreeName(trigger + "/PileUpVars");
-        manager.RegisterPlugin(puVars);
+        // Output files
+        fs::path outputDirectory{optionsMap["output"].as<string>()};
         
-        if (isSim)
+        if (multiSyst)
         {
-            auto *weights = new GenWeights("GenWeights" + trigger);
-            weights->SetTreeName(trigger + "/GenWeights");
-            weights->SetGeneratorReader("Generator");
-            manager.RegisterPlugin(weights);
-
-            PeriodWeights *periodWeights = new PeriodWeights("PeriodWeights" + trigger,
-              config.Get({"period_weight_config"}).asString(), trigger);
-            periodWeights->SetPrefiringWeightPlugin("L1TPrefiringWeights");
-            periodWeights->SetTreeName(trigger + "/PeriodWeights");
-            manager.RegisterPlugin(periodWeights);
+            outputDirectory /= GetVariationLabel(variation);
+            fs::create_directories(outputDirectory);
+        }
+        
+        manager.RegisterService(new TFileService("TFileService" + suffix,
+          (outputDirectory / "%").string()));
+        
+        startupTimer.EndPhase("Plugins and services" + phaseSuffix);
+        
+        
+        if (replaySkim)
+        {
+            // Jets and MET in the cache are already corrected and selected. The phase of jet
+            //corrections is still recorded, so that the timing can be compared with a regular run.
+            SkimCacheJetMETReader *jetmetReader = new SkimCacheJetMETReader("JetMET" + suffix);
+            jetmetReader->SetFillStandardJets(false);
+            registerPlugin(jetmetReader);
+            
+            startupTimer.EndPhase("Jet corrections" + phaseSuffix);
         }
         else
         {
-            DumpEventID *eventID = new DumpEventID("EventID"s + trigger);
-            eventID->SetTreeName(trigger + "/EventID");
-            manager.RegisterPlugin(eventID);
+            // Full jet corrections, which will also be propagated into missing pt. In real data,
+            //they are evaluated for all jets in an event at once, together with L1 corrections for
+            //the T1 MET correction. Periods for jet corrections are not aligned perfectly with
+            //data-taking eras: the period "2016GH" includes few last runs from era 2016F.
+            //
+            //In simulation, although original jets already have up-to-date corrections, they will
+            //be reapplied in order to have a consistent impact on MET from the stochastic JER
+            //smearing. The random-number seed for the smearing is fixed for the sake of
+            //reproducibility. A dedicated service is created for each variation, so that the
+            //sequence of random numbers does not depend on which other variations are evaluated in
+            //the same job.
+            //
+            //Files with jet corrections for real data are read in the background, in parallel for
+            //different periods, so that this overlaps with the rest of the initialization and
+            //with opening of the first input file.
+            JERCJetMETUpdate *jetmetUpdater;
+            
+            if (not isSim)
+            {
+                BatchJetCorrectorService *jetCorr =
+                  new BatchJetCorrectorService("JetCorr" + suffix);
+                jetCorr->SetDeferredLoading();
+                batchCorrectors.emplace_back(jetCorr);
+                
+                for (auto const &period: jecPeriods)
+                    jetCorr->RegisterIOV("2016" + period.label, period.minRun, period.maxRun);
+                
+                // With the JER variation, closure-style L2Res corrections obtained with varied JER
+                //[1] are added on top of the nominal ones
+                // [1] https://indico.cern.ch/event/724150/#14-dijet-with-2016-legacy-data
+                std::string const jerClosureLevel =
+                  "Summer16_07Aug2017_V6_MPF_LOGLIN_L2Residual_pythia8_AK4PFchs_"s +
+                  ((systDirection == SystService::VarDirection::Up) ? "JERup" : "JERdown") + ".txt";
+                
+                for (auto const &period: jecPeriods)
+                {
+                    string const jecVersion = "Summer16_07Aug2017" + period.label + "_V11";
+                    
+                    vector<string> jecLevels{jecVersion + "_DATA_L1FastJet_AK4PFchs.txt",
+                      jecVersion + "_DATA_L2Relative_AK4PFchs.txt",
+                      jecVersion + "_DATA_L3Absolute_AK4PFchs.txt"};
+                    
+                    if (not optionsMap.count("no-res"))
+                    {
+                        if (optionsMap.count("l3-res"))
+                            jecLevels.emplace_back(jecVersion + "_DATA_L2L3Residual_AK4PFchs.txt");
+                        else
+                        {
+                            jecLevels.emplace_back(jecVersion + "_DATA_L2Residual_AK4PFchs.txt");
+                            
+                            if (systType == SystType::JER)
+                                jecLevels.emplace_back(jerClosureLevel);
+                        }
+                    }
+                    
+                    jetCorr->SetJEC("2016" + period.label, jecLevels,
+                      {jecVersion + "_DATA_L1RC_AK4PFchs.txt"});
+                }
+                
+                manager.RegisterService(jetCorr);
+                
+                jetmetUpdater = new JERCJetMETUpdate("JetMET" + suffix, "", "");
+                jetmetUpdater->SetBatchCorrector("JetCorr" + suffix);
+            }
+            else
+            {
+                JetCorrectorService *jetCorrFull = new JetCorrectorService("JetCorrFull" + suffix);
+                string const jecVersion("Summer16_07Aug2017_V11");
+                
+                jetCorrFull->SetJEC({jecVersion + "_MC_L1FastJet_AK4PFchs.txt",
+                  jecVersion + "_MC_L2Relative_AK4PFchs.txt",
+                  jecVersion + "_MC_L3Absolute_AK4PFchs.txt"});
+                jetCorrFull->SetJER("Summer16_25nsV1_MC_SF_AK4PFchs.txt",
+                  "Summer16_25nsV1_MC_PtResolution_AK4PFchs.txt");
+                
+                if (systType == SystType::L1Res)
+                    jetCorrFull->SetJECUncertainty(
+                      jecVersion + "_MC_UncertaintySources_AK4PFchs.txt",
+                      {"PileUpPtBB", "PileUpPtEC1", "PileUpPtEC2", "PileUpPtHF", "PileUpDataMC"});
+                else if (systType == SystType::L2Res)
+                    jetCorrFull->SetJECUncertainty(
+                      jecVersion + "_MC_UncertaintySources_AK4PFchs.txt",
+                      {"RelativePtBB", "RelativePtEC1", "RelativePtEC2", "RelativePtHF",
+                       "RelativeBal", "RelativeSample", "RelativeFSR",
+                       "RelativeStatFSR", "RelativeStatEC", "RelativeStatHF"});
+                
+                manager.RegisterService(jetCorrFull);
+                
+                jetmetUpdater = new JERCJetMETUpdate("JetMET" + suffix, "JetCorrFull" + suffix,
+                  "JetCorrL1");
+            }
+            
+            startupTimer.EndPhase("Jet corrections" + phaseSuffix);
+            
+            
+            // Recorrect jets and apply T1 MET corrections to raw MET. In real data, systematic
+            //variations only affect the choice of corrections.
+            jetmetUpdater->SetT1Threshold(15., 20.);
+            jetmetUpdater->SetFillStandardJets(false);
+            
+            if (not isSim or systType == SystType::None)
+                jetmetUpdater->SetSystematics(JetCorrectorService::SystType::None,
+                  SystService::VarDirection::Undefined);
+            else if (systType == SystType::JER)
+                jetmetUpdater->SetSystematics(JetCorrectorService::SystType::JER, systDirection);
+            else
+                jetmetUpdater->SetSystematics(JetCorrectorService::SystType::JEC, systDirection);
+            
+            // Selection on the leading jet. Most events are rejected by it, and in real data the
+            //updater only corrects the remaining jets if the leading one passes.
+            double const leadMinPt = 150.;
+            double const leadMaxAbsEta = (optionsMap.count("wide")) ? 2.4 : 1.3;
+            
+            if (not isSim)
+                jetmetUpdater->SetLazyLeadingJetCut(leadMinPt, leadMaxAbsEta);
+            
+            if (multiSyst)
+                registerPlugin(jetmetUpdater, {"TriggerObjects"});
+            else
+                registerPlugin(jetmetUpdater);
+            
+            
+            FirstJetFilter *firstJetFilter = new FirstJetFilter("FirstJetFilter" + suffix,
+              leadMinPt, leadMaxAbsEta);
+            firstJetFilter->SetJetMETPluginName("JetMET" + suffix);
+            registerPlugin(firstJetFilter);
+            
+            JetIDFilter *jetIDFilter = new JetIDFilter("JetIDFilter" + suffix, 15.);
+            jetIDFilter->SetJetMETPluginName("JetMET" + suffix);
+            registerPlugin(jetIDFilter);
+            
+            if (not isSim)
+            {
+                EtaPhiFilter *etaPhiFilter = new EtaPhiFilter("EtaPhiFilter" + suffix, 15.);
+                etaPhiFilter->SetJetMETPluginName("JetMET" + suffix);
+                
+                for (auto const &r: etaPhiRegions)
+                    etaPhiFilter->AddRegion(r.minRun, r.maxRun, r.startEta, r.endEta,
+                      r.startPhi, r.endPhi);
+                
+                registerPlugin(etaPhiFilter);
+            }
+            else
+            {
+                if (not multiSyst)
+                    registerPlugin(new PECGenParticleReader);
+                
+                GenMatchFilter *genMatchFilter = new GenMatchFilter("GenMatchFilter" + suffix,
+                  0.2, 0.5);
+                genMatchFilter->SetJetMETPluginName("JetMET" + suffix);
+                registerPlugin(genMatchFilter);
+                
+                registerPlugin(new MPIMatchFilter("MPIMatchFilter" + suffix, 0.4));
+            }
+            
+            if (useSkimCache)
+            {
+                registerPlugin(new PECTriggerObjectReader);
+                registerPlugin(new SkimCacheWriter("SkimCacheWriter", skimCacheDir,
+                  skimCacheKey, triggerFilters));
+            }
+        }
+        
+        // Kinematic quantities of jets used in the angular selection, balance observables, and
+        //by the plugins for individual trigger bins are computed once per event
+        JetKinematics *jetKinematics = new JetKinematics("JetKinematics" + suffix);
+        jetKinematics->SetJetMETPluginName("JetMET" + suffix);
+        registerPlugin(jetKinematics);
+        
+        // Set angular selection based on [1-3]
+        //[1] https://indico.cern.ch/event/749862/#2-l3res-multijet-update
+        //[2] https://indico.cern.ch/event/759977/#28-ideas-on-multijet
+        AngularFilter *angularFilter = new AngularFilter("AngularFilter" + suffix);
+        angularFilter->SetJetKinematicsName("JetKinematics" + suffix);
+        angularFilter->SetDPhi12Cut(2., 2.9);
+        angularFilter->SetDPhi23Cut(0., 1.);
+        registerPlugin(angularFilter);
+        
+        BalanceCalc *balanceCalc = new BalanceCalc("BalanceCalc" + suffix, 30., 33.);
+        balanceCalc->SetJetMETPluginName("JetMET" + suffix);
+        balanceCalc->SetJetKinematicsName("JetKinematics" + suffix);
+        registerPlugin(balanceCalc);
+        
+        // Remove strongly imbalanced events in the high-pt region. This is a temporary solution to
+        //the problem described in [1].
+        //[1] https://indico.cern.ch/event/720429/#7-unhealthy-high-pt-electrons
+        BalanceFilter *balanceFilter = new BalanceFilter("BalanceFilter" + suffix, 0.5, 1.5);
+        balanceFilter->SetJetMETPluginName("JetMET" + suffix);
+        balanceFilter->SetBalanceCalcName("BalanceCalc" + suffix);
+        balanceFilter->SetMinPtLead(1000.);
+        registerPlugin(balanceFilter);
+
+
+        if (isSim)
+        {
+            if (not multiSyst)
+            {
+                auto *generatorReader = new PECGeneratorReader;
+                generatorReader->RequestAltWeights();
+                registerPlugin(generatorReader);
+            }
             
-            BalanceHists *balanceHists = new BalanceHists("BalanceHists"s + trigger, 10.);
-            balanceHists->SetDirectoryName(trigger);
-            manager.RegisterPlugin(balanceHists);
+            auto *prefiringWeights = new L1TPrefiringWeights("L1TPrefiringWeights" + suffix,
+              config.Get({"period_weight_config"}).asString());
+            prefiringWeights->SetJetMETPluginName("JetMET" + suffix);
+            registerPlugin(prefiringWeights);
         }
+        
+        
+        // In the skim cache mode, trigger objects are either read before the cache writer or not
+        //needed at all since the results of the matching are stored in the cache
+        if (not multiSyst and not useSkimCache)
+            registerPlugin(new PECTriggerObjectReader);
+        
+        // Trigger bins are found for all triggers at once. Each bin then starts its own chain of
+        //plugins with a gate that checks the decision of the dispatcher.
+        TriggerBinDispatcher *triggerBins = new TriggerBinDispatcher("TriggerBins" + suffix,
+          triggerConfigPath, isSim);
+        triggerBins->SetJetMETPluginName("JetMET" + suffix);
+        
+        if (replaySkim)
+            triggerBins->SetTriggerObjectsPluginName("InputData");
+        
+        registerPlugin(triggerBins, {"BalanceFilter" + suffix});
+        
+        // By default, each producer of variables writes its own tree in the directory of the
+        //trigger bin. With option --merged-trees they all write into a common tree "Vars".
+        bool const mergedTrees = optionsMap.count("merged-trees");
+        
+        for (auto const &trigger: triggerNames)
+        {
+            registerPlugin(new TriggerBinGate("TriggerFilter"s + trigger + suffix,
+              "TriggerBins" + suffix, trigger), {"TriggerBins" + suffix});
+            
+            std::string const sharedTreeName = (mergedTrees) ? "Tree"s + trigger + suffix : "";
+            
+            if (mergedTrees)
+            {
+                SharedTree *sharedTree = new SharedTree(sharedTreeName, trigger + "/Vars");
+                sharedTree->SetFileServiceName("TFileService" + suffix);
+                registerPlugin(sharedTree);
+            }
+            
+            BalanceVars *balanceVars = new BalanceVars("BalanceVars"s + trigger + suffix, 30.);
+            balanceVars->SetFileServiceName("TFileService" + suffix);
+            balanceVars->SetJetMETPluginName("JetMET" + suffix);
+            balanceVars->SetJetKinematicsName("JetKinematics" + suffix);
+            balanceVars->SetBalanceCalcName("BalanceCalc" + suffix);
+            balanceVars->SetTreeName(trigger + "/BalanceVars");
+            balanceVars->SetSharedTreeName(sharedTreeName);
+            registerPlugin(balanceVars);
+            
+            PileUpVars *puVars = new PileUpVars("PileUpVars"s + trigger + suffix);
+            puVars->SetFileServiceName("TFileService" + suffix);
+            puVars->SetTreeName(trigger + "/PileUpVars");
+            puVars->SetSharedTreeName(sharedTreeName);
+            registerPlugin(puVars);
+            
+            if (isSim)
+            {
+                auto *weights = new GenWeights("GenWeights" + trigger + suffix);
+                weights->SetFileServiceName("TFileService" + suffix);
+                weights->SetTreeName(trigger + "/GenWeights");
+                weights->SetSharedTreeName(sharedTreeName);
+                weights->SetGeneratorReader("Generator");
+                registerPlugin(weights);
+
+                PeriodWeights *periodWeights = new PeriodWeights(
+                  "PeriodWeights" + trigger + suffix,
+                  config.Get({"period_weight_config"}).asString(), trigger);
+                periodWeights->SetFileServiceName("TFileService" + suffix);
+                periodWeights->SetPrefiringWeightPlugin("L1TPrefiringWeights" + suffix);
+                periodWeights->SetTreeName(trigger + "/PeriodWeights");
+                periodWeights->SetSharedTreeName(sharedTreeName);
+                registerPlugin(periodWeights);
+
+                SimBalanceHists *balanceHists = new SimBalanceHists(
+                  "SimBalanceHists"s + trigger + suffix);
+                balanceHists->SetFileServiceName("TFileService" + suffix);
+                balanceHists->SetJetMETPluginName("JetMET" + suffix);
+                balanceHists->SetBalanceCalcName("BalanceCalc" + suffix);
+                balanceHists->SetGenWeightsName("GenWeights" + trigger + suffix);
+                balanceHists->SetPeriodWeightsName("PeriodWeights" + trigger + suffix);
+                balanceHists->SetDirectoryName(trigger);
+                registerPlugin(balanceHists);
+            }
+            else
+            {
+                DumpEventID *eventID = new DumpEventID("EventID"s + trigger + suffix);
+                eventID->SetFileServiceName("TFileService" + suffix);
+                eventID->SetTreeName(trigger + "/EventID");
+                eventID->SetSharedTreeName(sharedTreeName);
+                registerPlugin(eventID);
+                
+                BalanceHists *balanceHists = new BalanceHists("BalanceHists"s + trigger + suffix,
+                  10.);
+                balanceHists->SetFileServiceName("TFileService" + suffix);
+                balanceHists->SetJetMETPluginName("JetMET" + suffix);
+                balanceHists->SetJetKinematicsName("JetKinematics" + suffix);
+                balanceHists->SetBalanceCalcName("BalanceCalc" + suffix);
+                balanceHists->SetDirectoryName(trigger);
+                registerPlugin(balanceHists);
+            }
+            
+            if (mergedTrees)
+                registerPlugin(new SharedTreeFiller("TreeFiller"s + trigger + suffix,
+                  sharedTreeName));
+        }
+        
+        startupTimer.EndPhase("Plugins and services" + phaseSuffix);
+    }
+    
+    
+    if (optionsMap.count("benchmark-startup"))
+    {
+        // Include the time needed to finish reading of jet corrections in the background
+        for (auto *jetCorr: batchCorrectors)
+            jetCorr->FinishLoading();
+        
+        startupTimer.EndPhase("Deferred jet corrections");
+        startupTimer.Print(std::cout);
+        return EXIT_SUCCESS;
     }
     
     
@@ -449,15 +936,20 @@ int main(int argc, char **argv)
     std::cout << '\n';
     manager.PrintSummary();
     
+    if (pluginStats)
+        pluginStats->WriteJSON(optionsMap["plugin-stats"].as<string>());
+    
     
     return EXIT_SUCCESS;
 }
 
 
-std::list<Dataset> BuildDatasets(std::vector<std::string> const &inputs, Config const &config)
+std::list<Dataset> BuildDatasets(std::vector<std::string> const &inputs, Config const &config,
+  PartitionRanges &partitionRanges)
 {
     std::list<Dataset> datasets;
     DatasetBuilder datasetBuilder(config.Get({"samples", "definition_file"}).asString());
+    auto const &samplesNode = config.Get({"samples"});
 
     if (inputs.size() == 1)
     {
@@ -476,7 +968,41 @@ std::list<Dataset> BuildDatasets(std::vector<std::string> const &inputs, Config
         for (unsigned i = 0; i < sampleGroupNode.size(); ++i)
         {
             std::string const datasetId = sampleGroupNode[i].asString();
-            datasets.splice(datasets.end(), datasetBuilder(datasetId));
+
+            if (not samplesNode.isMember("partitions") or
+              not samplesNode["partitions"].isMember(datasetId))
+            {
+                datasets.splice(datasets.end(), datasetBuilder(datasetId));
+                continue;
+            }
+
+
+            // This data set is a partition of another one. Include only files that contain
+            //entries from this partition and record the ranges of these entries. The same file
+            //can be included in several partitions, which are then read independently.
+            auto const &partitionNode = samplesNode["partitions"][datasetId];
+            std::string const sourceId = partitionNode["source"].asString();
+            unsigned const partition = partitionNode["partition"].asUInt();
+            Dataset dataset = datasetBuilder.BuildEmpty(datasetId);
+
+            for (auto const &sourceDataset: datasetBuilder(sourceId))
+                for (auto const &file: sourceDataset.GetFiles())
+                {
+                    auto const index = PartitionIndex::Read(PartitionIndex::GetPath(file.name));
+                    auto const ranges = index.GetRanges(partition);
+
+                    if (ranges.empty())
+                        continue;
+
+                    dataset.AddFile(file.name);
+
+                    // Ranges are only needed if the file also contains entries from other
+                    //partitions
+                    if (ranges.size() < index.GetRanges().size())
+                        partitionRanges[{datasetId, file.name}] = ranges;
+                }
+
+            datasets.emplace_back(std::move(dataset));
         }
     }
     else
@@ -505,3 +1031,95 @@ std::list<Dataset> BuildDatasets(std::vector<std::string> const &inputs, Config
     return datasets;
 }
 
+
+std::vector<Variation> ParseVariations(std::string const &systArg, bool isSim)
+{
+    std::vector<Variation> variations;
+    std::string const systArgLower{boost::to_lower_copy(systArg)};
+    
+    if (systArgLower.empty())
+        variations.push_back({SystType::None, SystService::VarDirection::Undefined});
+    else if (systArgLower == "all")
+    {
+        variations.push_back({SystType::None, SystService::VarDirection::Undefined});
+        
+        // In real data, only the JER variation has an effect
+        std::vector<SystType> systTypes{SystType::JER};
+        
+        if (isSim)
+            systTypes.insert(systTypes.begin(), {SystType::L1Res, SystType::L2Res});
+        
+        for (auto const &systType: systTypes)
+            for (auto const &direction:
+              {SystService::VarDirection::Up, SystService::VarDirection::Down})
+                variations.push_back({systType, direction});
+    }
+    else
+    {
+        std::vector<std::string> systLabels;
+        boost::split(systLabels, systArgLower, boost::is_any_of(","));
+        
+        std::regex systRegex("(l1res|l2res|jer)[-_]?(up|down)", std::regex::extended);
+        std::smatch matchResult;
+        
+        for (auto const &systLabel: systLabels)
+        {
+            Variation variation{SystType::None, SystService::VarDirection::Undefined};
+            
+            if (systLabel == "nominal")
+            {
+                // Keep the default-constructed variation
+            }
+            else if (not std::regex_match(systLabel, matchResult, systRegex))
+            {
+                cerr << "Cannot recognize systematic variation \"" << systLabel << "\".\n";
+                std::exit(EXIT_FAILURE);
+            }
+            else
+            {
+                if (matchResult[1] == "l1res")
+                    variation.type = SystType::L1Res;
+                else if (matchResult[1] == "l2res")
+                    variation.type = SystType::L2Res;
+                else if (matchResult[1] == "jer")
+                    variation.type = SystType::JER;
+                
+                if (matchResult[2] == "up")
+                    variation.direction = SystService::VarDirection::Up;
+                else if (matchResult[2] == "down")
+                    variation.direction = SystService::VarDirection::Down;
+            }
+            
+            // Variations must be unique since they are used to construct names of plugins and
+            //output directories
+            for (auto const &v: variations)
+            {
+                if (v.type == variation.type and v.direction == variation.direction)
+                {
+                    cerr << "Systematic variation \"" << systLabel << "\" is requested twice.\n";
+                    std::exit(EXIT_FAILURE);
+                }
+            }
+            
+            variations.emplace_back(variation);
+        }
+    }
+    
+    return variations;
+}
+
+
+std::string GetVariationLabel(Variation const &variation)
+{
+    if (variation.type == SystType::None)
+        return "nominal";
+    
+    std::string label{boost::to_lower_copy(systTypeToString(variation.type))};
+    
+    if (variation.direction == SystService::VarDirection::Up)
+        label += "_up";
+    else
+        label += "_down";
+    
+    return label;
+}
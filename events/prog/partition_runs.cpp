@@ -3,11 +3,25 @@
  *
  * A program to split a PEC file into multiple ones based on run numbers. Each partition includes
  * its left boundary. The in-file directory structure is reproduced.
+ *
+ * Since runs are stored contiguously, each file is split into ranges of entries that belong to
+ * the same partition. They are found in a first pass that reads only the tree with event IDs. If
+ * all entries of a file belong to the same partition, trees are copied with fast cloning, without
+ * decompressing the baskets. Otherwise entries are copied one by one: fast cloning operates on
+ * whole baskets and cannot stop at a partition boundary inside a basket. Several files can be
+ * processed in parallel. If processing of a file fails, no further files are started, and the
+ * error is reported once all running jobs have finished.
+ *
+ * Alternatively, the program can only write an index that describes the partitioning, without
+ * copying the files. See documentation for class PartitionIndex.
  */
 
+#include <PartitionIndex.hpp>
+
 #include <EventID.hpp>
 
 #include <TFile.h>
+#include <TROOT.h>
 #include <TTree.h>
 
 #include <boost/algorithm/string.hpp>
@@ -15,15 +29,20 @@
 #include <boost/program_options.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <exception>
 #include <filesystem>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <regex>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 
@@ -32,21 +51,34 @@ namespace po = boost::program_options;
 using split_string = boost::algorithm::split_iterator<std::string::const_iterator>;
 
 
+/// Mutex to serialize printing from different threads
+std::mutex printMutex;
+
+
 /**
  * \brief Recursively searches for trees in given file
  *
  * Returns a map from in-file paths to corresponding trees. The trees are owned by the given file
- * object.
+ * object. Throws an exception if the file contains objects of unexpected types or no trees.
  */
 std::map<fs::path, TTree *> FindTrees(TFile &srcFile);
 
+/**
+ * \brief Finds ranges of entries that belong to the same partitions
+ *
+ * Only the tree with event IDs is read.
+ */
+PartitionIndex BuildIndex(TTree *eventIdTree, std::vector<unsigned long> const &runs);
+
 /**
  * \brief Splits given file into multiple based on run numbers
  *
  * The partition boundaries given as an argument must be sorted. A partition includes its left
- * boundary.
+ * boundary. If indexOnly is true, the file is not split, and only the index describing the
+ * partitioning is written. Throws an exception in case of an error.
  */
-void PartitionFile(fs::path const &inputPath, std::vector<int> const &runs);
+void PartitionFile(fs::path const &inputPath, std::vector<unsigned long> const &runs,
+  bool indexOnly);
 
 
 int main(int argc, char **argv)
@@ -55,7 +87,10 @@ int main(int argc, char **argv)
     options.add_options()
       ("input_files", po::value<std::vector<std::string>>(), "Input files")
       ("help,h", "Prints help message")
-      ("runs,r", po::value<std::string>(), "Comma-separated list of runs for partitioning");
+      ("runs,r", po::value<std::string>(), "Comma-separated list of runs for partitioning")
+      ("jobs,j", po::value<unsigned>()->default_value(1),
+        "Number of files to process in parallel")
+      ("index-only", "Only write partition indices instead of splitting the files");
 
     po::positional_options_description positionalOptions;
     positionalOptions.add("input_files", -1);
@@ -86,13 +121,13 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
-    std::vector<int> runs;
+    std::vector<unsigned long> runs;
     std::string const runsText = optionMap["runs"].as<std::string>();
     split_string it = boost::algorithm::make_split_iterator(
       runsText, boost::algorithm::token_finder([](char const c){return c == ',';}));
 
     for (; it != split_string(); ++it)
-        runs.emplace_back(boost::lexical_cast<int>(*it));
+        runs.emplace_back(boost::lexical_cast<unsigned long>(*it));
 
     if (not std::is_sorted(runs.begin(), runs.end()))
     {
@@ -101,10 +136,67 @@ int main(int argc, char **argv)
     }
 
 
-    for (fs::path const path: optionMap["input_files"].as<std::vector<std::string>>())
+    // Process input files in parallel. Each thread takes the next file from the common list. The
+    //first error is saved and reported from the main thread, and no new files are started after
+    //it.
+    auto const inputFiles = optionMap["input_files"].as<std::vector<std::string>>();
+    unsigned const numJobs = std::max(1u, std::min<unsigned>(optionMap["jobs"].as<unsigned>(),
+      inputFiles.size()));
+    bool const indexOnly = optionMap.count("index-only");
+    std::atomic<unsigned> nextFile{0};
+    std::atomic<bool> failed{false};
+    std::string errorMessage;
+
+    auto processFiles = [&inputFiles, &runs, indexOnly, &nextFile, &failed, &errorMessage]()
     {
-        std::cerr << "Processing file " << path << std::endl;
-        PartitionFile(path, runs);
+        unsigned i;
+
+        while (not failed and (i = nextFile++) < inputFiles.size())
+        {
+            fs::path const path{inputFiles[i]};
+
+            {
+                std::lock_guard<std::mutex> lock(printMutex);
+                std::cerr << "Processing file " << path << std::endl;
+            }
+
+            try
+            {
+                PartitionFile(path, runs, indexOnly);
+            }
+            catch (std::exception const &e)
+            {
+                std::lock_guard<std::mutex> lock(printMutex);
+
+                if (not failed)
+                {
+                    errorMessage = e.what();
+                    failed = true;
+                }
+
+                return;
+            }
+        }
+    };
+
+    if (numJobs == 1)
+        processFiles();
+    else
+    {
+        ROOT::EnableThreadSafety();
+        std::vector<std::thread> threads;
+
+        for (unsigned i = 0; i < numJobs; ++i)
+            threads.emplace_back(processFiles);
+
+        for (auto &thread: threads)
+            thread.join();
+    }
+
+    if (failed)
+    {
+        std::cerr << errorMessage << std::endl;
+        return EXIT_FAILURE;
     }
 
 
@@ -112,7 +204,31 @@ int main(int argc, char **argv)
 }
 
 
-void PartitionFile(fs::path const &inputPath, std::vector<int> const &runs)
+PartitionIndex BuildIndex(TTree *eventIdTree, std::vector<unsigned long> const &runs)
+{
+    pec::EventID *eventId = nullptr;
+    eventIdTree->SetBranchAddress("eventId", &eventId);
+
+    PartitionIndex index{runs};
+    int64_t const numEntries = eventIdTree->GetEntries();
+
+    for (int64_t iEntry = 0; iEntry < numEntries; ++iEntry)
+    {
+        eventIdTree->GetEntry(iEntry);
+        index.AddEntry(eventId->RunNumber());
+    }
+
+
+    // Release the buffer so that the tree can be cloned
+    eventIdTree->ResetBranchAddresses();
+    delete eventId;
+
+    return index;
+}
+
+
+void PartitionFile(fs::path const &inputPath, std::vector<unsigned long> const &runs,
+  bool indexOnly)
 {
     std::string const filename{inputPath.filename()};
     std::regex const filenameRegex{"^(.*?)((\\.part\\d+)\\.root)$"};
@@ -120,91 +236,115 @@ void PartitionFile(fs::path const &inputPath, std::vector<int> const &runs)
 
     if (not std::regex_match(filename, matchResults, filenameRegex))
     {
-        std::cerr << "Unexpected format of filename in " << inputPath << "." << std::endl;
-        std::exit(EXIT_FAILURE);
+        std::ostringstream message;
+        message << "Unexpected format of filename in " << inputPath << ".";
+        throw std::runtime_error(message.str());
     }
 
     TFile inputFile{inputPath.c_str()};
     
     if (inputFile.IsZombie())
     {
-        std::cerr << "Failed to open file " << inputPath << "." << std::endl;
-        std::exit(EXIT_FAILURE);
+        std::ostringstream message;
+        message << "Failed to open file " << inputPath << ".";
+        throw std::runtime_error(message.str());
     }
 
-    std::vector<std::unique_ptr<TFile>> outputFiles;
 
-    for (unsigned i = 0; i < runs.size() + 1; ++i)
+    // Find trees in the input file and ranges of entries that belong to each partition
+    auto srcTrees = FindTrees(inputFile);
+    auto const eventIdTree = srcTrees.find("pecEventID/EventID");
+
+    if (eventIdTree == srcTrees.end())
     {
-        std::ostringstream name;
-        name << matchResults[1] << i + 1 << matchResults[2];
-        outputFiles.emplace_back(new TFile(name.str().c_str(), "recreate"));
+        std::ostringstream message;
+        message << "File " << inputPath << " does not contain tree \"pecEventID/EventID\".";
+        throw std::runtime_error(message.str());
     }
 
+    auto const index = BuildIndex(eventIdTree->second, runs);
+    auto const &ranges = index.GetRanges();
 
-    // Find trees in the input file and create their empty clones in all output files
-    auto srcTrees = FindTrees(inputFile);
-    std::vector<std::map<fs::path, TTree *>> outTrees{outputFiles.size()};
+    if (indexOnly)
+    {
+        index.Write(PartitionIndex::GetPath(inputPath.string()));
+        return;
+    }
+
+
+    // Create output files only for partitions that contain some entries. Partitions in the index
+    //are numbered from 1.
+    std::vector<std::unique_ptr<TFile>> outputFiles(runs.size() + 1);
 
-    for (unsigned iFile = 0; iFile < outputFiles.size(); ++iFile)
+    for (auto const &range: ranges)
     {
-        auto &outputFile = outputFiles[iFile];
+        auto &outputFile = outputFiles[range.partition - 1];
 
-        for (auto &[path, srcTree]: srcTrees)
+        if (outputFile)
+            continue;
+
+        std::ostringstream name;
+        name << matchResults[1] << range.partition << matchResults[2];
+        outputFile.reset(new TFile(name.str().c_str(), "recreate"));
+    }
+
+
+    // Copy trees tree by tree, so that only one of them is decompressed at a time
+    for (auto &[path, srcTree]: srcTrees)
+    {
+        auto const curDirectoryPath = path.parent_path();
+
+        if (ranges.size() == 1)
         {
-            auto const curDirectoryPath = path.parent_path();
+            // All entries belong to the same partition. Copy the baskets without decompressing
+            //them.
+            auto &outputFile = outputFiles[ranges.front().partition - 1];
             outputFile->mkdir(curDirectoryPath.c_str());
             outputFile->cd(curDirectoryPath.c_str());
-
-            outTrees[iFile][path] = srcTree->CloneTree(0);
+            srcTree->CloneTree(-1, "fast");
             // The clonned tree is associated with the current directory in the output file
+            continue;
         }
-    }
-
 
-    // Set up reading of event ID trees, which is needed for the partitioning
-    auto srcEventIdTree = srcTrees.at("pecEventID/EventID");
-    pec::EventID *eventId = nullptr;
-    srcEventIdTree->SetBranchAddress("eventId", &eventId);
+        std::vector<TTree *> outTrees(outputFiles.size(), nullptr);
 
+        for (unsigned iFile = 0; iFile < outputFiles.size(); ++iFile)
+        {
+            auto &outputFile = outputFiles[iFile];
 
-    // Copy entries to output trees, while keeping track of the number of entries written
-    std::vector<int64_t> outCounts(outputFiles.size(), 0);
+            if (not outputFile)
+                continue;
 
-    for (int64_t iEntry = 0; iEntry < srcEventIdTree->GetEntries(); ++iEntry)
-    {
-        for (auto p: srcTrees)
-            p.second->GetEntry(iEntry);
-
-        int const curRun = eventId->RunNumber();
-        int const partition = std::upper_bound(runs.begin(), runs.end(), curRun) - runs.begin();
+            outputFile->mkdir(curDirectoryPath.c_str());
+            outputFile->cd(curDirectoryPath.c_str());
+            outTrees[iFile] = srcTree->CloneTree(0);
+        }
 
-        for (auto p: outTrees[partition])
-            p.second->Fill();
+        // Baskets at partition boundaries contain entries from two partitions, so fast cloning,
+        //which copies whole baskets, cannot be used here
+        for (auto const &range: ranges)
+        {
+            TTree *outTree = outTrees[range.partition - 1];
 
-        ++outCounts[partition];
+            for (int64_t iEntry = range.begin; iEntry < range.end; ++iEntry)
+            {
+                srcTree->GetEntry(iEntry);
+                outTree->Fill();
+            }
+        }
     }
 
 
     for (auto &outputFile: outputFiles)
     {
+        if (not outputFile)
+            continue;
+
         outputFile->Write();
         outputFile->Close();
     }
 
     inputFile.Close();
-
-
-    // If there happen to be empty output files, remove them
-    for (unsigned i = 0; i < outCounts.size(); ++i)
-    {
-        if (outCounts[i] == 0)
-        {
-            fs::path const path{outputFiles[i]->GetName()};
-            std::cerr << "Output file " << path << " is empty. Removing it." << std::endl;
-            fs::remove(path);
-        }
-    }
 }
 
 
@@ -238,17 +378,19 @@ std::map<fs::path, TTree *> FindTrees(TFile &srcFile)
                 treeMap[curDirectoryPath / name] = dynamic_cast<TTree *>(key->ReadObj());
             else
             {
-                std::cerr << "Object " << curDirectoryPath / name << " has unexpected type \"" <<
-                  className << "\"." << std::endl;
-                std::exit(EXIT_FAILURE);
+                std::ostringstream message;
+                message << "Object " << curDirectoryPath / name << " in file \"" <<
+                  srcFile.GetName() << "\" has unexpected type \"" << className << "\".";
+                throw std::runtime_error(message.str());
             }
         }
     }
 
     if (treeMap.empty())
     {
-        std::cerr << "No trees found in input file." << std::endl;
-        std::exit(EXIT_FAILURE);
+        std::ostringstream message;
+        message << "No trees found in file \"" << srcFile.GetName() << "\".";
+        throw std::runtime_error(message.str());
     }
 
 
@@ -260,7 +402,11 @@ std::map<fs::path, TTree *> FindTrees(TFile &srcFile)
     while (treeIt != treeMap.end())
     {
         if (treeIt->second->GetEntries() != numEntries)
-            std::cerr << "WARNING: Numbers of entries in source trees do not agree." << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(printMutex);
+            std::cerr << "WARNING: Numbers of entries in source trees in file \"" <<
+              srcFile.GetName() << "\" do not agree." << std::endl;
+        }
 
         ++treeIt;
     }
@@ -0,0 +1,354 @@
+/**
+ * \file validate_jec.cpp
+ *
+ * A program to validate BatchJetCorrectorService against JetCorrectorService from mensura. Both
+ * services are given the same chain of correction levels, and correction factors are compared
+ * for a set of jets. To check individual levels, the comparison is repeated for each leading part
+ * of the chain: first for the first level alone, then for the first two levels, and so on.
+ *
+ * Jets are placed on a grid in eta and pt and are also scanned in jet area and rho. In addition,
+ * each variable is probed at every edge of the bins and of the clamping ranges of the
+ * parametrization found in the given files, as well as slightly below and above it. The offset is
+ * much larger than the precision of float, in which JetCorrectorService stores the tables, so
+ * that both services are expected to agree on which side of an edge the jet falls. Ranges of pt in
+ * levels other than the first one apply to pt with previous corrections included and are
+ * therefore only probed approximately.
+ *
+ * The program also checks that no factor exceeds the upper bound returned by
+ * BatchJetCorrectorService::GetMaxFullFactor. This bound is found by sampling the formulas and is
+ * relied upon in the lazy mode of JERCJetMETUpdate, which must then select the same leading jet
+ * as when all jets are corrected.
+ *
+ * File names are resolved with FileInPath under a subdirectory "JERC", as in the services. The
+ * program reports the largest relative difference for each part of the chain and exits with a
+ * failure status if it exceeds the tolerance or if the bound is violated.
+ */
+
+#include <BatchJetCorrectorService.hpp>
+#include <JetCorrectionLevel.hpp>
+
+#include <mensura/FileInPath.hpp>
+#include <mensura/JetCorrectorService.hpp>
+#include <mensura/PhysicsObjects.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <TLorentzVector.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace po = boost::program_options;
+using Variable = JetCorrectionLevel::Variable;
+
+
+/// Jets with a common value of rho, as required by BatchJetCorrectorService
+struct JetBatch
+{
+    double rho;
+    std::vector<double> pt, eta, area;
+};
+
+
+/// Summary of the comparison for a chain of corrections
+struct Comparison
+{
+    /// Number of compared jets
+    std::size_t numJets;
+
+    /// Number of jets whose factors differ by more than the tolerance
+    std::size_t numFailed;
+
+    /// Largest relative difference and properties of the jet for which it is found
+    double maxDiff;
+    double pt, eta, area, rho;
+    double batchFactor, refFactor;
+
+    /// Upper bound on the factor, the largest factor found, and the number of jets above the bound
+    double bound, maxFactor;
+    std::size_t numAboveBound;
+};
+
+
+/**
+ * \brief Adds values at the given edges and slightly below and above them
+ *
+ * Only values in the range [minValue, maxValue] are added.
+ */
+void AddEdgeProbes(std::vector<double> &values, std::vector<double> const &edges, double minValue,
+  double maxValue);
+
+
+/// Builds batches of jets to be used in the comparison
+std::vector<JetBatch> BuildJets(
+  std::vector<std::shared_ptr<JetCorrectionLevel const>> const &levels);
+
+
+/// Compares the two services for the given chain of corrections
+Comparison Compare(std::vector<std::string> const &fileNames, std::vector<JetBatch> const &batches,
+  double tolerance);
+
+
+/// Sorts the given values and removes duplicates
+void SortUnique(std::vector<double> &values);
+
+
+int main(int argc, char **argv)
+{
+    po::options_description options("Supported options");
+    options.add_options()
+      ("levels", po::value<std::vector<std::string>>(),
+        "Files with correction levels, in the order in which they are applied")
+      ("help,h", "Prints help message")
+      ("tolerance,t", po::value<double>()->default_value(1e-4),
+        "Allowed relative difference between correction factors");
+
+    po::positional_options_description positionalOptions;
+    positionalOptions.add("levels", -1);
+
+    po::command_line_parser parser(argc, argv);
+    parser.options(options);
+    parser.positional(positionalOptions);
+
+    po::variables_map optionMap;
+    po::store(parser.run(), optionMap);
+
+    if (optionMap.count("help"))
+    {
+        std::cerr << "Usage: validate_jec [options] levels\n";
+        std::cerr << options << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (not optionMap.count("levels"))
+    {
+        std::cerr << "No correction levels provided." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+
+    auto const fileNames = optionMap["levels"].as<std::vector<std::string>>();
+    double const tolerance = optionMap["tolerance"].as<double>();
+    bool success = true;
+
+    try
+    {
+        std::vector<std::shared_ptr<JetCorrectionLevel const>> levels;
+
+        for (auto const &fileName: fileNames)
+            levels.emplace_back(JetCorrectionLevel::Load(FileInPath::Resolve("JERC", fileName)));
+
+        auto const batches = BuildJets(levels);
+
+        for (unsigned numLevels = 1; numLevels <= fileNames.size(); ++numLevels)
+        {
+            Comparison const result = Compare(
+              {fileNames.begin(), fileNames.begin() + numLevels}, batches, tolerance);
+
+            std::cout << "Levels up to " << levels[numLevels - 1]->GetName() << ": " <<
+              result.numFailed << " of " << result.numJets << " jets differ by more than " <<
+              tolerance << ". Largest relative difference " << result.maxDiff << " for pt = " <<
+              result.pt << ", eta = " << result.eta << ", area = " << result.area <<
+              ", rho = " << result.rho << " (" << result.batchFactor << " vs " <<
+              result.refFactor << ")." << std::endl;
+            std::cout << "  Largest factor " << result.maxFactor << ", upper bound " <<
+              result.bound << ", " << result.numAboveBound << " jets above the bound." <<
+              std::endl;
+
+            if (result.numFailed > 0 or result.numAboveBound > 0)
+                success = false;
+        }
+    }
+    catch (std::exception const &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+
+    return (success) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+void AddEdgeProbes(std::vector<double> &values, std::vector<double> const &edges, double minValue,
+  double maxValue)
+{
+    for (double const edge: edges)
+    {
+        if (not std::isfinite(edge))
+            continue;
+
+        double const offset = 1e-5 * std::max(std::abs(edge), 1.);
+
+        for (double const value: {edge - offset, edge, edge + offset})
+        {
+            if (value >= minValue and value <= maxValue)
+                values.emplace_back(value);
+        }
+    }
+}
+
+
+std::vector<JetBatch> BuildJets(
+  std::vector<std::shared_ptr<JetCorrectionLevel const>> const &levels)
+{
+    // Regular grids
+    std::vector<double> ptValues, coarsePtValues, etaValues, areaValues{0.2, 0.4, 0.5, 0.6, 0.8},
+      rhoValues{0., 2., 5., 10., 20., 30., 50., 80.};
+
+    for (unsigned i = 0; i <= 48; ++i)
+        ptValues.emplace_back(5. * std::pow(7000. / 5., i / 48.));
+
+    for (unsigned i = 0; i <= 6; ++i)
+        coarsePtValues.emplace_back(10. * std::pow(5000. / 10., i / 6.));
+
+    for (int i = -54; i <= 54; ++i)
+        etaValues.emplace_back(0.1 * i);
+
+
+    // Probes at edges of bins and clamping ranges
+    for (auto const &level: levels)
+    {
+        AddEdgeProbes(ptValues, level->GetEdges(Variable::JetPt), 1., 1e4);
+        AddEdgeProbes(etaValues, level->GetEdges(Variable::JetEta), -6., 6.);
+        AddEdgeProbes(areaValues, level->GetEdges(Variable::JetA), 0.01, 2.);
+        AddEdgeProbes(rhoValues, level->GetEdges(Variable::Rho), 0., 200.);
+    }
+
+    for (auto *values: {&ptValues, &etaValues, &areaValues, &rhoValues})
+        SortUnique(*values);
+
+
+    // The full grid in eta and pt, together with the scan in jet area, is built for a typical
+    //value of rho. For other values of rho, only a coarse grid in pt is used.
+    double const refRho = 20.;
+    double const refArea = 0.5;
+    std::vector<JetBatch> batches;
+
+    for (double const rho: rhoValues)
+    {
+        JetBatch batch;
+        batch.rho = rho;
+
+        for (double const eta: etaValues)
+        {
+            for (double const pt: coarsePtValues)
+            {
+                batch.pt.emplace_back(pt);
+                batch.eta.emplace_back(eta);
+                batch.area.emplace_back(refArea);
+            }
+        }
+
+        batches.emplace_back(std::move(batch));
+    }
+
+    JetBatch refBatch;
+    refBatch.rho = refRho;
+
+    for (double const eta: etaValues)
+    {
+        for (double const pt: ptValues)
+        {
+            refBatch.pt.emplace_back(pt);
+            refBatch.eta.emplace_back(eta);
+            refBatch.area.emplace_back(refArea);
+        }
+
+        for (double const area: areaValues)
+        {
+            for (double const pt: coarsePtValues)
+            {
+                refBatch.pt.emplace_back(pt);
+                refBatch.eta.emplace_back(eta);
+                refBatch.area.emplace_back(area);
+            }
+        }
+    }
+
+    batches.emplace_back(std::move(refBatch));
+    return batches;
+}
+
+
+Comparison Compare(std::vector<std::string> const &fileNames, std::vector<JetBatch> const &batches,
+  double tolerance)
+{
+    BatchJetCorrectorService batchCorr("BatchJetCorrector");
+    batchCorr.SetJEC(fileNames, {});
+    batchCorr.FinishLoading();
+
+    // The reference service is configured with a single IOV that includes all runs, in the same
+    //way as it was used for real data
+    JetCorrectorService refCorr("JetCorrector");
+    refCorr.RegisterIOV("All", 0, std::numeric_limits<unsigned long>::max());
+    refCorr.SetJEC("All", fileNames);
+    refCorr.SelectIOV(1);
+
+
+    Comparison result{};
+    result.bound = batchCorr.GetMaxFullFactor();
+    std::vector<double> fullFactors, l1Factors;
+
+    for (auto const &batch: batches)
+    {
+        std::size_t const size = batch.pt.size();
+        fullFactors.resize(size);
+        l1Factors.resize(size);
+        batchCorr.Eval({size, batch.pt.data(), batch.eta.data(), batch.area.data(), batch.rho},
+          fullFactors.data(), l1Factors.data());
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            TLorentzVector p4;
+            p4.SetPtEtaPhiM(batch.pt[i], batch.eta[i], 0., 0.);
+
+            Jet jet;
+            jet.SetCorrectedP4(p4, 1.);
+            jet.SetArea(batch.area[i]);
+
+            double const refFactor = refCorr.Eval(jet, batch.rho);
+            double const diff = std::abs(fullFactors[i] - refFactor) /
+              std::max(std::abs(refFactor), std::numeric_limits<double>::min());
+
+            ++result.numJets;
+
+            if (fullFactors[i] > result.maxFactor)
+                result.maxFactor = fullFactors[i];
+
+            if (fullFactors[i] > result.bound)
+                ++result.numAboveBound;
+
+            if (diff > tolerance)
+                ++result.numFailed;
+
+            if (diff > result.maxDiff)
+            {
+                result.maxDiff = diff;
+                result.pt = batch.pt[i];
+                result.eta = batch.eta[i];
+                result.area = batch.area[i];
+                result.rho = batch.rho;
+                result.batchFactor = fullFactors[i];
+                result.refFactor = refFactor;
+            }
+        }
+    }
+
+    return result;
+}
+
+
+void SortUnique(std::vector<double> &values)
+{
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
@@ -1,8 +1,6 @@
 #include <AngularFilter.hpp>
 
-#include <mensura/JetMETReader.hpp>
-
-#include <TVector2.h>
+#include <JetKinematics.hpp>
 
 #include <cmath>
 #include <limits>
@@ -12,7 +10,7 @@
 
 AngularFilter::AngularFilter(std::string const name):
     AnalysisPlugin(name),
-    jetmetPluginName("JetMET"), jetmetPlugin(nullptr),
+    jetKinematicsName("JetKinematics"), jetKinematics(nullptr),
     minDPhi12(0.), maxDPhi12(std::numeric_limits<double>::infinity()),
     minDPhi23(0.), maxDPhi23(std::numeric_limits<double>::infinity()),
     cutDPhi12Set(false), cutDPhi23Set(false)
@@ -21,7 +19,8 @@ AngularFilter::AngularFilter(std::string const name):
 
 void AngularFilter::BeginRun(Dataset const &)
 {
-    jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    jetKinematics =
+      dynamic_cast<JetKinematics const *>(GetDependencyPlugin(jetKinematicsName));
 }
 
 
@@ -31,6 +30,12 @@ AngularFilter *AngularFilter::Clone() const
 }
 
 
+void AngularFilter::SetJetKinematicsName(std::string const &name)
+{
+    jetKinematicsName = name;
+}
+
+
 void AngularFilter::SetDPhi12Cut(double minimum, double maximum)
 {
     minDPhi12 = minimum;
@@ -69,14 +74,14 @@ void AngularFilter::SetDPhi23Cut(double minimum, double maximum)
 
 bool AngularFilter::ProcessEvent()
 {
-    auto const &jets = jetmetPlugin->GetJets();
+    std::size_t const numJets = jetKinematics->GetNumJets();
     
     if (cutDPhi12Set)
     {
-        if (jets.size() < 2)
+        if (numJets < 2)
             return false;
         
-        double const dPhi12 = std::abs(TVector2::Phi_mpi_pi(jets[0].Phi() - jets[1].Phi()));
+        double const dPhi12 = jetKinematics->GetDPhi12();
         
         if (dPhi12 < minDPhi12 or dPhi12 > maxDPhi12)
             return false;
@@ -84,10 +89,10 @@ bool AngularFilter::ProcessEvent()
     
     if (cutDPhi23Set)
     {
-        if (jets.size() < 3)
+        if (numJets < 3)
             return false;
         
-        double const dPhi23 = std::abs(TVector2::Phi_mpi_pi(jets[1].Phi() - jets[2].Phi()));
+        double const dPhi23 = jetKinematics->GetDPhi23();
         
         if (dPhi23 < minDPhi23 or dPhi23 > maxDPhi23)
             return false;
@@ -1,5 +1,8 @@
 #include <BalanceCalc.hpp>
 
+#include <JetBlock.hpp>
+#include <JetKinematics.hpp>
+
 #include <mensura/JetMETReader.hpp>
 
 #include <cmath>
@@ -11,7 +14,8 @@ BalanceCalc::BalanceCalc(std::string const &name, double thresholdPtBalStart,
   double thresholdPtBalEnd):
     AnalysisPlugin(name),
     thresholdPtBal(thresholdPtBalStart),
-    jetmetPluginName("JetMET")
+    jetmetPluginName("JetMET"), jetmetPlugin(nullptr), jetBlock(nullptr),
+    jetKinematicsName("JetKinematics"), jetKinematics(nullptr)
 {
     if (thresholdPtBalEnd <= 0. or thresholdPtBalStart == thresholdPtBalEnd)
         turnOnPtBal = 0.;
@@ -38,6 +42,9 @@ BalanceCalc::BalanceCalc(double thresholdPtBalStart, double thresholdPtBalEnd):
 void BalanceCalc::BeginRun(Dataset const &)
 {
     jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    jetBlock = &GetJetBlock(jetmetPlugin);
+    jetKinematics =
+      dynamic_cast<JetKinematics const *>(GetDependencyPlugin(jetKinematicsName));
 }
 
 
@@ -47,6 +54,18 @@ BalanceCalc *BalanceCalc::Clone() const
 }
 
 
+void BalanceCalc::SetJetKinematicsName(std::string const &name)
+{
+    jetKinematicsName = name;
+}
+
+
+void BalanceCalc::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
 double BalanceCalc::GetMPF() const
 {
     return mpf;
@@ -61,34 +80,32 @@ double BalanceCalc::GetPtBal() const
 
 bool BalanceCalc::ProcessEvent()
 {
-    auto const &jets = jetmetPlugin->GetJets();
+    auto const &pt = jetBlock->Pt();
+    auto const &leadProjection = jetKinematics->LeadProjection();
     
-    if (jets.size() < 1)
+    if (pt.size() < 1)
         return false;
     
     
-    auto const p4Lead = jets[0].P4();
-    auto const p4Miss = jetmetPlugin->GetMET().P4();
-    mpf = 1. + (p4Miss.Px() * p4Lead.Px() + p4Miss.Py() * p4Lead.Py()) / std::pow(p4Lead.Pt(), 2);
+    double const ptLead = pt[0];
+    mpf = 1. + jetKinematics->GetMETLeadProjection() / ptLead;
     
     
     // Compute pt balance with a smooth threshold
     double s = 0.;
     
-    for (unsigned i = 1; i < jets.size(); ++i)
+    for (unsigned i = 1; i < pt.size(); ++i)
     {
-        TLorentzVector const &p4 = jets[i].P4();
-        
-        if (p4.Pt() < thresholdPtBal)
+        if (pt[i] < thresholdPtBal)
         {
             // Jets are sorted in decreasing order in pt
             break;
         }
         
-        s += p4.Pt() * std::cos(p4.Phi() - p4Lead.Phi()) * WeightJet(p4.Pt());
+        s += leadProjection[i] * WeightJet(pt[i]);
     }
     
-    ptBal = -s / p4Lead.Pt();
+    ptBal = -s / ptLead;
     
     return true;
 }
@@ -1,6 +1,7 @@
 #include <BalanceFilter.hpp>
 
 #include <BalanceCalc.hpp>
+#include <JetBlock.hpp>
 
 #include <mensura/JetMETReader.hpp>
 #include <mensura/Processor.hpp>
@@ -11,7 +12,7 @@
 BalanceFilter::BalanceFilter(std::string const &name, double minPtBal_, double maxPtBal_):
     AnalysisPlugin(name),
     minPtBal(minPtBal_), maxPtBal(maxPtBal_), minPtLead(0.),
-    jetmetPluginName("JetMET"), jetmetPlugin(nullptr),
+    jetmetPluginName("JetMET"), jetmetPlugin(nullptr), jetBlock(nullptr),
     balanceCalcName("BalanceCalc"), balanceCalc(nullptr)
 {}
 
@@ -24,6 +25,7 @@ BalanceFilter::BalanceFilter(double minPtBal, double maxPtBal):
 void BalanceFilter::BeginRun(Dataset const &)
 {
     jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    jetBlock = &GetJetBlock(jetmetPlugin);
     balanceCalc = dynamic_cast<BalanceCalc const *>(GetDependencyPlugin(balanceCalcName));
 }
 
@@ -34,6 +36,18 @@ Plugin *BalanceFilter::Clone() const
 }
 
 
+void BalanceFilter::SetBalanceCalcName(std::string const &name)
+{
+    balanceCalcName = name;
+}
+
+
+void BalanceFilter::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
 void BalanceFilter::SetMinPtLead(double minPtLead_)
 {
     minPtLead = minPtLead_;
@@ -42,13 +56,11 @@ void BalanceFilter::SetMinPtLead(double minPtLead_)
 
 bool BalanceFilter::ProcessEvent()
 {
-    auto const &jets = jetmetPlugin->GetJets();
-    
-    if (jets.size() < 2)
+    if (jetBlock->GetSize() < 2)
         return false;
     
     
-    if (jets[0].Pt() <= minPtLead)
+    if (jetBlock->Pt()[0] <= minPtLead)
     {
         // Filtering is disabled
         return true;
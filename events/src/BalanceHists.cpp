@@ -1,6 +1,8 @@
 #include <BalanceHists.hpp>
 
 #include <BalanceCalc.hpp>
+#include <JetBlock.hpp>
+#include <JetKinematics.hpp>
 
 #include <mensura/JetMETReader.hpp>
 #include <mensura/Processor.hpp>
@@ -12,7 +14,8 @@
 BalanceHists::BalanceHists(std::string const &name, double minPt_ /*= 15.*/):
     AnalysisPlugin(name),
     fileServiceName("TFileService"), fileService(nullptr),
-    jetmetPluginName("JetMET"), jetmetPlugin(nullptr),
+    jetmetPluginName("JetMET"), jetmetPlugin(nullptr), jetBlock(nullptr),
+    jetKinematicsName("JetKinematics"), jetKinematics(nullptr),
     balanceCalcName("BalanceCalc"), balanceCalc(nullptr),
     outDirectoryName(name), minPt(minPt_)
 {
@@ -51,6 +54,9 @@ void BalanceHists::BeginRun(Dataset const &)
     // Save pointers to required services and plugins
     fileService = dynamic_cast<TFileService const *>(GetMaster().GetService(fileServiceName));
     jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    jetBlock = &GetJetBlock(jetmetPlugin);
+    jetKinematics =
+      dynamic_cast<JetKinematics const *>(GetDependencyPlugin(jetKinematicsName));
     balanceCalc = dynamic_cast<BalanceCalc const *>(GetDependencyPlugin(balanceCalcName));
     
     
@@ -86,6 +92,30 @@ Plugin *BalanceHists::Clone() const
 }
 
 
+void BalanceHists::SetBalanceCalcName(std::string const &name)
+{
+    balanceCalcName = name;
+}
+
+
+void BalanceHists::SetFileServiceName(std::string const &name)
+{
+    fileServiceName = name;
+}
+
+
+void BalanceHists::SetJetKinematicsName(std::string const &name)
+{
+    jetKinematicsName = name;
+}
+
+
+void BalanceHists::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
 void BalanceHists::SetDirectoryName(std::string const &name)
 {
     outDirectoryName = name;
@@ -106,27 +136,28 @@ void BalanceHists::SetBinningPtJetRecoil(std::vector<double> const &binning)
 
 bool BalanceHists::ProcessEvent()
 {
-    auto const &jets = jetmetPlugin->GetJets();
-    auto const &j1 = jets.at(0);
+    auto const &jetPt = jetBlock->Pt();
+    auto const &leadProjection = jetKinematics->LeadProjection();
+    double const ptLead = jetPt.at(0);
     
     
-    histPtLead->Fill(j1.Pt());
-    profPtLead->Fill(j1.Pt(), j1.Pt());
-    profPtBal->Fill(j1.Pt(), balanceCalc->GetPtBal());
-    profMPF->Fill(j1.Pt(), balanceCalc->GetMPF());
+    histPtLead->Fill(ptLead);
+    profPtLead->Fill(ptLead, ptLead);
+    profPtBal->Fill(ptLead, balanceCalc->GetPtBal());
+    profMPF->Fill(ptLead, balanceCalc->GetMPF());
     
     
     // Remaining histograms are filled with all jets above the threshold but the leading one
-    for (unsigned i = 1; i < jets.size(); ++i)
+    for (unsigned i = 1; i < jetPt.size(); ++i)
     {
-        double const pt = jets[i].Pt();
+        double const pt = jetPt[i];
         
         if (pt < minPt)
             break;
         
-        histPtJet->Fill(j1.Pt(), pt);
-        histPtJetSumProj->Fill(j1.Pt(), pt, -pt * std::cos(jets[i].Phi() - j1.Phi()));
-        histRelPtJetSumProj->Fill(j1.Pt(), pt, -pt * std::cos(jets[i].Phi() - j1.Phi()) / j1.Pt());
+        histPtJet->Fill(ptLead, pt);
+        histPtJetSumProj->Fill(ptLead, pt, -leadProjection[i]);
+        histRelPtJetSumProj->Fill(ptLead, pt, -leadProjection[i] / ptLead);
     }
     
     
@@ -1,23 +1,23 @@
 #include <BalanceVars.hpp>
 
 #include <BalanceCalc.hpp>
+#include <JetBlock.hpp>
+#include <JetKinematics.hpp>
+#include <OutputTree.hpp>
+#include <SharedTree.hpp>
 
 #include <mensura/JetMETReader.hpp>
 #include <mensura/Processor.hpp>
 #include <mensura/ROOTLock.hpp>
 #include <mensura/TFileService.hpp>
 
-#include <TLorentzVector.h>
-#include <TVector2.h>
-
-#include <cmath>
-
 
 BalanceVars::BalanceVars(std::string const &name, double minPtRecoil_):
     AnalysisPlugin(name),
     minPtRecoil(minPtRecoil_),
     fileServiceName("TFileService"), fileService(nullptr),
-    jetmetPluginName("JetMET"), jetmetPlugin(nullptr),
+    jetmetPluginName("JetMET"), jetmetPlugin(nullptr), jetBlock(nullptr),
+    jetKinematicsName("JetKinematics"), jetKinematics(nullptr),
     balanceCalcName("BalanceCalc"), balanceCalc(nullptr),
     treeName(name)
 {}
@@ -33,12 +33,18 @@ void BalanceVars::BeginRun(Dataset const &)
     // Save pointers to required services and plugins
     fileService = dynamic_cast<TFileService const *>(GetMaster().GetService(fileServiceName));
     jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    jetBlock = &GetJetBlock(jetmetPlugin);
+    jetKinematics =
+      dynamic_cast<JetKinematics const *>(GetDependencyPlugin(jetKinematicsName));
     balanceCalc = dynamic_cast<BalanceCalc const *>(GetDependencyPlugin(balanceCalcName));
     
     
     // Create output tree
-    tree = fileService->Create<TTree>(directoryName.c_str(), treeName.c_str(),
-      "Observables for multijet balance");
+    if (sharedTreeName.empty())
+        tree = OutputTree::Create(*fileService, directoryName, treeName,
+          "Observables for multijet balance");
+    else
+        tree = dynamic_cast<SharedTree const *>(GetDependencyPlugin(sharedTreeName))->GetTree();
     
     
     // Assign branch addresses
@@ -65,6 +71,36 @@ Plugin *BalanceVars::Clone() const
 }
 
 
+void BalanceVars::SetBalanceCalcName(std::string const &name)
+{
+    balanceCalcName = name;
+}
+
+
+void BalanceVars::SetFileServiceName(std::string const &name)
+{
+    fileServiceName = name;
+}
+
+
+void BalanceVars::SetJetKinematicsName(std::string const &name)
+{
+    jetKinematicsName = name;
+}
+
+
+void BalanceVars::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
+void BalanceVars::SetSharedTreeName(std::string const &name)
+{
+    sharedTreeName = name;
+}
+
+
 void BalanceVars::SetTreeName(std::string const &name)
 {
     auto const pos = name.rfind('/');
@@ -84,38 +120,24 @@ void BalanceVars::SetTreeName(std::string const &name)
 
 bool BalanceVars::ProcessEvent()
 {
-    auto const &jets = jetmetPlugin->GetJets();
-    auto const &met = jetmetPlugin->GetMET().P4();
-    auto const &j1 = jets.at(0);
+    auto const &pt = jetBlock->Pt();
     
     
-    bfPtJ1 = j1.Pt();
-    bfPtJ2 = (jets.size() > 1) ? jets[1].Pt(): 0.;
-    bfPtJ3 = (jets.size() > 2) ? jets[2].Pt(): 0.;
+    bfPtJ1 = pt.at(0);
+    bfPtJ2 = (pt.size() > 1) ? pt[1] : 0.;
+    bfPtJ3 = (pt.size() > 2) ? pt[2] : 0.;
     
-    bfMET = met.Pt();
-    bfDPhi12 = (jets.size() > 1) ? std::abs(TVector2::Phi_mpi_pi(j1.Phi() - jets[1].Phi())) : 0.;
-    
-    
-    TLorentzVector p4Recoil;
-    
-    for (unsigned i = 1; i < jets.size(); ++i)
-    {
-        auto const &j = jets[i];
-        
-        if (j.Pt() < minPtRecoil)
-            break;
-        
-        p4Recoil += j.P4();
-    }
-    
-    bfPtRecoil = p4Recoil.Pt();
+    bfMET = jetmetPlugin->GetMET().P4().Pt();
+    bfDPhi12 = jetKinematics->GetDPhi12();
+    bfPtRecoil = jetKinematics->GetRecoilPt(minPtRecoil);
     
     
     bfPtBal = balanceCalc->GetPtBal();
     bfMPF = balanceCalc->GetMPF();
     
     
-    tree->Fill();
+    if (sharedTreeName.empty())
+        tree->Fill();
+    
     return true;
 }
@@ -1,5 +1,8 @@
 #include <BasicJetVars.hpp>
 
+#include <JetBlock.hpp>
+#include <OutputTree.hpp>
+
 #include <mensura/JetMETReader.hpp>
 #include <mensura/Processor.hpp>
 #include <mensura/ROOTLock.hpp>
@@ -30,7 +33,7 @@ void BasicJetVars::BeginRun(Dataset const &dataset)
     
     
     // Create output tree
-    tree = fileService->Create<TTree>("", "Vars", "Observables describing jets");
+    tree = OutputTree::Create(*fileService, "", "Vars", "Observables describing jets");
     
     
     // Assign branch addresses
@@ -57,7 +60,7 @@ Plugin *BasicJetVars::Clone() const
 
 bool BasicJetVars::ProcessEvent()
 {
-    auto const &jets = jetmetPlugin->GetJets();
+    auto const &jets = GetJets(jetmetPlugin);
     
     
     // Compute jet observables
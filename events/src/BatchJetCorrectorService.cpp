@@ -0,0 +1,228 @@
+#include <BatchJetCorrectorService.hpp>
+
+#include <mensura/FileInPath.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+
+BatchJetCorrectorService::BatchJetCorrectorService(
+  std::string const &name /*= "BatchJetCorrector"*/):
+    Service(name),
+    defaultIOV{"", {}, {}, {}}, currentIOV{nullptr}, deferredLoading{false}
+{}
+
+
+void BatchJetCorrectorService::BeginRun(Dataset const &)
+{
+    FinishLoading();
+}
+
+
+BatchJetCorrectorService *BatchJetCorrectorService::Clone() const
+{
+    auto *clone = new BatchJetCorrectorService(*this);
+    clone->currentIOV = nullptr;
+    return clone;
+}
+
+
+void BatchJetCorrectorService::Eval(JetCorrectionInput const &input, double *fullFactors,
+  double *l1Factors) const
+{
+    IOV const &iov = GetCurrentIOV("Eval");
+    EvalChain(iov.fullLevels, input, fullFactors);
+    EvalChain(iov.l1Levels, input, l1Factors);
+}
+
+
+void BatchJetCorrectorService::FinishLoading()
+{
+    auto finish = [](IOV &iov)
+    {
+        if (not iov.pendingLevels.valid())
+            return;
+
+        auto const &levels = iov.pendingLevels.get();
+        iov.fullLevels = levels.first;
+        iov.l1Levels = levels.second;
+        iov.pendingLevels = {};
+    };
+
+    for (auto &interval: iovs)
+        finish(interval.payload);
+
+    finish(defaultIOV);
+}
+
+
+double BatchJetCorrectorService::GetMaxFullFactor() const
+{
+    double maxFactor = 1.;
+
+    for (auto const &level: GetCurrentIOV("GetMaxFullFactor").fullLevels)
+        maxFactor *= level->GetMaxFactor();
+
+    return maxFactor;
+}
+
+
+void BatchJetCorrectorService::RegisterIOV(std::string const &label, unsigned long minRun,
+  unsigned long maxRun)
+{
+    auto const *clash = iovs.FindOverlap(minRun, maxRun);
+
+    if (not clash)
+    {
+        for (auto const &interval: iovs)
+        {
+            if (interval.payload.label == label)
+            {
+                clash = &interval;
+                break;
+            }
+        }
+    }
+
+    if (clash)
+    {
+        std::ostringstream message;
+        message << "BatchJetCorrectorService[\"" << GetName() << "\"]::RegisterIOV: IOV \"" <<
+          label << "\" with runs [" << minRun << ", " << maxRun << "] clashes with " <<
+          "previously registered IOV \"" << clash->payload.label << "\".";
+        throw std::runtime_error(message.str());
+    }
+
+    iovs.Add(minRun, maxRun, IOV{label, {}, {}, {}});
+    currentIOV = nullptr;
+}
+
+
+void BatchJetCorrectorService::SelectIOV(unsigned long run) const
+{
+    if (iovs.IsEmpty())
+        return;
+
+    // The index remembers the last found IOV, so repeated lookups for the same run are cheap
+    currentIOV = iovs.Find(run);
+
+    if (not currentIOV)
+    {
+        std::ostringstream message;
+        message << "BatchJetCorrectorService[\"" << GetName() << "\"]::SelectIOV: No IOV found "
+          "for run " << run << ".";
+        throw std::runtime_error(message.str());
+    }
+}
+
+
+void BatchJetCorrectorService::SetJEC(std::string const &iovLabel,
+  std::vector<std::string> const &fullLevels, std::vector<std::string> const &l1Levels)
+{
+    auto interval = std::find_if(iovs.begin(), iovs.end(),
+      [&iovLabel](auto const &interval){return interval.payload.label == iovLabel;});
+
+    if (interval == iovs.end())
+    {
+        std::ostringstream message;
+        message << "BatchJetCorrectorService[\"" << GetName() << "\"]::SetJEC: IOV \"" <<
+          iovLabel << "\" has not been registered.";
+        throw std::runtime_error(message.str());
+    }
+
+    LoadLevels(interval->payload, fullLevels, l1Levels);
+}
+
+
+void BatchJetCorrectorService::SetDeferredLoading(bool enable /*= true*/)
+{
+    deferredLoading = enable;
+}
+
+
+void BatchJetCorrectorService::SetJEC(std::vector<std::string> const &fullLevels,
+  std::vector<std::string> const &l1Levels)
+{
+    if (not iovs.IsEmpty())
+    {
+        std::ostringstream message;
+        message << "BatchJetCorrectorService[\"" << GetName() << "\"]::SetJEC: Label of the IOV "
+          "must be given since IOVs have been registered.";
+        throw std::runtime_error(message.str());
+    }
+
+    LoadLevels(defaultIOV, fullLevels, l1Levels);
+}
+
+
+void BatchJetCorrectorService::LoadLevels(IOV &iov, std::vector<std::string> const &fullLevels,
+  std::vector<std::string> const &l1Levels) const
+{
+    if (not deferredLoading)
+    {
+        iov.fullLevels = ReadLevels(fullLevels);
+        iov.l1Levels = ReadLevels(l1Levels);
+        return;
+    }
+
+    iov.pendingLevels = std::async(std::launch::async, [fullLevels, l1Levels]()
+    {
+        return std::make_pair(ReadLevels(fullLevels), ReadLevels(l1Levels));
+    }).share();
+}
+
+
+void BatchJetCorrectorService::EvalChain(
+  std::vector<std::shared_ptr<JetCorrectionLevel const>> const &levels,
+  JetCorrectionInput const &input, double *factors) const
+{
+    std::size_t const size = input.size;
+    std::fill(factors, factors + size, 1.);
+
+    if (levels.empty())
+        return;
+
+    curPt.assign(input.pt, input.pt + size);
+    levelFactors.resize(size);
+
+    for (auto const &level: levels)
+    {
+        level->Eval(input, curPt.data(), levelFactors.data(), buffers);
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            factors[i] *= levelFactors[i];
+            curPt[i] *= levelFactors[i];
+        }
+    }
+}
+
+
+BatchJetCorrectorService::IOV const &BatchJetCorrectorService::GetCurrentIOV(
+  char const *caller) const
+{
+    IOV const *iov = (iovs.IsEmpty()) ? &defaultIOV : currentIOV;
+
+    if (not iov)
+    {
+        std::ostringstream message;
+        message << "BatchJetCorrectorService[\"" << GetName() << "\"]::" << caller << ": No IOV " <<
+          "has been selected.";
+        throw std::runtime_error(message.str());
+    }
+
+    return *iov;
+}
+
+
+std::vector<std::shared_ptr<JetCorrectionLevel const>> BatchJetCorrectorService::ReadLevels(
+  std::vector<std::string> const &fileNames)
+{
+    std::vector<std::shared_ptr<JetCorrectionLevel const>> levels;
+
+    for (auto const &fileName: fileNames)
+        levels.emplace_back(JetCorrectionLevel::Load(FileInPath::Resolve("JERC", fileName)));
+
+    return levels;
+}
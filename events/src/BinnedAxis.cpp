@@ -0,0 +1,18 @@
+#include <BinnedAxis.hpp>
+
+#include <TAxis.h>
+
+
+BinnedAxis::BinnedAxis(TAxis const &axis):
+    numBins(axis.GetNbins()), minEdge(axis.GetXmin()), maxEdge(axis.GetXmax()),
+    uniform(axis.GetXbins()->GetSize() == 0)
+{
+    if (not uniform)
+        edges.assign(axis.GetXbins()->GetArray(), axis.GetXbins()->GetArray() + numBins + 1);
+}
+
+
+BinnedAxis::BinnedAxis(std::vector<double> const &edges_):
+    numBins(edges_.size() - 1), minEdge(edges_.front()), maxEdge(edges_.back()),
+    uniform(false), edges(edges_)
+{}
@@ -1,5 +1,8 @@
 #include <DumpEventID.hpp>
 
+#include <OutputTree.hpp>
+#include <SharedTree.hpp>
+
 #include <mensura/EventIDReader.hpp>
 #include <mensura/Processor.hpp>
 #include <mensura/ROOTLock.hpp>
@@ -23,8 +26,10 @@ void DumpEventID::BeginRun(Dataset const &)
     
     
     // Create output tree
-    tree = fileService->Create<TTree>(directoryName.c_str(), treeName.c_str(),
-      "Event ID variables");
+    if (sharedTreeName.empty())
+        tree = OutputTree::Create(*fileService, directoryName, treeName, "Event ID variables");
+    else
+        tree = dynamic_cast<SharedTree const *>(GetDependencyPlugin(sharedTreeName))->GetTree();
     
     ROOTLock::Lock();
     
@@ -43,6 +48,18 @@ Plugin *DumpEventID::Clone() const
 }
 
 
+void DumpEventID::SetFileServiceName(std::string const &name)
+{
+    fileServiceName = name;
+}
+
+
+void DumpEventID::SetSharedTreeName(std::string const &name)
+{
+    sharedTreeName = name;
+}
+
+
 void DumpEventID::SetTreeName(std::string const &name)
 {
     auto const pos = name.rfind('/');
@@ -70,7 +87,8 @@ bool DumpEventID::ProcessEvent()
     bfEvent = id.Event();
     bfBunchCrossing = id.BunchCrossing();
     
-    tree->Fill();
+    if (sharedTreeName.empty())
+        tree->Fill();
     
     
     // This plugin does not perform any event filtering
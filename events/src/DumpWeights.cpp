@@ -1,5 +1,7 @@
 #include <DumpWeights.hpp>
 
+#include <OutputTree.hpp>
+
 #include <mensura/Processor.hpp>
 #include <mensura/ROOTLock.hpp>
 #include <mensura/TFileService.hpp>
@@ -67,7 +69,7 @@ void DumpWeights::BeginRun(Dataset const &dataset)
     
     
     // Create output tree
-    tree = fileService->Create<TTree>("", "Weights", "Nominal and alternative weights");
+    tree = OutputTree::Create(*fileService, "", "Weights", "Nominal and alternative weights");
     
     
     // Assign branch addresses
@@ -2,11 +2,19 @@
 
 #include <mensura/EventIDReader.hpp>
 #include <mensura/FileInPath.hpp>
+#include <JetBlock.hpp>
+#include <SharedResources.hpp>
+
 #include <mensura/JetMETReader.hpp>
 
 #include <TFile.h>
+#include <TGraph.h>
+#include <TList.h>
 
+#include <algorithm>
 #include <cmath>
+#include <iomanip>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
 
@@ -26,6 +34,11 @@ EtaPhiFilter::Region::Region(unsigned long minRun_, unsigned long maxRun_, doubl
     
     while (maxPhi < minPhi)
         maxPhi += 2 * M_PI;
+    
+    std::ostringstream keyStream;
+    keyStream << std::setprecision(17) << "rect:" << minEta << ":" << maxEta << ":" << minPhi <<
+      ":" << maxPhi;
+    key = keyStream.str();
 }
 
 
@@ -33,7 +46,8 @@ EtaPhiFilter::Region::Region(unsigned long minRun_, unsigned long maxRun_,
   std::string const &filePath, std::string histName):
     minRun(minRun_), maxRun(maxRun_)
 {
-    TFile srcFile((FileInPath::Resolve("Cleaning", filePath)).c_str());
+    std::string const resolvedPath{FileInPath::Resolve("Cleaning", filePath)};
+    TFile srcFile(resolvedPath.c_str());
     
     // If name for the histogram has not been given, assume the file contains only a single object
     if (histName == "")
@@ -53,6 +67,8 @@ EtaPhiFilter::Region::Region(unsigned long minRun_, unsigned long maxRun_,
     map.reset(hist);
     
     srcFile.Close();
+    
+    key = "map:" + resolvedPath + ":" + histName;
 }
 
 
@@ -82,10 +98,269 @@ bool EtaPhiFilter::Region::InRunRange(unsigned long run) const
 }
 
 
+EtaPhiFilter::Raster::Raster(std::vector<Region> const &regions):
+    minEta{0.}, numEtaCells{0},
+    numPhiCells{unsigned(2 * M_PI / cellSize)}, phiCellSize{2 * M_PI / numPhiCells}
+{
+    // Find the range in eta covered by the regions. For maps, only bins with content above 0.5
+    //are relevant.
+    double lowEta = std::numeric_limits<double>::infinity();
+    double highEta = -std::numeric_limits<double>::infinity();
+    
+    for (auto const &region: regions)
+    {
+        if (not region.map)
+        {
+            lowEta = std::min(lowEta, region.minEta);
+            highEta = std::max(highEta, region.maxEta);
+            rasterRegions.emplace_back(region);
+        }
+        else if (IsRasterizable(*region.map))
+        {
+            for (auto *obj: *region.map->GetBins())
+            {
+                auto *bin = static_cast<TH2PolyBin *>(obj);
+                
+                if (bin->GetContent() > 0.5)
+                {
+                    lowEta = std::min(lowEta, bin->GetXMin());
+                    highEta = std::max(highEta, bin->GetXMax());
+                }
+            }
+            
+            rasterRegions.emplace_back(region);
+        }
+        else
+            exactRegions.emplace_back(region);
+    }
+    
+    if (lowEta > highEta)
+        return;
+    
+    
+    // Add a spare cell on each side, so that all points of the regions are strictly inside the
+    //bitmap
+    minEta = lowEta - cellSize;
+    numEtaCells = unsigned((highEta - lowEta) / cellSize) + 3;
+    cells.assign(numEtaCells * numPhiCells, CellState::Outside);
+    
+    for (auto const &region: rasterRegions)
+    {
+        if (region.map)
+            AddMap(*region.map);
+        else
+            AddRectangle(region);
+    }
+}
+
+
+bool EtaPhiFilter::Raster::Contains(double eta, double phi) const
+{
+    for (auto const &region: exactRegions)
+    {
+        if (region.InEtaPhi(eta, phi))
+            return true;
+    }
+    
+    double const etaPos = std::floor((eta - minEta) / cellSize);
+    
+    if (not (etaPos >= 0. and etaPos < numEtaCells))
+        return false;
+    
+    unsigned const iPhi = std::min(unsigned((phi + M_PI) / phiCellSize), numPhiCells - 1);
+    
+    switch (cells[unsigned(etaPos) * numPhiCells + iPhi])
+    {
+        case CellState::Outside:
+            return false;
+        
+        case CellState::Inside:
+            return true;
+        
+        case CellState::Border:
+            break;
+    }
+    
+    for (auto const &region: rasterRegions)
+    {
+        if (region.InEtaPhi(eta, phi))
+            return true;
+    }
+    
+    return false;
+}
+
+
+void EtaPhiFilter::Raster::AddRectangle(Region const &region)
+{
+    // Classify cells in phi. Each cell is shifted into the range (minPhi, minPhi + 2 pi], as done
+    //in Region::InEtaPhi. A cell that would be split by this shift is on the border.
+    std::vector<CellState> phiStates(numPhiCells);
+    
+    for (unsigned iPhi = 0; iPhi < numPhiCells; ++iPhi)
+    {
+        double start = -M_PI + iPhi * phiCellSize;
+        
+        while (start <= region.minPhi)
+            start += 2 * M_PI;
+        
+        double const end = start + phiCellSize;
+        
+        if (start > region.minPhi + margin and end < region.maxPhi - margin)
+            phiStates[iPhi] = CellState::Inside;
+        else if (start > region.maxPhi + margin and end < region.minPhi + 2 * M_PI - margin)
+            phiStates[iPhi] = CellState::Outside;
+        else
+            phiStates[iPhi] = CellState::Border;
+    }
+    
+    
+    // Combine with the classification in eta
+    for (unsigned iEta = 0; iEta < numEtaCells; ++iEta)
+    {
+        double const start = minEta + iEta * cellSize, end = start + cellSize;
+        CellState etaState;
+        
+        if (start > region.minEta + margin and end < region.maxEta - margin)
+            etaState = CellState::Inside;
+        else if (end < region.minEta - margin or start > region.maxEta + margin)
+            continue;
+        else
+            etaState = CellState::Border;
+        
+        for (unsigned iPhi = 0; iPhi < numPhiCells; ++iPhi)
+        {
+            if (phiStates[iPhi] == CellState::Outside)
+                continue;
+            
+            Mark(iEta, iPhi, std::min(etaState, phiStates[iPhi]));
+        }
+    }
+}
+
+
+void EtaPhiFilter::Raster::AddMap(TH2Poly &map)
+{
+    // Ranges of cells that overlap with the bounding box of a bin, including the margin
+    auto findCellRange = [](double low, double high, double origin, double size,
+      unsigned numCells)
+    {
+        double const first = std::floor((low - margin - origin) / size);
+        double const last = std::floor((high + margin - origin) / size);
+        return std::make_pair(unsigned(std::clamp(first, 0., numCells - 1.)),
+          unsigned(std::clamp(last, 0., numCells - 1.)));
+    };
+    
+    
+    // Cells that overlap with bins with content not above 0.5 cannot be fully inside the map, as
+    //TH2Poly::FindBin might select such a bin for some of their points
+    std::vector<bool> touchedByGoodBin(cells.size(), false);
+    
+    for (auto *obj: *map.GetBins())
+    {
+        auto *bin = static_cast<TH2PolyBin *>(obj);
+        
+        if (bin->GetContent() > 0.5)
+            continue;
+        
+        auto const [firstEta, lastEta] = findCellRange(bin->GetXMin(), bin->GetXMax(), minEta,
+          cellSize, numEtaCells);
+        auto const [firstPhi, lastPhi] = findCellRange(bin->GetYMin(), bin->GetYMax(), -M_PI,
+          phiCellSize, numPhiCells);
+        
+        for (unsigned iEta = firstEta; iEta <= lastEta; ++iEta)
+            for (unsigned iPhi = firstPhi; iPhi <= lastPhi; ++iPhi)
+                touchedByGoodBin[iEta * numPhiCells + iPhi] = true;
+    }
+    
+    
+    for (auto *obj: *map.GetBins())
+    {
+        auto *bin = static_cast<TH2PolyBin *>(obj);
+        
+        if (bin->GetContent() <= 0.5)
+            continue;
+        
+        
+        // Check if the polygon of the bin coincides with its bounding box. This requires that it
+        //has four distinct vertices at the corners of the box, connected by axis-parallel edges.
+        bool rectangular = false;
+        auto const *polygon = dynamic_cast<TGraph const *>(bin->GetPolygon());
+        
+        if (polygon and (polygon->GetN() == 4 or polygon->GetN() == 5))
+        {
+            double const *x = polygon->GetX(), *y = polygon->GetY();
+            rectangular = true;
+            
+            for (int i = 0; i < 4; ++i)
+            {
+                int const next = (i + 1) % 4;
+                bool const atCorner = (x[i] == bin->GetXMin() or x[i] == bin->GetXMax()) and
+                  (y[i] == bin->GetYMin() or y[i] == bin->GetYMax());
+                bool const axisParallel = (x[i] == x[next]) != (y[i] == y[next]);
+                
+                if (not atCorner or not axisParallel)
+                    rectangular = false;
+            }
+            
+            if (polygon->GetN() == 5 and (x[4] != x[0] or y[4] != y[0]))
+                rectangular = false;
+        }
+        
+        
+        auto const [firstEta, lastEta] = findCellRange(bin->GetXMin(), bin->GetXMax(), minEta,
+          cellSize, numEtaCells);
+        auto const [firstPhi, lastPhi] = findCellRange(bin->GetYMin(), bin->GetYMax(), -M_PI,
+          phiCellSize, numPhiCells);
+        
+        for (unsigned iEta = firstEta; iEta <= lastEta; ++iEta)
+        {
+            double const etaStart = minEta + iEta * cellSize, etaEnd = etaStart + cellSize;
+            bool const coveredEta = (bin->GetXMin() < etaStart - margin and
+              bin->GetXMax() > etaEnd + margin);
+            
+            for (unsigned iPhi = firstPhi; iPhi <= lastPhi; ++iPhi)
+            {
+                double const phiStart = -M_PI + iPhi * phiCellSize;
+                double const phiEnd = phiStart + phiCellSize;
+                bool const covered = coveredEta and bin->GetYMin() < phiStart - margin and
+                  bin->GetYMax() > phiEnd + margin;
+                
+                if (rectangular and covered and not touchedByGoodBin[iEta * numPhiCells + iPhi])
+                    Mark(iEta, iPhi, CellState::Inside);
+                else
+                    Mark(iEta, iPhi, CellState::Border);
+            }
+        }
+    }
+}
+
+
+void EtaPhiFilter::Raster::Mark(unsigned iEta, unsigned iPhi, CellState state)
+{
+    auto &cell = cells[iEta * numPhiCells + iPhi];
+    cell = std::max(cell, state);
+}
+
+
+bool EtaPhiFilter::Raster::IsRasterizable(TH2Poly const &map)
+{
+    // Points outside of all bins are assigned to one of the overflow bins, which are numbered
+    //from -1 to -9
+    for (int bin = -9; bin <= -1; ++bin)
+    {
+        if (map.GetBinContent(bin) > 0.5)
+            return false;
+    }
+    
+    return true;
+}
+
+
 EtaPhiFilter::EtaPhiFilter(std::string const &name, double minPt_):
     AnalysisPlugin(name),
     eventIDPluginName("InputData"), eventIDPlugin(nullptr),
-    jetmetPluginName("JetMET"), jetmetPlugin(nullptr),
+    jetmetPluginName("JetMET"), jetmetPlugin(nullptr), jetBlock(nullptr),
     minPt(minPt_)
 {}
 
@@ -107,6 +382,7 @@ void EtaPhiFilter::AddRegion(unsigned long minRun, unsigned long maxRun, double
   double endEta, double startPhi, double endPhi)
 {
     regions.emplace_back(minRun, maxRun, startEta, endEta, startPhi, endPhi);
+    rasters.Clear();
 }
 
 
@@ -114,6 +390,7 @@ void EtaPhiFilter::AddRegion(unsigned long minRun, unsigned long maxRun,
   std::string const &filePath, std::string const histName)
 {
     regions.emplace_back(minRun, maxRun, filePath, histName);
+    rasters.Clear();
 }
 
 
@@ -122,6 +399,10 @@ void EtaPhiFilter::BeginRun(Dataset const &)
     // Save pointers to other plugins
     eventIDPlugin = dynamic_cast<EventIDReader const *>(GetDependencyPlugin(eventIDPluginName));
     jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    jetBlock = &GetJetBlock(jetmetPlugin);
+    
+    if (rasters.IsEmpty())
+        BuildRasters();
 }
 
 
@@ -131,37 +412,84 @@ Plugin *EtaPhiFilter::Clone() const
 }
 
 
-bool EtaPhiFilter::ProcessEvent()
+void EtaPhiFilter::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
+void EtaPhiFilter::BuildRasters()
 {
-    // Update the list of regions to checked for the current run
-    selectedRegions.clear();
-    unsigned long const run = eventIDPlugin->GetEventID().Run();
+    // Runs at which the set of applicable regions can change
+    std::vector<unsigned long> intervalStarts{0};
     
     for (auto const &r: regions)
     {
-        if (r.InRunRange(run))
-            selectedRegions.emplace_back(&r);
+        intervalStarts.emplace_back(r.minRun);
+        
+        if (r.maxRun != std::numeric_limits<unsigned long>::max())
+            intervalStarts.emplace_back(r.maxRun + 1);
     }
     
-    if (selectedRegions.empty())
-        return true;
+    std::sort(intervalStarts.begin(), intervalStarts.end());
+    intervalStarts.erase(std::unique(intervalStarts.begin(), intervalStarts.end()),
+      intervalStarts.end());
+    
     
+    // Compile regions for each interval. Rasters for identical sets of regions are shared via
+    //SharedResources.
+    rasters.Clear();
     
-    // Check all jets against all selected regions
-    for (auto const &jet: jetmetPlugin->GetJets())
+    for (std::size_t i = 0; i < intervalStarts.size(); ++i)
     {
-        if (jet.Pt() < minPt)
+        unsigned long const start = intervalStarts[i];
+        std::vector<Region> selectedRegions;
+        std::string key;
+        
+        for (auto const &r: regions)
         {
-            // Jets are ordered in pt
-            break;
+            if (r.InRunRange(start))
+            {
+                selectedRegions.emplace_back(r);
+                key += r.key + ";";
+            }
         }
         
+        if (selectedRegions.empty())
+            continue;
         
-        for (auto const &r: selectedRegions)
+        unsigned long const end = (i + 1 < intervalStarts.size()) ?
+          intervalStarts[i + 1] - 1 : std::numeric_limits<unsigned long>::max();
+        rasters.Add(start, end, SharedResources::Get<Raster>(key,
+          [&selectedRegions](){return std::make_shared<Raster>(selectedRegions);}));
+    }
+}
+
+
+bool EtaPhiFilter::ProcessEvent()
+{
+    // The index remembers the interval of the previous event, so the lookup is cheap
+    auto const *raster = rasters.Find(eventIDPlugin->GetEventID().Run());
+    
+    if (not raster)
+        return true;
+    
+    
+    // Check all jets against the regions
+    auto const &pt = jetBlock->Pt();
+    auto const &eta = jetBlock->Eta();
+    auto const &phi = jetBlock->Phi();
+    
+    for (unsigned i = 0; i < pt.size(); ++i)
+    {
+        if (pt[i] < minPt)
         {
-            if (r->InEtaPhi(jet.Eta(), jet.Phi()))
-                return false;
+            // Jets are ordered in pt
+            break;
         }
+        
+        if ((*raster)->Contains(eta[i], phi[i]))
+            return false;
     }
     
     
@@ -0,0 +1,58 @@
+#include <EtaPhiGrid.hpp>
+
+#include <cmath>
+
+
+EtaPhiGrid::EtaPhiGrid(double radius):
+    cellSize{radius},
+    numPhiCells{std::max(int(2 * M_PI / radius), 1)},
+    phiCellSize{2 * M_PI / numPhiCells},
+    numEtaCells{0}, minEta{0.}
+{}
+
+
+void EtaPhiGrid::BuildCells()
+{
+    numEtaCells = 0;
+    cellStarts.clear();
+    sortedIndices.resize(etas.size());
+
+    if (etas.empty())
+        return;
+
+    auto const [minEtaIt, maxEtaIt] = std::minmax_element(etas.begin(), etas.end());
+    minEta = *minEtaIt;
+    numEtaCells = int((*maxEtaIt - minEta) / cellSize) + 1;
+
+
+    // Sort objects in cells with a counting sort. First count objects in each cell, saving the
+    //counts shifted by one position, and then convert the counts into starting positions.
+    cellStarts.resize(numEtaCells * numPhiCells + 1, 0);
+    objectCells.resize(etas.size());
+
+    for (unsigned i = 0; i < etas.size(); ++i)
+    {
+        int const etaCell = std::min(int((etas[i] - minEta) / cellSize), numEtaCells - 1);
+        objectCells[i] = etaCell * numPhiCells + FindPhiCell(phis[i]);
+        ++cellStarts[objectCells[i] + 1];
+    }
+
+    for (unsigned cell = 1; cell < cellStarts.size(); ++cell)
+        cellStarts[cell] += cellStarts[cell - 1];
+
+    // Use the starting positions as insertion points and restore them afterwards
+    for (unsigned i = 0; i < etas.size(); ++i)
+        sortedIndices[cellStarts[objectCells[i]]++] = i;
+
+    for (unsigned cell = cellStarts.size() - 1; cell > 0; --cell)
+        cellStarts[cell] = cellStarts[cell - 1];
+
+    cellStarts[0] = 0;
+}
+
+
+int EtaPhiGrid::FindPhiCell(double phi) const
+{
+    int const cell = int(std::floor((TVector2::Phi_mpi_pi(phi) + M_PI) / phiCellSize));
+    return std::clamp(cell, 0, numPhiCells - 1);
+}
@@ -1,5 +1,7 @@
 #include <FirstJetFilter.hpp>
 
+#include <JetBlock.hpp>
+
 #include <mensura/JetMETReader.hpp>
 
 #include <cmath>
@@ -8,7 +10,7 @@
 FirstJetFilter::FirstJetFilter(std::string const &name, double minPt_,
   double maxAbsEta_ /*= std::numeric_limits<double>::infinity()*/):
     AnalysisPlugin(name),
-    jetmetPluginName("JetMET"), jetmetPlugin(nullptr),
+    jetmetPluginName("JetMET"), jetmetPlugin(nullptr), jetBlock(nullptr),
     minPt(minPt_), maxAbsEta(maxAbsEta_)
 {}
 
@@ -22,6 +24,7 @@ FirstJetFilter::FirstJetFilter(double minPt,
 void FirstJetFilter::BeginRun(Dataset const &)
 {
     jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    jetBlock = &GetJetBlock(jetmetPlugin);
 }
 
 
@@ -31,17 +34,21 @@ Plugin *FirstJetFilter::Clone() const
 }
 
 
+void FirstJetFilter::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
 bool FirstJetFilter::ProcessEvent()
 {
-    auto const &jets = jetmetPlugin->GetJets();
-    
-    if (jets.size() == 0)
+    if (jetBlock->GetSize() == 0)
         return false;
     
-    if (jets[0].Pt() < minPt)
+    if (jetBlock->Pt()[0] < minPt)
         return false;
     
-    if (std::abs(jets[0].Eta()) > maxAbsEta)
+    if (std::abs(jetBlock->Eta()[0]) > maxAbsEta)
         return false;
     
     
@@ -1,5 +1,7 @@
 #include <GenMatchFilter.hpp>
 
+#include <JetBlock.hpp>
+
 #include <mensura/GenJetMETReader.hpp>
 #include <mensura/JetMETReader.hpp>
 
@@ -10,7 +12,7 @@
 
 GenMatchFilter::GenMatchFilter(std::string const &name, double maxDR, double minRelPt_):
     AnalysisPlugin(name),
-    jetmetPluginName("JetMET"), jetmetPlugin(nullptr),
+    jetmetPluginName("JetMET"), jetmetPlugin(nullptr), jetBlock(nullptr),
     genJetPluginName("GenJetMET"), genJetPlugin(nullptr),
     maxDR2(std::pow(maxDR, 2)), minRelPt(minRelPt_)
 {}
@@ -24,6 +26,7 @@ GenMatchFilter::GenMatchFilter(double maxDR, double minRelPt):
 void GenMatchFilter::BeginRun(Dataset const &)
 {
     jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    jetBlock = &GetJetBlock(jetmetPlugin);
     genJetPlugin = dynamic_cast<GenJetMETReader const *>(GetDependencyPlugin(genJetPluginName));
 }
 
@@ -34,25 +37,32 @@ Plugin *GenMatchFilter::Clone() const
 }
 
 
+void GenMatchFilter::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
 bool GenMatchFilter::ProcessEvent()
 {
-    auto const &jets = jetmetPlugin->GetJets();
-    
-    if (jets.size() == 0)
+    if (jetBlock->GetSize() == 0)
         return false;
     
+    double const ptLead = jetBlock->Pt()[0];
+    double const etaLead = jetBlock->Eta()[0], phiLead = jetBlock->Phi()[0];
+    
     
     for (auto const &genJet: genJetPlugin->GetJets())
     {
-        if (genJet.Pt() < minRelPt * jets[0].Pt())
+        if (genJet.Pt() < minRelPt * ptLead)
         {
             // Generator-level jets are sorted in pt. If the current jet is too soft, there is no
             //point in checking remaining ones.
             return false;
         }
         
-        double const dR2 = std::pow(jets[0].Eta() - genJet.Eta(), 2) +
-          std::pow(TVector2::Phi_mpi_pi(jets[0].Phi() - genJet.Phi()), 2);
+        double const dR2 = std::pow(etaLead - genJet.Eta(), 2) +
+          std::pow(TVector2::Phi_mpi_pi(phiLead - genJet.Phi()), 2);
         
         if (dR2 < maxDR2)
             return true;
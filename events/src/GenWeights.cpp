@@ -1,5 +1,8 @@
 #include <GenWeights.hpp>
 
+#include <OutputTree.hpp>
+#include <SharedTree.hpp>
+
 #include <mensura/Processor.hpp>
 #include <mensura/ROOTLock.hpp>
 
@@ -23,7 +26,10 @@ void GenWeights::BeginRun(Dataset const &dataset)
     
     
     // Create output tree
-    tree = fileService->Create<TTree>(directoryName.c_str(), treeName.c_str(), "Event weights");
+    if (sharedTreeName.empty())
+        tree = OutputTree::Create(*fileService, directoryName, treeName, "Event weights");
+    else
+        tree = dynamic_cast<SharedTree const *>(GetDependencyPlugin(sharedTreeName))->GetTree();
     
     ROOTLock::Lock();
     
@@ -52,6 +58,12 @@ GenWeights *GenWeights::Clone() const
 }
 
 
+void GenWeights::SetSharedTreeName(std::string const &name)
+{
+    sharedTreeName = name;
+}
+
+
 void GenWeights::SetTreeName(std::string const &name)
 {
     auto const pos = name.rfind('/');
@@ -87,7 +99,9 @@ bool GenWeights::ProcessEvent()
         bfWeightMEFact[1] = generatorPlugin->GetAltWeight(1) / nominal;
     }
 
-    tree->Fill();
+    if (sharedTreeName.empty())
+        tree->Fill();
+
     return true;
 }
 
@@ -22,7 +22,7 @@ JERCJetMETReader::JERCJetMETReader(std::string name /*= "JetMET"*/):
     minPt(0.), maxAbsEta(std::numeric_limits<double>::infinity()),
     applyJetID(true),
     leptonPluginName("Leptons"), leptonPlugin(nullptr),
-    genJetPluginName(""), genJetPlugin(nullptr),
+    genJetPluginName(""), genJetPlugin(nullptr), genJetGrid(GetJetRadius() / 2.),
     puPluginName("PileUp"), puPlugin(nullptr),
     jerFilePath(""), jerPtFactor(0.)
 {
@@ -31,7 +31,7 @@ JERCJetMETReader::JERCJetMETReader(std::string name /*= "JetMET"*/):
 
 
 JERCJetMETReader::JERCJetMETReader(JERCJetMETReader const &src) noexcept:
-    JetMETReader(src),
+    JetMETReader(src), JetBlockProvider(src),
     inputDataPluginName(src.inputDataPluginName), inputDataPlugin(src.inputDataPlugin),
     treeName(src.treeName),
     minPt(src.minPt), maxAbsEta(src.maxAbsEta), jetSelector(src.jetSelector),
@@ -39,6 +39,7 @@ JERCJetMETReader::JERCJetMETReader(JERCJetMETReader const &src) noexcept:
     leptonPluginName(src.leptonPluginName), leptonPlugin(src.leptonPlugin),
     leptonDR2(src.leptonDR2),
     genJetPluginName(src.genJetPluginName), genJetPlugin(src.genJetPlugin),
+    genJetGrid(src.genJetGrid),
     puPluginName(src.puPluginName), puPlugin(src.puPlugin),
     jerFilePath(src.jerFilePath), jerPtFactor(src.jerPtFactor)
 {}
@@ -110,6 +111,12 @@ double JERCJetMETReader::GetJetRadius() const
 }
 
 
+JetBlock const &JERCJetMETReader::GetJetBlock() const
+{
+    return jetBlock;
+}
+
+
 void JERCJetMETReader::SetApplyJetID(bool applyJetID_)
 {
     applyJetID = applyJetID_;
@@ -144,8 +151,8 @@ void JERCJetMETReader::SetSelection(std::function<bool(Jet const &)> jetSelector
 
 bool JERCJetMETReader::ProcessEvent()
 {
-    // Clear vector with jets from the previous event
-    jets.clear();
+    // Clear collections of jets from the previous event
+    jetBlock.Clear();
     
     
     // Read jets and MET
@@ -154,6 +161,10 @@ bool JERCJetMETReader::ProcessEvent()
     // Collection of leptons against which jets will be cleaned
     auto const *leptonsForCleaning = (leptonPlugin) ? &leptonPlugin->GetLeptons() : nullptr;
     
+    // Index generator-level jets to find candidates for matching without checking all of them
+    if (genJetPlugin)
+        genJetGrid.Build(genJetPlugin->GetJets());
+    
     
     // Header for debug print out
     #ifdef DEBUG
@@ -162,22 +173,18 @@ bool JERCJetMETReader::ProcessEvent()
     #endif
     
     
-    // Process jets in the current event
+    // Process jets in the current event. Their momenta are not corrected and the raw momenta are
+    //propagated unchanged.
     for (jec::Jet const &j: *bfJets)
     {
-        // Read raw jet momentum and apply corrections to it. The correction factor read from
-        //pec::Jet is zero if only raw momentum is stored. In this case propagate the raw momentum
-        //unchanged.
-        TLorentzVector p4;
-        p4.SetPtEtaPhiM(j.ptRaw, j.etaRaw, j.phiRaw, j.massRaw);
+        double const pt = j.ptRaw, eta = j.etaRaw, phi = j.phiRaw;
         
         
         #ifdef DEBUG
         ++curJetNumber;
         std::cout << " Jet #" << curJetNumber << "\n";
         std::cout << "  Raw momentum (pt, eta, phi, m): " << j.ptRaw << ", " << j.etaRaw << ", " <<
-          phiRaw << ", " << j.massRaw << '\n';
-        std::cout << "  Fully corrected pt: " << p4.Pt() << '\n';
+          j.phiRaw << ", " << j.massRaw << '\n';
         #endif
         
         
@@ -187,7 +194,7 @@ bool JERCJetMETReader::ProcessEvent()
         
         
         // User-defined selection on momentum
-        if (p4.Pt() < minPt or fabs(p4.Eta()) > maxAbsEta)
+        if (pt < minPt or std::abs(eta) > maxAbsEta)
             continue;
         
         
@@ -198,8 +205,8 @@ bool JERCJetMETReader::ProcessEvent()
             
             for (auto const &l: *leptonsForCleaning)
             {
-                double const dR2 = std::pow(p4.Eta() - l.Eta(), 2) +
-                  std::pow(TVector2::Phi_mpi_pi(p4.Phi() - l.Phi()), 2);
+                double const dR2 = std::pow(eta - l.Eta(), 2) +
+                  std::pow(TVector2::Phi_mpi_pi(phi - l.Phi()), 2);
                 //^ Do not use TLorentzVector::DeltaR to avoid calculating sqrt
                 
                 if (dR2 < leptonDR2)
@@ -220,63 +227,53 @@ bool JERCJetMETReader::ProcessEvent()
         #endif
         
         
-        // Build the jet object. At this point jet momentum must be fully corrected
-        Jet jet;
-        jet.SetCorrectedP4(p4, 1.);
-        
-        jet.SetArea(j.area);
-        
-        // jet.SetBTag(BTagger::Algorithm::CMVA, j.bTagCMVA);
-        // jet.SetPileUpID(j.pileupDiscr);
-        
-        // jet.SetFlavour(Jet::FlavourType::Hadron, j.flavourHadron);
-        // jet.SetFlavour(Jet::FlavourType::Parton, j.flavourParton);
-        
-        if (not applyJetID)
-            jet.SetUserInt("ID", int(j.isGood));
-        
-        
         // Perform matching to generator-level jets if the corresponding reader is available.
         //Choose the closest jet but require that the angular separation is not larger than half of
         //the radius parameter of reconstructed jets and, if the plugin has been configured to
         //check this, that the difference in pt is compatible with the pt resolution in simulation.
+        //Only generator-level jets from nearby cells of the grid are checked.
+        GenJet const *matchedGenJet = nullptr;
+        
         if (genJetPlugin)
         {
+            auto const &genJets = genJetPlugin->GetJets();
             double minDR2 = std::pow(GetJetRadius() / 2., 2);
-            GenJet const *matchedGenJet = nullptr;
-            double maxDPt = std::numeric_limits<double>::infinity();
-            
-            if (jerProvider)
-            {
-                double const ptResolution = (*jerProvider)(p4.Pt(), p4.Eta(), puPlugin->GetRho());
-                maxDPt = ptResolution * p4.Pt() * jerPtFactor;
-            }
+            unsigned matchedIndex = 0;
             
+            // The pt resolution is only evaluated when the first candidate is found
+            double maxDPt = -1.;
             
-            for (auto const &genJet: genJetPlugin->GetJets())
+            genJetGrid.ForEachNeighbour(eta, phi, [&](unsigned index, double dR2)
             {
-                double const dR2 = std::pow(p4.Eta() - genJet.Eta(), 2) +
-                  std::pow(TVector2::Phi_mpi_pi(p4.Phi() - genJet.Phi()), 2);
-                //^ Do not use TLorentzVector::DeltaR to avoid calculating sqrt
+                // Ties are resolved in favour of the jet that comes first in the collection, as
+                //in a sequential scan
+                if (not (dR2 < minDR2 or
+                  (matchedGenJet and dR2 == minDR2 and index < matchedIndex)))
+                    return;
+                
+                if (maxDPt < 0.)
+                {
+                    if (jerProvider)
+                        maxDPt = (*jerProvider)(pt, eta, puPlugin->GetRho()) * pt * jerPtFactor;
+                    else
+                        maxDPt = std::numeric_limits<double>::infinity();
+                }
                 
-                if (dR2 < minDR2 and std::abs(p4.Pt() - genJet.Pt()) < maxDPt)
+                if (std::abs(pt - genJets[index].Pt()) < maxDPt)
                 {
-                    matchedGenJet = &genJet;
+                    matchedGenJet = &genJets[index];
+                    matchedIndex = index;
                     minDR2 = dR2;
                 }
-            }
-            
-            jet.SetMatchedGenJet(matchedGenJet);
+            });
         }
         
         #ifdef DEBUG
-        std::cout << "  Flavour: " << j.Flavour() << ", cMVA value: " <<
-          j.BTag(pec::Jet::BTagAlgo::CMVA) << '\n';
         std::cout << "  Has a GEN-level match? ";
         
         if (genJetPlugin)
         {
-            if (jet.MatchedGenJet())
+            if (matchedGenJet)
                 std::cout << "yes";
             else
                 std::cout << "no";
@@ -288,17 +285,23 @@ bool JERCJetMETReader::ProcessEvent()
         #endif
         
         
-        // Generic selection on the jet
-        if (jetSelector and not jetSelector(jet))
-            continue;
+        // Add the jet to the collection. At this point jet momentum must be fully corrected.
+        jetBlock.Add(j.ptRaw, j.etaRaw, j.phiRaw, j.massRaw, j.area, 1., j.isGood,
+          matchedGenJet);
         
         
-        jets.push_back(jet);
+        // Generic selection on the jet. It requires a fully constructed jet object.
+        if (jetSelector and not jetSelector(jetBlock.BuildJet(jetBlock.GetSize() - 1)))
+            jetBlock.RemoveLast();
     }
     
     
-    // Make sure collection of jets is ordered in transverse momentum
-    std::sort(jets.rbegin(), jets.rend());
+    // Make sure collection of jets is ordered in transverse momentum and translate it into
+    //standard jet objects if requested
+    jetBlock.SortByPt();
+    
+    if (fillStandardJets)
+        jetBlock.Export(jets);
     
     
     // Read raw missing pt. The corrected missing pt is not available and set to null.
@@ -318,4 +321,3 @@ bool JERCJetMETReader::ProcessEvent()
     //no more events in the dataset and thus always returns true
     return true;
 }
-
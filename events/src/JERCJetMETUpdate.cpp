@@ -1,5 +1,7 @@
 #include <JERCJetMETUpdate.hpp>
 
+#include <BatchJetCorrectorService.hpp>
+
 #include <mensura/EventIDReader.hpp>
 #include <mensura/PileUpReader.hpp>
 #include <mensura/Processor.hpp>
@@ -13,13 +15,18 @@
 JERCJetMETUpdate::JERCJetMETUpdate(std::string const &name, std::string const &jetCorrFullName_,
   std::string const &jetCorrL1Name_):
     JetMETReader(name),
-    jetmetPlugin(nullptr), jetmetPluginName("OrigJetMET"),
-    eventIDPlugin(nullptr), eventIDPluginName("InputData"),
+    jetmetPlugin(nullptr), jetmetPluginName("OrigJetMET"), srcJetBlock(nullptr),
+    eventIDPlugin(nullptr), eventIDPluginName("InputData"), iovRun(0), iovRunValid(false),
     puPlugin(nullptr), puPluginName("PileUp"),
     systServiceName("Systematics"),
     jetCorrFull(nullptr), jetCorrFullName(jetCorrFullName_),
     jetCorrL1(nullptr), jetCorrL1Name(jetCorrL1Name_),
-    minPt(0.), maxAbsEta(std::numeric_limits<double>::infinity()), minPtForT1(15.), turnOnT1(0.)
+    batchCorr(nullptr), batchCorrName(""),
+    lazyMode(false), lazyMinPt(0.), lazyMaxAbsEta(0.),
+    numCorrected(0), leadIndex(-1),
+    minPt(0.), maxAbsEta(std::numeric_limits<double>::infinity()), minPtForT1(15.), turnOnT1(0.),
+    systType(JetCorrectorService::SystType::None),
+    systDirection(SystService::VarDirection::Undefined)
 {}
 
 
@@ -33,16 +40,18 @@ void JERCJetMETUpdate::BeginRun(Dataset const &)
 {
     // Save pointers to the original JetMETReader and a PileUpReader
     jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    srcJetBlock = &::GetJetBlock(jetmetPlugin);
     eventIDPlugin = dynamic_cast<EventIDReader const *>(GetDependencyPlugin(eventIDPluginName));
     puPlugin = dynamic_cast<PileUpReader const *>(GetDependencyPlugin(puPluginName));
+    iovRunValid = false;
     
     
-    // Read requested systematic variation
-    systType = JetCorrectorService::SystType::None;
-    systDirection = SystService::VarDirection::Undefined;
-    
+    // Read requested systematic variation unless it has been specified explicitly
     if (systServiceName != "")
     {
+        systType = JetCorrectorService::SystType::None;
+        systDirection = SystService::VarDirection::Undefined;
+        
         SystService const *systService =
           dynamic_cast<SystService const *>(GetMaster().GetServiceQuiet(systServiceName));
         
@@ -65,6 +74,29 @@ void JERCJetMETUpdate::BeginRun(Dataset const &)
     
     
     // Read services for jet corrections
+    if (not batchCorrName.empty())
+    {
+        if (systType != JetCorrectorService::SystType::None)
+        {
+            std::ostringstream message;
+            message << "JERCJetMETUpdate[\"" << GetName() << "\"]::BeginRun: Systematic " <<
+              "variations are not supported with a BatchJetCorrectorService.";
+            throw std::runtime_error(message.str());
+        }
+        
+        batchCorr = dynamic_cast<BatchJetCorrectorService const *>(
+          GetMaster().GetService(batchCorrName));
+        return;
+    }
+    
+    if (lazyMode)
+    {
+        std::ostringstream message;
+        message << "JERCJetMETUpdate[\"" << GetName() << "\"]::BeginRun: The lazy mode is only " <<
+          "supported with a BatchJetCorrectorService.";
+        throw std::runtime_error(message.str());
+    }
+    
     jetCorrFull = dynamic_cast<JetCorrectorService const *>(
       GetMaster().GetService(jetCorrFullName));
 
@@ -94,6 +126,26 @@ double JERCJetMETUpdate::GetJetRadius() const
 }
 
 
+JetBlock const &JERCJetMETUpdate::GetJetBlock() const
+{
+    return jetBlock;
+}
+
+
+void JERCJetMETUpdate::SetBatchCorrector(std::string const &name)
+{
+    batchCorrName = name;
+}
+
+
+void JERCJetMETUpdate::SetLazyLeadingJetCut(double minPt_, double maxAbsEta_)
+{
+    lazyMode = true;
+    lazyMinPt = minPt_;
+    lazyMaxAbsEta = maxAbsEta_;
+}
+
+
 void JERCJetMETUpdate::SetSelection(double minPt_, double maxAbsEta_)
 {
     minPt = minPt_;
@@ -101,6 +153,15 @@ void JERCJetMETUpdate::SetSelection(double minPt_, double maxAbsEta_)
 }
 
 
+void JERCJetMETUpdate::SetSystematics(JetCorrectorService::SystType systType_,
+  SystService::VarDirection systDirection_)
+{
+    systType = systType_;
+    systDirection = systDirection_;
+    systServiceName = "";
+}
+
+
 void JERCJetMETUpdate::SetT1Threshold(double thresholdStart, double thresholdEnd)
 {
     minPtForT1 = thresholdStart;
@@ -122,56 +183,187 @@ void JERCJetMETUpdate::SetT1Threshold(double thresholdStart, double thresholdEnd
 }
 
 
+bool JERCJetMETUpdate::CheckLeadingJet(double rho)
+{
+    // Jets in the source collection are ordered in raw pt. Correct them in small groups until the
+    //remaining jets cannot overtake the leading corrected one even with the largest correction
+    //allowed by the tables. The bound includes a margin for values between the points at which
+    //the formulas are sampled, see JetCorrectionLevel::GetMaxFactor.
+    std::size_t const groupSize = 4;
+    JetBlock const &src = *srcJetBlock;
+    std::size_t const size = src.GetSize();
+    double const maxCorr = batchCorr->GetMaxFullFactor();
+    double leadPt = 0.;
+    
+    while (numCorrected < size)
+    {
+        if (leadIndex >= 0 and
+          src.Pt()[numCorrected] * src.RawFactor()[numCorrected] * maxCorr <= leadPt)
+            break;
+        
+        std::size_t const end = std::min(numCorrected + groupSize, size);
+        EvalCorrections(rho, numCorrected, end);
+        
+        for (std::size_t i = numCorrected; i < end; ++i)
+        {
+            double const pt = src.Pt()[i] * src.RawFactor()[i] * corrFull[i];
+            
+            if (pt > minPt and std::abs(src.Eta()[i]) < maxAbsEta and pt > leadPt)
+            {
+                leadPt = pt;
+                leadIndex = i;
+            }
+        }
+        
+        numCorrected = end;
+    }
+    
+    
+    return (leadIndex >= 0 and leadPt >= lazyMinPt and
+      std::abs(src.Eta()[leadIndex]) <= lazyMaxAbsEta);
+}
+
+
+void JERCJetMETUpdate::EvalCorrections(double rho, std::size_t begin, std::size_t end)
+{
+    JetBlock const &src = *srcJetBlock;
+    
+    if (batchCorr)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            rawPt[i] = src.Pt()[i] * src.RawFactor()[i];
+            rawEta[i] = src.Eta()[i];
+            area[i] = src.Area()[i];
+        }
+        
+        batchCorr->Eval({end - begin, rawPt.data() + begin, rawEta.data() + begin,
+          area.data() + begin, rho}, corrFull.data() + begin, corrL1.data() + begin);
+        return;
+    }
+    
+    
+    // Jet objects built from the source JetBlock are used to evaluate corrections jet by jet
+    auto const &srcJets = ::GetJets(jetmetPlugin);
+    
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        corrFull[i] = jetCorrFull->Eval(srcJets[i], rho, systType, systDirection);
+        
+        double const pt = src.Pt()[i] * src.RawFactor()[i] * corrFull[i];
+        corrL1[i] = (jetCorrL1 and pt > minPtForT1) ? jetCorrL1->Eval(srcJets[i], rho) : 1.;
+    }
+}
+
+
 bool JERCJetMETUpdate::ProcessEvent()
 {
-    // Update IOV in jet correctors
+    // Update IOV in jet correctors if the run has changed
     auto const run = eventIDPlugin->GetEventID().Run();
-    jetCorrFull->SelectIOV(run);
-
-    if (jetCorrL1)
-        jetCorrL1->SelectIOV(run);
     
+    if (not iovRunValid or run != iovRun)
+    {
+        if (batchCorr)
+            batchCorr->SelectIOV(run);
+        else
+        {
+            jetCorrFull->SelectIOV(run);
+            
+            if (jetCorrL1)
+                jetCorrL1->SelectIOV(run);
+        }
+        
+        iovRun = run;
+        iovRunValid = true;
+    }
     
-    jets.clear();
     
+    jetBlock.Clear();
     
-    // Read value of rho
+    JetBlock const &src = *srcJetBlock;
+    std::size_t const size = src.GetSize();
     double const rho = puPlugin->GetRho();
     
+    corrFull.resize(size);
+    corrL1.resize(size);
     
-    // Loop over original collection of jets
-    TLorentzVector updatedMET(jetmetPlugin->GetRawMET().P4());
+    if (batchCorr)
+    {
+        rawPt.resize(size);
+        rawEta.resize(size);
+        area.resize(size);
+    }
+    
+    numCorrected = 0;
+    leadIndex = -1;
     
-    for (auto const &srcJet: jetmetPlugin->GetJets())
+    
+    // In the lazy mode, stop after the leading jet if it fails the selection
+    if (lazyMode and not CheckLeadingJet(rho))
     {
-        // Copy current jet and recorrect its momentum
-        Jet jet(srcJet);
+        if (leadIndex >= 0)
+        {
+            double const corrFactor = corrFull[leadIndex];
+            double const rawFactor = src.RawFactor()[leadIndex];
+            jetBlock.Add(src.Pt()[leadIndex] * rawFactor * corrFactor, src.Eta()[leadIndex],
+              src.Phi()[leadIndex], src.Mass()[leadIndex] * rawFactor * corrFactor,
+              src.Area()[leadIndex], 1. / corrFactor, src.ID()[leadIndex],
+              src.MatchedGenJet()[leadIndex]);
+        }
         
-        double const corrFactor = jetCorrFull->Eval(srcJet, rho, systType, systDirection);
-        jet.SetCorrectedP4(srcJet.RawP4() * corrFactor, 1. / corrFactor);
+        if (fillStandardJets)
+            jetBlock.Export(jets);
+        
+        met = jetmetPlugin->GetRawMET();
+        return true;
+    }
+    
+    
+    // Evaluate corrections for all remaining jets
+    EvalCorrections(rho, numCorrected, size);
+    
+    
+    // Loop over original collection of jets
+    auto const &srcRawMET = jetmetPlugin->GetRawMET().P4();
+    double metX = srcRawMET.Px(), metY = srcRawMET.Py();
+    
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        // Recorrect momentum of the current jet
+        double const rawFactor = src.RawFactor()[i];
+        double const rawPt = src.Pt()[i] * rawFactor;
+        double const corrFactor = corrFull[i];
+        double const pt = rawPt * corrFactor;
         
         
         // Evaluate type 1 correction to MET from the current jet. Systematic variations are not
         // propagated to the L1 correction.
-        if (jet.Pt() > minPtForT1)
+        if (pt > minPtForT1)
         {
-            double const weight = WeightJet(jet.Pt());
-            double const puCorr = (jetCorrL1) ? jetCorrL1->Eval(srcJet, rho) : 1.;
-            updatedMET -= (jet.P4() - srcJet.RawP4() * puCorr) * weight;
+            double const weight = WeightJet(pt);
+            double const dPt = (pt - rawPt * corrL1[i]) * weight;
+            metX -= dPt * std::cos(src.Phi()[i]);
+            metY -= dPt * std::sin(src.Phi()[i]);
         }
         
         
         // Store the new jet if it passes the kinematical selection
-        if (jet.Pt() > minPt and std::abs(jet.Eta()) < maxAbsEta)
-            jets.emplace_back(jet);
+        if (pt > minPt and std::abs(src.Eta()[i]) < maxAbsEta)
+            jetBlock.Add(pt, src.Eta()[i], src.Phi()[i],
+              src.Mass()[i] * rawFactor * corrFactor, src.Area()[i], 1. / corrFactor,
+              src.ID()[i], src.MatchedGenJet()[i]);
     }
     
     
-    // Make sure the new collection of jets is ordered in transverse momentum
-    std::sort(jets.rbegin(), jets.rend());
+    // Make sure the new collection of jets is ordered in transverse momentum and translate it
+    //into standard jet objects if requested
+    jetBlock.SortByPt();
+    
+    if (fillStandardJets)
+        jetBlock.Export(jets);
     
     // Update MET
-    met.SetPtEtaPhiM(updatedMET.Pt(), 0., updatedMET.Phi(), 0.);
+    met.SetPtEtaPhiM(std::hypot(metX, metY), 0., std::atan2(metY, metX), 0.);
     
     return true;
 }
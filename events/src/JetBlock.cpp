@@ -0,0 +1,167 @@
+#include <JetBlock.hpp>
+
+#include <mensura/JetMETReader.hpp>
+#include <mensura/Plugin.hpp>
+
+#include <TLorentzVector.h>
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+
+JetBlock::JetBlock():
+    jetsBuilt(false)
+{}
+
+
+void JetBlock::Add(double pt_, double eta_, double phi_, double mass_, double area_,
+  double rawFactor_, bool id_, GenJet const *matchedGenJet_ /*= nullptr*/)
+{
+    pt.emplace_back(pt_);
+    eta.emplace_back(eta_);
+    phi.emplace_back(phi_);
+    mass.emplace_back(mass_);
+    area.emplace_back(area_);
+    rawFactor.emplace_back(rawFactor_);
+    id.emplace_back(id_);
+    matchedGenJet.emplace_back(matchedGenJet_);
+    jetsBuilt = false;
+}
+
+
+Jet JetBlock::BuildJet(std::size_t index) const
+{
+    TLorentzVector p4;
+    p4.SetPtEtaPhiM(pt[index], eta[index], phi[index], mass[index]);
+
+    Jet jet;
+    jet.SetCorrectedP4(p4, rawFactor[index]);
+    jet.SetArea(area[index]);
+    jet.SetUserInt("ID", int(id[index]));
+
+    if (matchedGenJet[index])
+        jet.SetMatchedGenJet(matchedGenJet[index]);
+
+    return jet;
+}
+
+
+void JetBlock::Clear()
+{
+    pt.clear();
+    eta.clear();
+    phi.clear();
+    mass.clear();
+    area.clear();
+    rawFactor.clear();
+    id.clear();
+    matchedGenJet.clear();
+    jetsBuilt = false;
+}
+
+
+void JetBlock::Export(std::vector<Jet> &jets) const
+{
+    jets.clear();
+    jets.reserve(GetSize());
+
+    for (std::size_t i = 0; i < GetSize(); ++i)
+        jets.emplace_back(BuildJet(i));
+}
+
+
+std::vector<Jet> const &JetBlock::GetJets() const
+{
+    if (not jetsBuilt)
+    {
+        Export(builtJets);
+        jetsBuilt = true;
+    }
+
+    return builtJets;
+}
+
+
+void JetBlock::RemoveLast()
+{
+    pt.pop_back();
+    eta.pop_back();
+    phi.pop_back();
+    mass.pop_back();
+    area.pop_back();
+    rawFactor.pop_back();
+    id.pop_back();
+    matchedGenJet.pop_back();
+    jetsBuilt = false;
+}
+
+
+void JetBlock::SortByPt()
+{
+    // Jets are often already ordered, in which case there is nothing to do
+    if (std::is_sorted(pt.begin(), pt.end(), std::greater<double>()))
+        return;
+
+    order.resize(GetSize());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](unsigned i, unsigned j){return pt[i] > pt[j];});
+
+    for (auto *values: {&pt, &eta, &phi, &mass, &area, &rawFactor})
+        Permute(*values, doubleBuffer);
+
+    Permute(id, idBuffer);
+    Permute(matchedGenJet, genJetBuffer);
+    jetsBuilt = false;
+}
+
+
+template<typename T>
+void JetBlock::Permute(std::vector<T> &values, std::vector<T> &buffer) const
+{
+    buffer.resize(values.size());
+
+    for (std::size_t i = 0; i < order.size(); ++i)
+        buffer[i] = values[order[i]];
+
+    std::swap(values, buffer);
+}
+
+
+JetBlockProvider::JetBlockProvider():
+    fillStandardJets(true)
+{}
+
+
+void JetBlockProvider::SetFillStandardJets(bool enable)
+{
+    fillStandardJets = enable;
+}
+
+
+JetBlock const &GetJetBlock(Plugin const *plugin)
+{
+    auto const *provider = dynamic_cast<JetBlockProvider const *>(plugin);
+
+    if (not provider)
+    {
+        std::ostringstream message;
+        message << "GetJetBlock: Plugin \"" << plugin->GetName() << "\" does not provide jets in "
+          "the columnar layout.";
+        throw std::runtime_error(message.str());
+    }
+
+    return provider->GetJetBlock();
+}
+
+
+std::vector<Jet> const &GetJets(JetMETReader const *plugin)
+{
+    auto const *provider = dynamic_cast<JetBlockProvider const *>(plugin);
+
+    if (provider and not provider->IsFillingStandardJets())
+        return provider->GetJetBlock().GetJets();
+    else
+        return plugin->GetJets();
+}
@@ -0,0 +1,708 @@
+#include <JetCorrectionFormula.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace
+{
+/**
+ * \brief Form used for L1FastJet corrections
+ *
+ * Variables x, y, and z are Rho, JetPt, and JetA.
+ */
+struct L1FastJetForm
+{
+    static constexpr char const *expression =
+      "max(0.0001,1-(z/y)*([0]+([1]*(x))*(1+[2]*log(y))))";
+    static constexpr unsigned numVariables = 3;
+
+    static double Eval(double const *x, double const *const *p, std::size_t i)
+    {
+        double const value =
+          1 - (x[2] / x[1]) * (p[0][i] + (p[1][i] * x[0]) * (1 + p[2][i] * std::log(x[1])));
+        return (0.0001 > value) ? 0.0001 : value;
+    }
+};
+
+
+/**
+ * \brief Standard form used for L2Relative corrections, optionally with a lower cut-off
+ *
+ * The only variable is JetPt.
+ */
+template<bool clamped>
+struct L2RelativeForm
+{
+    static constexpr char const *expression = (clamped) ?
+      "max(0.0001,[0]+([1]/(pow(log10(x),2)+[2]))+([3]*exp(-([4]*((log10(x)-[5])*"
+      "(log10(x)-[5])))))+([6]*exp(-([7]*((log10(x)-[8])*(log10(x)-[8]))))))" :
+      "[0]+([1]/(pow(log10(x),2)+[2]))+([3]*exp(-([4]*((log10(x)-[5])*(log10(x)-[5])))))+"
+      "([6]*exp(-([7]*((log10(x)-[8])*(log10(x)-[8])))))";
+    static constexpr unsigned numVariables = 1;
+
+    static double Eval(double const *x, double const *const *p, std::size_t i)
+    {
+        double const logPt = std::log10(x[0]);
+        double const value = p[0][i] + (p[1][i] / (std::pow(logPt, 2.) + p[2][i])) +
+          (p[3][i] * std::exp(-(p[4][i] * ((logPt - p[5][i]) * (logPt - p[5][i]))))) +
+          (p[6][i] * std::exp(-(p[7][i] * ((logPt - p[8][i]) * (logPt - p[8][i])))));
+
+        if constexpr (clamped)
+            return (0.0001 > value) ? 0.0001 : value;
+        else
+            return value;
+    }
+};
+
+
+/// Evaluates a formula of the given known form for a batch of jets
+template<typename Form>
+void EvaluateForm(std::size_t size, double const *const *variables,
+  double const *const *parameters, double *result)
+{
+    double x[Form::numVariables];
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        for (unsigned v = 0; v < Form::numVariables; ++v)
+            x[v] = variables[v][i];
+
+        result[i] = Form::Eval(x, parameters, i);
+    }
+}
+}  // anonymous namespace
+
+
+class JetCorrectionFormula::Parser
+{
+public:
+    Parser(JetCorrectionFormula &formula, std::string const &text);
+
+public:
+    /// Parses the full expression, emitting instructions into the formula
+    void Parse();
+
+private:
+    /// Moves the current position to the given character if it is found there
+    bool Accept(char c);
+
+    /// Same as Accept but throws an exception if the character is not found
+    void Expect(char c);
+
+    /// Throws an exception with the given description of the problem
+    [[noreturn]] void Fail(std::string const &reason) const;
+
+    /// Parses a sum or difference of terms
+    void ParseExpression();
+
+    /// Parses a call to a function with the given name, starting from the opening parenthesis
+    void ParseFunction(std::string const &name);
+
+    /// Parses a number, a variable, a parameter, a function call, or an expression in parentheses
+    void ParsePrimary();
+
+    /// Parses a primary expression, possibly raised to a power
+    void ParsePower();
+
+    /// Parses a product or ratio of factors
+    void ParseTerm();
+
+    /// Parses a factor with an optional unary sign
+    void ParseUnary();
+
+    /// Moves the current position past white spaces
+    void SkipSpaces();
+
+private:
+    JetCorrectionFormula &formula;
+    std::string const &text;
+    std::size_t pos;
+};
+
+
+JetCorrectionFormula::Parser::Parser(JetCorrectionFormula &formula_, std::string const &text_):
+    formula{formula_}, text{text_}, pos{0}
+{}
+
+
+void JetCorrectionFormula::Parser::Parse()
+{
+    ParseExpression();
+    SkipSpaces();
+
+    if (pos != text.size())
+        Fail(std::string("unexpected character '") + text[pos] + "'");
+}
+
+
+bool JetCorrectionFormula::Parser::Accept(char c)
+{
+    SkipSpaces();
+
+    if (pos < text.size() and text[pos] == c)
+    {
+        ++pos;
+        return true;
+    }
+    else
+        return false;
+}
+
+
+void JetCorrectionFormula::Parser::Expect(char c)
+{
+    if (not Accept(c))
+        Fail(std::string("expected '") + c + "'");
+}
+
+
+void JetCorrectionFormula::Parser::Fail(std::string const &reason) const
+{
+    std::ostringstream message;
+    message << "JetCorrectionFormula::Parser: Failed to parse expression \"" << text <<
+      "\" at position " << pos << ": " << reason << ".";
+    throw std::runtime_error(message.str());
+}
+
+
+void JetCorrectionFormula::Parser::ParseExpression()
+{
+    ParseTerm();
+
+    while (true)
+    {
+        if (Accept('+'))
+        {
+            ParseTerm();
+            formula.Emit(OpCode::Add);
+        }
+        else if (Accept('-'))
+        {
+            ParseTerm();
+            formula.Emit(OpCode::Subtract);
+        }
+        else
+            break;
+    }
+}
+
+
+void JetCorrectionFormula::Parser::ParseFunction(std::string const &name)
+{
+    // Normalize the name of the function
+    std::string shortName{name};
+
+    if (shortName.compare(0, 7, "TMath::") == 0)
+        shortName = shortName.substr(7);
+
+    std::transform(shortName.begin(), shortName.end(), shortName.begin(),
+      [](unsigned char c){return std::tolower(c);});
+
+
+    // Parse arguments
+    Expect('(');
+    unsigned numArgs = 0;
+
+    if (not Accept(')'))
+    {
+        do
+        {
+            ParseExpression();
+            ++numArgs;
+        }
+        while (Accept(','));
+
+        Expect(')');
+    }
+
+
+    // Find the operation that corresponds to the function
+    OpCode code;
+    unsigned expectedNumArgs = 1;
+
+    if (shortName == "exp")
+        code = OpCode::Exp;
+    else if (shortName == "log")
+        code = OpCode::Log;
+    else if (shortName == "log10")
+        code = OpCode::Log10;
+    else if (shortName == "sqrt")
+        code = OpCode::Sqrt;
+    else if (shortName == "abs" or shortName == "fabs")
+        code = OpCode::Abs;
+    else if (shortName == "atan")
+        code = OpCode::Atan;
+    else if (shortName == "tanh")
+        code = OpCode::Tanh;
+    else if (shortName == "cos")
+        code = OpCode::Cos;
+    else if (shortName == "sin")
+        code = OpCode::Sin;
+    else if (shortName == "pow" or shortName == "power")
+    {
+        code = OpCode::Power;
+        expectedNumArgs = 2;
+    }
+    else if (shortName == "max")
+    {
+        code = OpCode::Max;
+        expectedNumArgs = 2;
+    }
+    else if (shortName == "min")
+    {
+        code = OpCode::Min;
+        expectedNumArgs = 2;
+    }
+    else if (shortName == "pi")
+    {
+        code = OpCode::Constant;
+        expectedNumArgs = 0;
+    }
+    else
+        Fail("unknown function \"" + name + "\"");
+
+    if (numArgs != expectedNumArgs)
+    {
+        std::ostringstream reason;
+        reason << "function \"" << name << "\" expects " << expectedNumArgs <<
+          " argument(s) but " << numArgs << " given";
+        Fail(reason.str());
+    }
+
+    if (code == OpCode::Constant)
+        formula.Emit(code, 0, M_PI);
+    else
+        formula.Emit(code);
+}
+
+
+void JetCorrectionFormula::Parser::ParsePower()
+{
+    ParsePrimary();
+
+    // Power is right-associative and binds more tightly than the unary minus on its left
+    if (Accept('^'))
+    {
+        ParseUnary();
+        formula.Emit(OpCode::Power);
+    }
+}
+
+
+void JetCorrectionFormula::Parser::ParsePrimary()
+{
+    SkipSpaces();
+
+    if (pos == text.size())
+        Fail("unexpected end of expression");
+
+    char const c = text[pos];
+
+    if (std::isdigit(static_cast<unsigned char>(c)) or c == '.')
+    {
+        char const *begin = text.c_str() + pos;
+        char *end;
+        double const value = std::strtod(begin, &end);
+
+        if (end == begin)
+            Fail("malformed number");
+
+        pos += end - begin;
+        formula.Emit(OpCode::Constant, 0, value);
+    }
+    else if (c == '[')
+    {
+        ++pos;
+        std::size_t const start = pos;
+
+        while (pos < text.size() and std::isdigit(static_cast<unsigned char>(text[pos])))
+            ++pos;
+
+        if (pos == start)
+            Fail("malformed index of a parameter");
+
+        unsigned const index = std::stoul(text.substr(start, pos - start));
+        Expect(']');
+
+        formula.numParameters = std::max(formula.numParameters, index + 1);
+        formula.Emit(OpCode::Parameter, index);
+    }
+    else if (c == '(')
+    {
+        ++pos;
+        ParseExpression();
+        Expect(')');
+    }
+    else if (std::isalpha(static_cast<unsigned char>(c)))
+    {
+        std::size_t const start = pos;
+
+        while (pos < text.size() and (std::isalnum(static_cast<unsigned char>(text[pos])) or
+          text[pos] == '_' or text[pos] == ':'))
+            ++pos;
+
+        std::string const name{text.substr(start, pos - start)};
+        SkipSpaces();
+
+        if (pos < text.size() and text[pos] == '(')
+            ParseFunction(name);
+        else
+        {
+            std::string const variableNames{"xyzt"};
+            std::size_t const index = variableNames.find(name);
+
+            if (name.size() != 1 or index == std::string::npos)
+                Fail("unknown identifier \"" + name + "\"");
+
+            if (index >= formula.numVariables)
+                Fail("variable \"" + name + "\" is not defined");
+
+            formula.Emit(OpCode::Variable, index);
+        }
+    }
+    else
+        Fail(std::string("unexpected character '") + c + "'");
+}
+
+
+void JetCorrectionFormula::Parser::ParseTerm()
+{
+    ParseUnary();
+
+    while (true)
+    {
+        if (Accept('*'))
+        {
+            ParseUnary();
+            formula.Emit(OpCode::Multiply);
+        }
+        else if (Accept('/'))
+        {
+            ParseUnary();
+            formula.Emit(OpCode::Divide);
+        }
+        else
+            break;
+    }
+}
+
+
+void JetCorrectionFormula::Parser::ParseUnary()
+{
+    if (Accept('-'))
+    {
+        ParseUnary();
+        formula.Emit(OpCode::Negate);
+    }
+    else if (Accept('+'))
+        ParseUnary();
+    else
+        ParsePower();
+}
+
+
+void JetCorrectionFormula::Parser::SkipSpaces()
+{
+    while (pos < text.size() and std::isspace(static_cast<unsigned char>(text[pos])))
+        ++pos;
+}
+
+
+JetCorrectionFormula::JetCorrectionFormula(std::string const &expression_, unsigned numVariables_):
+    JetCorrectionFormula{expression_, numVariables_, NoFormRecognition{}}
+{
+    kernel = FindKernel();
+}
+
+
+JetCorrectionFormula::JetCorrectionFormula(std::string const &expression_, unsigned numVariables_,
+  NoFormRecognition):
+    expression{expression_}, numVariables{numVariables_}, numParameters{0},
+    depth{0}, maxDepth{0}, kernel{nullptr}
+{
+    if (numVariables > 4)
+    {
+        std::ostringstream message;
+        message << "JetCorrectionFormula::JetCorrectionFormula: At most 4 variables are "
+          "supported while " << numVariables << " requested.";
+        throw std::runtime_error(message.str());
+    }
+
+    Parser(*this, expression).Parse();
+}
+
+
+JetCorrectionFormula::JetCorrectionFormula(std::string const &expression_, unsigned numVariables_,
+  PackedInstruction const *program_, std::size_t programSize):
+    expression{expression_}, numVariables{numVariables_}, numParameters{0},
+    depth{0}, maxDepth{0}, kernel{nullptr}
+{
+    // Check the program while emitting it. The stack must never underflow, and exactly one
+    //array must remain on it at the end.
+    for (std::size_t i = 0; i < programSize; ++i)
+    {
+        auto const &packed = program_[i];
+        OpCode const code = OpCode(packed.code);
+        unsigned const numOperands =
+          (code == OpCode::Constant or code == OpCode::Variable or code == OpCode::Parameter) ?
+          0 : (code >= OpCode::Add and code <= OpCode::Min) ? 2 : 1;
+
+        if (packed.code > std::uint32_t(OpCode::Sin) or depth < numOperands or
+          (code == OpCode::Variable and packed.index >= numVariables))
+        {
+            std::ostringstream message;
+            message << "JetCorrectionFormula::JetCorrectionFormula: Instruction " << i <<
+              " in the program for expression \"" << expression << "\" is not valid.";
+            throw std::runtime_error(message.str());
+        }
+
+        if (code == OpCode::Parameter)
+            numParameters = std::max(numParameters, unsigned(packed.index) + 1);
+
+        Emit(code, packed.index, packed.value);
+    }
+
+    if (depth != 1 or numVariables > 4)
+    {
+        std::ostringstream message;
+        message << "JetCorrectionFormula::JetCorrectionFormula: Program for expression \"" <<
+          expression << "\" is not valid.";
+        throw std::runtime_error(message.str());
+    }
+
+    kernel = FindKernel();
+}
+
+
+void JetCorrectionFormula::Evaluate(std::size_t size, double const *const *variables,
+  double const *const *parameters, double *result, std::vector<double> &stack) const
+{
+    if (size == 0)
+        return;
+
+    if (kernel)
+    {
+        kernel(size, variables, parameters, result);
+        return;
+    }
+
+    stack.resize(maxDepth * size);
+    double *const base = stack.data();
+
+    // Number of arrays currently placed on the stack
+    unsigned sp = 0;
+
+    for (auto const &instruction: program)
+    {
+        // Arrays for the next free slot, the two topmost occupied slots (operands of a binary
+        //operation), and the topmost slot (argument of a unary operation)
+        double *const top = base + sp * size;
+        double *const a = base + ((sp >= 2) ? sp - 2 : 0) * size;
+        double const *const b = base + ((sp >= 1) ? sp - 1 : 0) * size;
+        double *const arg = base + ((sp >= 1) ? sp - 1 : 0) * size;
+
+        switch (instruction.code)
+        {
+            case OpCode::Constant:
+                std::fill(top, top + size, instruction.value);
+                ++sp;
+                break;
+
+            case OpCode::Variable:
+                std::copy(variables[instruction.index], variables[instruction.index] + size, top);
+                ++sp;
+                break;
+
+            case OpCode::Parameter:
+                std::copy(parameters[instruction.index], parameters[instruction.index] + size,
+                  top);
+                ++sp;
+                break;
+
+            case OpCode::Add:
+                for (std::size_t i = 0; i < size; ++i)
+                    a[i] += b[i];
+                --sp;
+                break;
+
+            case OpCode::Subtract:
+                for (std::size_t i = 0; i < size; ++i)
+                    a[i] -= b[i];
+                --sp;
+                break;
+
+            case OpCode::Multiply:
+                for (std::size_t i = 0; i < size; ++i)
+                    a[i] *= b[i];
+                --sp;
+                break;
+
+            case OpCode::Divide:
+                for (std::size_t i = 0; i < size; ++i)
+                    a[i] /= b[i];
+                --sp;
+                break;
+
+            case OpCode::Power:
+                // Squares are computed with a multiplication, which is what the compiler does
+                //for std::pow with a constant exponent of 2 in dedicated kernels
+                for (std::size_t i = 0; i < size; ++i)
+                    a[i] = (b[i] == 2.) ? a[i] * a[i] : std::pow(a[i], b[i]);
+                --sp;
+                break;
+
+            case OpCode::Max:
+                for (std::size_t i = 0; i < size; ++i)
+                    a[i] = (a[i] > b[i]) ? a[i] : b[i];
+                --sp;
+                break;
+
+            case OpCode::Min:
+                for (std::size_t i = 0; i < size; ++i)
+                    a[i] = (a[i] < b[i]) ? a[i] : b[i];
+                --sp;
+                break;
+
+            case OpCode::Negate:
+                for (std::size_t i = 0; i < size; ++i)
+                    arg[i] = -arg[i];
+                break;
+
+            case OpCode::Exp:
+                for (std::size_t i = 0; i < size; ++i)
+                    arg[i] = std::exp(arg[i]);
+                break;
+
+            case OpCode::Log:
+                for (std::size_t i = 0; i < size; ++i)
+                    arg[i] = std::log(arg[i]);
+                break;
+
+            case OpCode::Log10:
+                for (std::size_t i = 0; i < size; ++i)
+                    arg[i] = std::log10(arg[i]);
+                break;
+
+            case OpCode::Sqrt:
+                for (std::size_t i = 0; i < size; ++i)
+                    arg[i] = std::sqrt(arg[i]);
+                break;
+
+            case OpCode::Abs:
+                for (std::size_t i = 0; i < size; ++i)
+                    arg[i] = std::abs(arg[i]);
+                break;
+
+            case OpCode::Atan:
+                for (std::size_t i = 0; i < size; ++i)
+                    arg[i] = std::atan(arg[i]);
+                break;
+
+            case OpCode::Tanh:
+                for (std::size_t i = 0; i < size; ++i)
+                    arg[i] = std::tanh(arg[i]);
+                break;
+
+            case OpCode::Cos:
+                for (std::size_t i = 0; i < size; ++i)
+                    arg[i] = std::cos(arg[i]);
+                break;
+
+            case OpCode::Sin:
+                for (std::size_t i = 0; i < size; ++i)
+                    arg[i] = std::sin(arg[i]);
+                break;
+        }
+    }
+
+    std::copy(base, base + size, result);
+}
+
+
+std::vector<JetCorrectionFormula::PackedInstruction> JetCorrectionFormula::Pack() const
+{
+    std::vector<PackedInstruction> packed;
+    packed.reserve(program.size());
+
+    for (auto const &instruction: program)
+        packed.emplace_back(PackedInstruction{std::uint32_t(instruction.code), instruction.index,
+          instruction.value});
+
+    return packed;
+}
+
+
+void JetCorrectionFormula::Emit(OpCode code, unsigned index, double value)
+{
+    program.emplace_back(Instruction{code, index, value});
+
+    switch (code)
+    {
+        case OpCode::Constant:
+        case OpCode::Variable:
+        case OpCode::Parameter:
+            ++depth;
+            break;
+
+        case OpCode::Add:
+        case OpCode::Subtract:
+        case OpCode::Multiply:
+        case OpCode::Divide:
+        case OpCode::Power:
+        case OpCode::Max:
+        case OpCode::Min:
+            --depth;
+            break;
+
+        default:
+            break;
+    }
+
+    maxDepth = std::max(maxDepth, depth);
+}
+
+
+JetCorrectionFormula::Kernel JetCorrectionFormula::FindKernel() const
+{
+    struct KnownForm
+    {
+        std::vector<Instruction> program;
+        unsigned numVariables;
+        Kernel kernel;
+    };
+
+    auto compile = [](char const *expression, unsigned numVariables, Kernel kernel)
+    {
+        JetCorrectionFormula const formula{expression, numVariables, NoFormRecognition{}};
+        return KnownForm{formula.program, numVariables, kernel};
+    };
+
+    // Programs for known forms are compiled once
+    static std::vector<KnownForm> const knownForms{
+        compile(L1FastJetForm::expression, L1FastJetForm::numVariables,
+          EvaluateForm<L1FastJetForm>),
+        compile(L2RelativeForm<false>::expression, L2RelativeForm<false>::numVariables,
+          EvaluateForm<L2RelativeForm<false>>),
+        compile(L2RelativeForm<true>::expression, L2RelativeForm<true>::numVariables,
+          EvaluateForm<L2RelativeForm<true>>)
+    };
+
+    auto const equal = [](Instruction const &a, Instruction const &b)
+    {
+        return a.code == b.code and a.index == b.index and a.value == b.value;
+    };
+
+    for (auto const &form: knownForms)
+    {
+        if (form.numVariables == numVariables and form.program.size() == program.size() and
+          std::equal(program.begin(), program.end(), form.program.begin(), equal))
+            return form.kernel;
+    }
+
+    return nullptr;
+}
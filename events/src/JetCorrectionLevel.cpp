@@ -0,0 +1,669 @@
+#include <JetCorrectionLevel.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace fs = std::filesystem;
+
+
+namespace
+{
+/**
+ * \brief Header of a compiled file
+ *
+ * It is followed by the program of the formula, the tables of bin edges, ranges of the
+ * parametrization variables, and parameters, and then by the name of the level and the original
+ * expression of the formula. All numbers are stored in the native binary representation. The
+ * size of the header is a multiple of the alignment of double, so all arrays are aligned.
+ */
+struct CompiledHeader
+{
+    char magic[8];
+    std::uint32_t formatVersion;
+    std::uint32_t numBins;
+    std::uint8_t numBinVars, numParVars, sortedBins, reserved;
+    std::uint8_t binVariables[4], parVariables[4];
+    std::uint32_t numParameters, programSize, nameSize, expressionSize, reserved2;
+
+    /// Size and modification time of the source text file
+    std::uint64_t sourceSize;
+    std::int64_t sourceTime;
+};
+
+static_assert(sizeof(CompiledHeader) % alignof(double) == 0);
+
+/// Marker at the start of each compiled file
+constexpr char compiledMagic[8] = {'M', 'J', 'J', 'E', 'C', '\0', '\0', '\0'};
+
+/**
+ * \brief Version of the format of compiled files
+ *
+ * Must be increased whenever the format changes.
+ */
+constexpr std::uint32_t compiledFormatVersion = 1;
+
+
+/// Fills size and modification time of the given file into the header
+void GetSourceStamp(std::string const &path, CompiledHeader &header)
+{
+    header.sourceSize = fs::file_size(path);
+    header.sourceTime = fs::last_write_time(path).time_since_epoch().count();
+}
+
+
+/// Checks if the given compiled file has a valid header and has been produced from given file
+bool IsCompiledFrom(MappedFile const &compiledFile, std::string const &path)
+{
+    if (compiledFile.GetSize() < sizeof(CompiledHeader))
+        return false;
+
+    CompiledHeader header, source;
+    std::memcpy(&header, compiledFile.GetData(), sizeof(header));
+    std::error_code error;
+    source.sourceSize = fs::file_size(path, error);
+    source.sourceTime = fs::last_write_time(path, error).time_since_epoch().count();
+
+    return (not error and std::memcmp(header.magic, compiledMagic, sizeof(compiledMagic)) == 0 and
+      header.formatVersion == compiledFormatVersion and
+      header.sourceSize == source.sourceSize and header.sourceTime == source.sourceTime);
+}
+}  // anonymous namespace
+
+
+JetCorrectionLevel::JetCorrectionLevel(std::string const &path_):
+    path{path_}, numBins{0},
+    binEdges{nullptr}, parRanges{nullptr}, parameters{nullptr}, sortedBins{false}, maxFactor{1.}
+{
+    std::ifstream file{path};
+
+    if (not file)
+    {
+        std::ostringstream message;
+        message << "JetCorrectionLevel::JetCorrectionLevel: Failed to open file \"" << path <<
+          "\".";
+        throw std::runtime_error(message.str());
+    }
+
+
+    // Parse the header, which has the form
+    //{nBinVars binVar1 ... nParVars parVar1 ... formula Correction levelName}
+    std::string line;
+
+    while (std::getline(file, line) and line.find_first_not_of(" \t\r") == std::string::npos)
+    {}
+
+    auto const headerStart = line.find('{'), headerEnd = line.rfind('}');
+
+    if (headerStart == std::string::npos or headerEnd == std::string::npos or
+      headerEnd < headerStart)
+    {
+        std::ostringstream message;
+        message << "JetCorrectionLevel::JetCorrectionLevel: File \"" << path << "\" does not "
+          "start with a valid header.";
+        throw std::runtime_error(message.str());
+    }
+
+    std::istringstream header{line.substr(headerStart + 1, headerEnd - headerStart - 1)};
+    std::vector<std::string> tokens;
+    std::string token;
+
+    while (header >> token)
+        tokens.emplace_back(token);
+
+    std::size_t curToken = 0;
+
+    auto readVariables = [&](std::vector<Variable> &variables)
+    {
+        if (curToken >= tokens.size())
+            return false;
+
+        unsigned const n = std::stoul(tokens[curToken]);
+        ++curToken;
+
+        if (curToken + n > tokens.size() or n > 4)
+            return false;
+
+        for (unsigned i = 0; i < n; ++i, ++curToken)
+            variables.emplace_back(ParseVariable(tokens[curToken], path));
+
+        return true;
+    };
+
+    if (not readVariables(binVariables) or not readVariables(parVariables) or
+      curToken >= tokens.size())
+    {
+        std::ostringstream message;
+        message << "JetCorrectionLevel::JetCorrectionLevel: Failed to parse header \"" << line <<
+          "\" in file \"" << path << "\".";
+        throw std::runtime_error(message.str());
+    }
+
+    formula.reset(new JetCorrectionFormula(tokens[curToken], parVariables.size()));
+    name = (curToken + 1 < tokens.size()) ? tokens.back() : "";
+
+
+    // Read parameters for individual bins
+    unsigned const numBinVars = binVariables.size(), numParVars = parVariables.size();
+    unsigned const numParameters = formula->GetNumParameters();
+    std::vector<double> values, edgesTable, rangesTable, parametersTable;
+
+    while (std::getline(file, line))
+    {
+        if (line.find_first_not_of(" \t\r") == std::string::npos or line[0] == '#')
+            continue;
+
+        std::istringstream lineStream{line};
+        double value;
+        values.clear();
+
+        while (lineStream >> value)
+            values.emplace_back(value);
+
+        std::size_t const numValues = (values.size() > 2 * numBinVars) ?
+          values[2 * numBinVars] : 0;
+
+        if (values.size() != 2 * numBinVars + 1 + numValues or
+          numValues < 2 * numParVars + numParameters)
+        {
+            std::ostringstream message;
+            message << "JetCorrectionLevel::JetCorrectionLevel: Line \"" << line << "\" in file \""
+              << path << "\" does not match the header.";
+            throw std::runtime_error(message.str());
+        }
+
+        auto const parStart = values.begin() + 2 * numBinVars + 1;
+        edgesTable.insert(edgesTable.end(), values.begin(), values.begin() + 2 * numBinVars);
+        rangesTable.insert(rangesTable.end(), parStart, parStart + 2 * numParVars);
+        parametersTable.insert(parametersTable.end(), parStart + 2 * numParVars,
+          parStart + 2 * numParVars + numParameters);
+        ++numBins;
+    }
+
+    tables = std::move(edgesTable);
+    tables.insert(tables.end(), rangesTable.begin(), rangesTable.end());
+    tables.insert(tables.end(), parametersTable.begin(), parametersTable.end());
+    binEdges = tables.data();
+    parRanges = binEdges + 2 * numBinVars * numBins;
+    parameters = parRanges + 2 * numParVars * numBins;
+
+
+    // Check if the bins can be looked up with a binary search
+    if (numBinVars == 1)
+    {
+        sortedBins = true;
+
+        for (unsigned bin = 0; bin < numBins; ++bin)
+        {
+            if (binEdges[2 * bin] > binEdges[2 * bin + 1] or
+              (bin > 0 and binEdges[2 * bin] < binEdges[2 * bin - 1]))
+            {
+                sortedBins = false;
+                break;
+            }
+        }
+    }
+
+    ComputeMaxFactor();
+}
+
+
+JetCorrectionLevel::JetCorrectionLevel(std::string const &path_,
+  std::shared_ptr<MappedFile const> compiledFile_):
+    path{path_}, numBins{0}, compiledFile{compiledFile_},
+    binEdges{nullptr}, parRanges{nullptr}, parameters{nullptr}, sortedBins{false}, maxFactor{1.}
+{
+    auto reportCorrupted = [this]()
+    {
+        std::ostringstream message;
+        message << "JetCorrectionLevel::JetCorrectionLevel: Compiled file \"" <<
+          compiledFile->GetPath() << "\" is corrupted.";
+        throw std::runtime_error(message.str());
+    };
+
+    CompiledHeader header;
+    std::memcpy(&header, compiledFile->GetData(), sizeof(header));
+
+    if (header.numBinVars > 4 or header.numParVars > 4)
+        reportCorrupted();
+
+    auto readVariables = [&reportCorrupted](std::uint8_t const *codes, unsigned n,
+      std::vector<Variable> &variables)
+    {
+        for (unsigned i = 0; i < n; ++i)
+        {
+            if (codes[i] > std::uint8_t(Variable::Rho))
+                reportCorrupted();
+
+            variables.emplace_back(Variable(codes[i]));
+        }
+    };
+
+    readVariables(header.binVariables, header.numBinVars, binVariables);
+    readVariables(header.parVariables, header.numParVars, parVariables);
+
+    numBins = header.numBins;
+    sortedBins = header.sortedBins;
+
+
+    // Check that the file is large enough for all the content declared in the header
+    using Instruction = JetCorrectionFormula::PackedInstruction;
+    std::size_t const numTableValues =
+      numBins * (2 * header.numBinVars + 2 * header.numParVars + header.numParameters);
+    std::size_t const tablesOffset = sizeof(header) + header.programSize * sizeof(Instruction);
+    std::size_t const namesOffset = tablesOffset + numTableValues * sizeof(double);
+
+    if (compiledFile->GetSize() != namesOffset + header.nameSize + header.expressionSize)
+        reportCorrupted();
+
+    char const *const data = compiledFile->GetData();
+    binEdges = reinterpret_cast<double const *>(data + tablesOffset);
+    parRanges = binEdges + 2 * header.numBinVars * numBins;
+    parameters = parRanges + 2 * header.numParVars * numBins;
+    name.assign(data + namesOffset, header.nameSize);
+
+
+    // The program of the formula is copied since it is small
+    std::string const expression(data + namesOffset + header.nameSize, header.expressionSize);
+    formula.reset(new JetCorrectionFormula(expression, parVariables.size(),
+      reinterpret_cast<Instruction const *>(data + sizeof(header)), header.programSize));
+
+    if (formula->GetNumParameters() != header.numParameters)
+        reportCorrupted();
+
+    ComputeMaxFactor();
+}
+
+
+void JetCorrectionLevel::Eval(JetCorrectionInput const &input, double const *pt,
+  double *factors, Buffers &buffers) const
+{
+    std::size_t const size = input.size;
+    buffers.rho.assign(size, input.rho);
+
+
+    // Find bins for all jets. Only jets that fall into some bin need to be evaluated with the
+    //formula, and they are packed into contiguous arrays (lanes).
+    double const *binValues[4];
+
+    for (unsigned i = 0; i < binVariables.size(); ++i)
+        binValues[i] = GetValues(binVariables[i], input, pt, buffers);
+
+    buffers.lanes.clear();
+    buffers.bins.clear();
+
+    for (std::size_t jet = 0; jet < size; ++jet)
+    {
+        int const bin = FindBin(binValues, jet);
+
+        if (bin < 0)
+            factors[jet] = 1.;
+        else
+        {
+            buffers.lanes.emplace_back(jet);
+            buffers.bins.emplace_back(bin);
+        }
+    }
+
+    std::size_t const numLanes = buffers.lanes.size();
+
+    if (numLanes == 0)
+        return;
+
+
+    // Gather values of the parametrization variables, clamping them to the ranges given in the
+    //bins, and values of the parameters
+    unsigned const numParVars = parVariables.size();
+    buffers.variables.resize(numParVars * numLanes);
+    buffers.variablePointers.resize(numParVars);
+
+    for (unsigned v = 0; v < numParVars; ++v)
+    {
+        double const *source = GetValues(parVariables[v], input, pt, buffers);
+        double *target = buffers.variables.data() + v * numLanes;
+
+        for (std::size_t l = 0; l < numLanes; ++l)
+        {
+            double const *range = &parRanges[2 * (buffers.bins[l] * numParVars + v)];
+            target[l] = std::min(std::max(source[buffers.lanes[l]], range[0]), range[1]);
+        }
+
+        buffers.variablePointers[v] = target;
+    }
+
+    unsigned const numParameters = formula->GetNumParameters();
+    buffers.parameters.resize(numParameters * numLanes);
+    buffers.parameterPointers.resize(numParameters);
+
+    for (unsigned p = 0; p < numParameters; ++p)
+    {
+        double *target = buffers.parameters.data() + p * numLanes;
+
+        for (std::size_t l = 0; l < numLanes; ++l)
+            target[l] = parameters[buffers.bins[l] * numParameters + p];
+
+        buffers.parameterPointers[p] = target;
+    }
+
+
+    // Evaluate the formula and scatter the results
+    buffers.values.resize(numLanes);
+    formula->Evaluate(numLanes, buffers.variablePointers.data(),
+      buffers.parameterPointers.data(), buffers.values.data(), buffers.stack);
+
+    for (std::size_t l = 0; l < numLanes; ++l)
+        factors[buffers.lanes[l]] = buffers.values[l];
+}
+
+
+std::string JetCorrectionLevel::GetCompiledPath(std::string const &path)
+{
+    return fs::path{path}.replace_extension(".jecbin").string();
+}
+
+
+std::vector<double> JetCorrectionLevel::GetEdges(Variable variable) const
+{
+    std::vector<double> edges;
+    unsigned const numBinVars = binVariables.size(), numParVars = parVariables.size();
+
+    for (unsigned bin = 0; bin < numBins; ++bin)
+    {
+        for (unsigned v = 0; v < numBinVars; ++v)
+        {
+            if (binVariables[v] == variable)
+                edges.insert(edges.end(), binEdges + 2 * (bin * numBinVars + v),
+                  binEdges + 2 * (bin * numBinVars + v) + 2);
+        }
+
+        for (unsigned v = 0; v < numParVars; ++v)
+        {
+            if (parVariables[v] == variable)
+                edges.insert(edges.end(), parRanges + 2 * (bin * numParVars + v),
+                  parRanges + 2 * (bin * numParVars + v) + 2);
+        }
+    }
+
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    return edges;
+}
+
+
+std::shared_ptr<JetCorrectionLevel const> JetCorrectionLevel::Load(std::string const &path)
+{
+    std::string const compiledPath = GetCompiledPath(path);
+    std::error_code error;
+
+    if (fs::exists(compiledPath, error))
+    {
+        auto compiledFile = std::make_shared<MappedFile const>(compiledPath);
+
+        if (IsCompiledFrom(*compiledFile, path))
+            return std::shared_ptr<JetCorrectionLevel const>(
+              new JetCorrectionLevel(path, compiledFile));
+    }
+
+    return std::make_shared<JetCorrectionLevel const>(path);
+}
+
+
+void JetCorrectionLevel::WriteCompiled(std::string const &compiledPath) const
+{
+    auto const program = formula->Pack();
+    std::string const &expression = formula->GetExpression();
+    unsigned const numParameters = formula->GetNumParameters();
+
+    CompiledHeader header{};
+    std::memcpy(header.magic, compiledMagic, sizeof(compiledMagic));
+    header.formatVersion = compiledFormatVersion;
+    header.numBins = numBins;
+    header.numBinVars = binVariables.size();
+    header.numParVars = parVariables.size();
+    header.sortedBins = sortedBins;
+
+    for (unsigned i = 0; i < binVariables.size(); ++i)
+        header.binVariables[i] = std::uint8_t(binVariables[i]);
+
+    for (unsigned i = 0; i < parVariables.size(); ++i)
+        header.parVariables[i] = std::uint8_t(parVariables[i]);
+
+    header.numParameters = numParameters;
+    header.programSize = program.size();
+    header.nameSize = name.size();
+    header.expressionSize = expression.size();
+    GetSourceStamp(path, header);
+
+
+    std::string const tmpPath = compiledPath + ".tmp";
+    std::ofstream file{tmpPath, std::ios::binary | std::ios::trunc};
+
+    auto writeTable = [&file](double const *values, std::size_t size)
+    {
+        file.write(reinterpret_cast<char const *>(values), sizeof(double) * size);
+    };
+
+    file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    file.write(reinterpret_cast<char const *>(program.data()),
+      sizeof(JetCorrectionFormula::PackedInstruction) * program.size());
+    writeTable(binEdges, 2 * binVariables.size() * numBins);
+    writeTable(parRanges, 2 * parVariables.size() * numBins);
+    writeTable(parameters, numParameters * numBins);
+    file.write(name.data(), name.size());
+    file.write(expression.data(), expression.size());
+    file.close();
+
+    if (not file or std::rename(tmpPath.c_str(), compiledPath.c_str()) != 0)
+    {
+        std::remove(tmpPath.c_str());
+        std::ostringstream message;
+        message << "JetCorrectionLevel::WriteCompiled: Failed to write file \"" << compiledPath <<
+          "\".";
+        throw std::runtime_error(message.str());
+    }
+}
+
+
+void JetCorrectionLevel::ComputeMaxFactor()
+{
+    // Jets outside of all bins are not corrected
+    maxFactor = 1.;
+
+
+    // Choose the number of grid points along each parametrization variable such that the total
+    //number of points in a bin does not exceed the given limit
+    unsigned const maxPointsPerBin = 4096;
+    unsigned const numParVars = parVariables.size();
+    unsigned pointsPerVar = 2, numPoints = 1;
+
+    if (numParVars > 0)
+    {
+        while (std::pow(pointsPerVar + 1, numParVars) <= maxPointsPerBin)
+            ++pointsPerVar;
+
+        for (unsigned v = 0; v < numParVars; ++v)
+            numPoints *= pointsPerVar;
+    }
+
+
+    // Evaluate the formula on the grid in each bin
+    unsigned const numParameters = formula->GetNumParameters();
+    std::vector<double> variables(numParVars * numPoints), binParameters(numParameters * numPoints);
+    std::vector<double const *> variablePointers(numParVars), parameterPointers(numParameters);
+    std::vector<double> values(numPoints), stack;
+
+    for (unsigned v = 0; v < numParVars; ++v)
+        variablePointers[v] = variables.data() + v * numPoints;
+
+    for (unsigned p = 0; p < numParameters; ++p)
+        parameterPointers[p] = binParameters.data() + p * numPoints;
+
+    for (unsigned bin = 0; bin < numBins; ++bin)
+    {
+        unsigned stride = 1;
+
+        for (unsigned v = 0; v < numParVars; ++v)
+        {
+            double const *range = &parRanges[2 * (bin * numParVars + v)];
+            double *target = variables.data() + v * numPoints;
+
+            // Corrections vary most at low pt, so a logarithmic grid is used for it
+            bool const logGrid = (parVariables[v] == Variable::JetPt and range[0] > 0. and
+              range[1] > range[0]);
+
+            for (unsigned i = 0; i < numPoints; ++i)
+            {
+                double const t = double(i / stride % pointsPerVar) / (pointsPerVar - 1);
+                double const x = (logGrid) ? range[0] * std::pow(range[1] / range[0], t) :
+                  range[0] + t * (range[1] - range[0]);
+                target[i] = std::min(std::max(x, range[0]), range[1]);
+            }
+
+            stride *= pointsPerVar;
+        }
+
+        for (unsigned p = 0; p < numParameters; ++p)
+            std::fill(binParameters.begin() + p * numPoints,
+              binParameters.begin() + (p + 1) * numPoints, parameters[bin * numParameters + p]);
+
+        formula->Evaluate(numPoints, variablePointers.data(), parameterPointers.data(),
+          values.data(), stack);
+
+
+        // Between grid points the formula can exceed the values at the points. If the second
+        //derivative along a variable does not exceed M in magnitude within a cell of size h, the
+        //excess over the larger of the values at the ends of the cell is at most M h^2 / 8. For
+        //each grid point, M h^2 is estimated with the second difference along each variable,
+        //computed at the nearest point for which both neighbours exist, and twice the excess is
+        //added to the largest value among the point and its neighbours. Contributions of
+        //different variables are summed.
+        for (unsigned i = 0; i < numPoints; ++i)
+        {
+            double localMax = values[i], margin = 0.;
+            unsigned varStride = 1;
+
+            for (unsigned v = 0; v < numParVars; ++v)
+            {
+                unsigned const index = i / varStride % pointsPerVar;
+
+                if (index > 0)
+                    localMax = std::max(localMax, values[i - varStride]);
+
+                if (index + 1 < pointsPerVar)
+                    localMax = std::max(localMax, values[i + varStride]);
+
+                unsigned const center = i - index * varStride +
+                  std::min(std::max(index, 1u), pointsPerVar - 2) * varStride;
+                double const secondDiff = values[center + varStride] - 2 * values[center] +
+                  values[center - varStride];
+                margin += std::abs(secondDiff) / 4.;
+
+                varStride *= pointsPerVar;
+            }
+
+            if (localMax + margin > maxFactor)
+                maxFactor = localMax + margin;
+        }
+    }
+}
+
+
+int JetCorrectionLevel::FindBin(double const *const *binValues, std::size_t jet) const
+{
+    if (sortedBins)
+    {
+        double const x = binValues[0][jet];
+
+        // Find the last bin whose lower edge is not above x
+        unsigned low = 0, high = numBins;
+
+        while (low < high)
+        {
+            unsigned const mid = (low + high) / 2;
+
+            if (binEdges[2 * mid] <= x)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        if (low == 0 or x >= binEdges[2 * (low - 1) + 1])
+            return -1;
+        else
+            return low - 1;
+    }
+
+
+    unsigned const numBinVars = binVariables.size();
+
+    for (unsigned bin = 0; bin < numBins; ++bin)
+    {
+        bool inside = true;
+
+        for (unsigned v = 0; v < numBinVars; ++v)
+        {
+            double const x = binValues[v][jet];
+            double const *edges = &binEdges[2 * (bin * numBinVars + v)];
+
+            if (x < edges[0] or x >= edges[1])
+            {
+                inside = false;
+                break;
+            }
+        }
+
+        if (inside)
+            return bin;
+    }
+
+    return -1;
+}
+
+
+double const *JetCorrectionLevel::GetValues(Variable variable, JetCorrectionInput const &input,
+  double const *pt, Buffers &buffers)
+{
+    switch (variable)
+    {
+        case Variable::JetPt:
+            return pt;
+
+        case Variable::JetEta:
+            return input.eta;
+
+        case Variable::JetA:
+            return input.area;
+
+        case Variable::Rho:
+        default:
+            return buffers.rho.data();
+    }
+}
+
+
+JetCorrectionLevel::Variable JetCorrectionLevel::ParseVariable(std::string const &name,
+  std::string const &path)
+{
+    if (name == "JetPt")
+        return Variable::JetPt;
+    else if (name == "JetEta")
+        return Variable::JetEta;
+    else if (name == "JetA")
+        return Variable::JetA;
+    else if (name == "Rho")
+        return Variable::Rho;
+    else
+    {
+        std::ostringstream message;
+        message << "JetCorrectionLevel::ParseVariable: Variable \"" << name << "\" used in file \""
+          << path << "\" is not supported.";
+        throw std::runtime_error(message.str());
+    }
+}
@@ -1,5 +1,7 @@
 #include <JetIDFilter.hpp>
 
+#include <JetBlock.hpp>
+
 #include <mensura/JetMETReader.hpp>
 
 #include <cmath>
@@ -7,7 +9,7 @@
 
 JetIDFilter::JetIDFilter(std::string const &name, double minPt_):
     AnalysisPlugin(name),
-    jetmetPluginName("JetMET"), jetmetPlugin(nullptr),
+    jetmetPluginName("JetMET"), jetmetPlugin(nullptr), jetBlock(nullptr),
     minPt(minPt_)
 {}
 
@@ -20,6 +22,7 @@ JetIDFilter::JetIDFilter(double minPt):
 void JetIDFilter::BeginRun(Dataset const &)
 {
     jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    jetBlock = &GetJetBlock(jetmetPlugin);
 }
 
 
@@ -29,18 +32,27 @@ Plugin *JetIDFilter::Clone() const
 }
 
 
+void JetIDFilter::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
 bool JetIDFilter::ProcessEvent()
 {
-    for (auto const &jet: jetmetPlugin->GetJets())
+    auto const &pt = jetBlock->Pt();
+    auto const &id = jetBlock->ID();
+    
+    for (unsigned i = 0; i < pt.size(); ++i)
     {
-        if (jet.Pt() < minPt)
+        if (pt[i] < minPt)
         {
             // Jets are ordered in pt
             break;
         }
         
         
-        if (not jet.UserInt("ID"))
+        if (not id[i])
             return false;
     }
     
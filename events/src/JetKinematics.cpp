@@ -0,0 +1,103 @@
+#include <JetKinematics.hpp>
+
+#include <JetBlock.hpp>
+
+#include <mensura/JetMETReader.hpp>
+
+#include <TVector2.h>
+
+#include <algorithm>
+#include <cmath>
+
+
+JetKinematics::JetKinematics(std::string const &name /*= "JetKinematics"*/):
+    AnalysisPlugin(name),
+    jetmetPluginName("JetMET"), jetmetPlugin(nullptr), jetBlock(nullptr),
+    dPhi12(0.), dPhi23(0.), metLeadProjection(0.)
+{}
+
+
+void JetKinematics::BeginRun(Dataset const &)
+{
+    jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    jetBlock = &GetJetBlock(jetmetPlugin);
+}
+
+
+JetKinematics *JetKinematics::Clone() const
+{
+    return new JetKinematics(*this);
+}
+
+
+double JetKinematics::GetRecoilPt(double minPt) const
+{
+    auto const &pt = jetBlock->Pt();
+
+    if (pt.size() < 2)
+        return 0.;
+
+    // Jets are ordered in pt, so those above the threshold form a prefix
+    std::size_t const numRecoilJets = std::partition_point(pt.begin() + 1, pt.end(),
+      [minPt](double p){return p >= minPt;}) - (pt.begin() + 1);
+    return std::hypot(recoilPx[numRecoilJets], recoilPy[numRecoilJets]);
+}
+
+
+void JetKinematics::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
+bool JetKinematics::ProcessEvent()
+{
+    auto const &pt = jetBlock->Pt();
+    auto const &phi = jetBlock->Phi();
+    std::size_t const numJets = pt.size();
+
+    px.resize(numJets);
+    py.resize(numJets);
+    leadProjection.resize(numJets);
+    recoilPx.resize(numJets);
+    recoilPy.resize(numJets);
+
+    dPhi12 = (numJets > 1) ? std::abs(TVector2::Phi_mpi_pi(phi[0] - phi[1])) : 0.;
+    dPhi23 = (numJets > 2) ? std::abs(TVector2::Phi_mpi_pi(phi[1] - phi[2])) : 0.;
+
+    if (numJets == 0)
+    {
+        metLeadProjection = 0.;
+        return true;
+    }
+
+
+    for (std::size_t i = 0; i < numJets; ++i)
+    {
+        px[i] = pt[i] * std::cos(phi[i]);
+        py[i] = pt[i] * std::sin(phi[i]);
+    }
+
+    // Unit vector along the leading jet. Projections onto it replace cos(phi_j - phi_lead).
+    double const phiLead = phi[0];
+    double const cosLead = std::cos(phiLead), sinLead = std::sin(phiLead);
+
+    leadProjection[0] = pt[0];
+
+    for (std::size_t i = 1; i < numJets; ++i)
+        leadProjection[i] = px[i] * cosLead + py[i] * sinLead;
+
+    auto const &p4Miss = jetmetPlugin->GetMET().P4();
+    metLeadProjection = p4Miss.Px() * cosLead + p4Miss.Py() * sinLead;
+
+
+    recoilPx[0] = recoilPy[0] = 0.;
+
+    for (std::size_t i = 1; i < numJets; ++i)
+    {
+        recoilPx[i] = recoilPx[i - 1] + px[i];
+        recoilPy[i] = recoilPy[i - 1] + py[i];
+    }
+
+    return true;
+}
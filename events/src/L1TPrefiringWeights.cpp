@@ -1,72 +1,94 @@
 #include <L1TPrefiringWeights.hpp>
 
+#include <JetBlock.hpp>
+#include <SharedResources.hpp>
+
 #include <mensura/Config.hpp>
 #include <mensura/FileInPath.hpp>
 #include <mensura/Processor.hpp>
 
-#include <TFile.h>
+#include <TAxis.h>
+#include <TH1.h>
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
 
 
-std::array<double, 3> L1TPrefiringWeights::WeightCalc::ComputeWeights(std::vector<Jet> const &jets)
-  const
+L1TPrefiringWeights::WeightCalc::WeightCalc(TH1 const &prefiringMap):
+    etaAxis{*prefiringMap.GetXaxis()}, ptAxis{*prefiringMap.GetYaxis()}, numPeriods{0},
+    minActiveEta{std::numeric_limits<double>::infinity()},
+    maxActiveEta{-std::numeric_limits<double>::infinity()}
 {
-    double const nominal = ComputeWeight(jets, Variation::Nominal);
-    double const up = ComputeWeight(jets, Variation::Up);
-    double const down = ComputeWeight(jets, Variation::Down);
-
-    return {nominal, up, down};
+    AddPeriod(prefiringMap);
 }
 
 
-double L1TPrefiringWeights::WeightCalc::ComputeWeight(
-  std::vector<Jet> const &jets, Variation variation) const
+unsigned L1TPrefiringWeights::WeightCalc::AddPeriod(TH1 const &prefiringMap)
 {
-    // Compute event weight as described in [1]
-    // [1] https://twiki.cern.ch/twiki/bin/viewauth/CMS/L1ECALPrefiringWeightRecipe#Introduction
-    double nonPrefiringProb = 1.;
+    TAxis const *etaAxisROOT = prefiringMap.GetXaxis();
+    unsigned const numEtaBins = etaAxis.GetNumBins() + 2, numPtBins = ptAxis.GetNumBins() + 2;
+    unsigned const newNumPeriods = numPeriods + 1;
 
-    for (auto const &jet: jets)
-        nonPrefiringProb *= (1. - GetPrefiringProbability(jet, variation));
-
-    return nonPrefiringProb;
-}
+    // Factors for the new period are inserted after the factors for the existing periods in each
+    //bin
+    std::vector<Factors> probs(numEtaBins * numPtBins * newNumPeriods);
 
+    for (unsigned bin = 0; bin < numEtaBins * numPtBins; ++bin)
+        std::copy(nonPrefiringProbs.begin() + bin * numPeriods,
+          nonPrefiringProbs.begin() + (bin + 1) * numPeriods, probs.begin() + bin * newNumPeriods);
 
-double L1TPrefiringWeights::WeightCalc::GetPrefiringProbability(
-  Jet const &jet, Variation variation) const
-{
-    int const bin = prefiringMap->FindFixBin(jet.Eta(), jet.Pt());
-    double const prob = prefiringMap->GetBinContent(bin);
-
-    if (variation == Variation::Nominal)
-        return prob;
+    for (unsigned ptBin = 0; ptBin < numPtBins; ++ptBin)
+        for (unsigned etaBin = 0; etaBin < numEtaBins; ++etaBin)
+        {
+            int const bin = prefiringMap.GetBin(etaBin, ptBin);
+            double const prob = prefiringMap.GetBinContent(bin);
+            double up = prob, down = prob;
+
+            // Empty bins are not varied
+            if (prob != 0.)
+            {
+                double const relSystError = 0.2;
+                double const error = std::sqrt(
+                  std::pow(prefiringMap.GetBinError(bin), 2) + std::pow(prob * relSystError, 2));
+                up = std::min(prob + error, 1.);
+                down = std::max(prob - error, 0.);
+
+                // Extend the active range to include this bin. Underflow and overflow bins extend
+                //it to infinity.
+                double const lowEdge = (etaBin == 0) ?
+                  -std::numeric_limits<double>::infinity() : etaAxisROOT->GetBinLowEdge(etaBin);
+                double const upEdge = (etaBin == numEtaBins - 1) ?
+                  std::numeric_limits<double>::infinity() : etaAxisROOT->GetBinUpEdge(etaBin);
+                minActiveEta = std::min(minActiveEta, lowEdge);
+                maxActiveEta = std::max(maxActiveEta, upEdge);
+            }
+
+            probs[newNumPeriods * (etaBin + numEtaBins * ptBin) + numPeriods] =
+              {1. - prob, 1. - up, 1. - down, 1.};
+        }
 
-    // A short-cut for empty bins
-    if (prob == 0.)
-        return 0.;
+    nonPrefiringProbs = std::move(probs);
+    numPeriods = newNumPeriods;
+    return numPeriods - 1;
+}
 
-    double const relSystError = 0.2;
-    double const error = std::sqrt(
-      std::pow(prefiringMap->GetBinError(bin), 2) + std::pow(prob * relSystError, 2));
 
-    if (variation == Variation::Up)
-        return std::min(prob + error, 1.);
-    else
-        return std::max(prob - error, 0.);
+bool L1TPrefiringWeights::WeightCalc::HasSameBinning(TH1 const &prefiringMap) const
+{
+    return BinnedAxis{*prefiringMap.GetXaxis()} == etaAxis and
+      BinnedAxis{*prefiringMap.GetYaxis()} == ptAxis;
 }
 
 
 L1TPrefiringWeights::L1TPrefiringWeights(std::string const &name, std::string const &configPath):
     AnalysisPlugin{name},
-    jetmetPluginName{"JetMET"}, jetmetPlugin{nullptr},
-    calcs{new std::vector<WeightCalc>}, periodLabelMap{new std::map<std::string, unsigned>}
+    jetmetPluginName{"JetMET"}, jetmetPlugin{nullptr}, jetBlock{nullptr}
 {
-    BuildCalcs(configPath);
+    tables = SharedResources::Get<Tables>(configPath,
+      [this, &configPath](){return BuildTables(configPath);});
 }
 
 
@@ -78,6 +100,8 @@ L1TPrefiringWeights::L1TPrefiringWeights(std::string const &configPath):
 void L1TPrefiringWeights::BeginRun(Dataset const &)
 {
     jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    jetBlock = &GetJetBlock(jetmetPlugin);
+    cachedWeights.resize(tables->numPeriods);
 }
 
 
@@ -89,9 +113,9 @@ L1TPrefiringWeights *L1TPrefiringWeights::Clone() const
 
 unsigned L1TPrefiringWeights::FindPeriodIndex(std::string const &periodLabel) const
 {
-    auto const res = periodLabelMap->find(periodLabel);
+    auto const res = tables->periodLabelMap.find(periodLabel);
 
-    if (res == periodLabelMap->end())
+    if (res == tables->periodLabelMap.end())
     {
         std::ostringstream message;
         message << "L1TPrefiringWeights[\"" << GetName() << "\"]::FindPeriodIndex: "
@@ -103,10 +127,23 @@ unsigned L1TPrefiringWeights::FindPeriodIndex(std::string const &periodLabel) co
 }
 
 
-void L1TPrefiringWeights::BuildCalcs(std::string const &configPath)
+void L1TPrefiringWeights::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
+std::shared_ptr<L1TPrefiringWeights::Tables const> L1TPrefiringWeights::BuildTables(
+  std::string const &configPath) const
 {
-    Config config{configPath};
-    auto const &periodConfigs = config.Get({"periods"});
+    auto const config = SharedResources::GetConfig(configPath);
+    auto const &periodConfigs = config->Get({"periods"});
+    auto newTables = std::make_shared<Tables>();
+    newTables->minActiveEta = std::numeric_limits<double>::infinity();
+    newTables->maxActiveEta = -std::numeric_limits<double>::infinity();
+
+    // Group and index within the group for each period
+    std::map<std::string, std::pair<unsigned, unsigned>> periodPositions;
     
     for (std::string const periodLabel: periodConfigs.getMemberNames())
     {
@@ -117,7 +154,7 @@ void L1TPrefiringWeights::BuildCalcs(std::string const &configPath)
         if (splitPos == std::string::npos)
         {
             std::ostringstream message;
-            message << "L1TPrefiringWeights[\"" << GetName() << "\"]::BuildCalcs: "
+            message << "L1TPrefiringWeights[\"" << GetName() << "\"]::BuildTables: "
               "Failed to extract the in-file path from location \"" << location << "\".";
             throw std::runtime_error(message.str());
         }
@@ -126,34 +163,71 @@ void L1TPrefiringWeights::BuildCalcs(std::string const &configPath)
         std::string const inFilePath{location.substr(splitPos + 1)};
 
 
-        TFile inputFile{FileInPath::Resolve(path).c_str()};
-        auto *prefiringMap = dynamic_cast<TH1 *>(inputFile.Get(inFilePath.c_str()));
+        auto const prefiringMap =
+          SharedResources::GetHistogram(FileInPath::Resolve(path), inFilePath);
 
         if (not prefiringMap)
         {
             std::ostringstream message;
-            message << "L1TPrefiringWeights[\"" << GetName() << "\"]::BuildCalcs: "
+            message << "L1TPrefiringWeights[\"" << GetName() << "\"]::BuildTables: "
               "Failed to read histogram \"" << inFilePath << "\" from file \"" << path << "\".";
             throw std::runtime_error(message.str());
         }
 
-        prefiringMap->SetDirectory(nullptr);
-        inputFile.Close();
 
-        calcs->emplace_back(prefiringMap);
-        (*periodLabelMap)[periodLabel] = calcs->size() - 1;
+        // Add the period to a group with the same binning or start a new group
+        auto &calcs = newTables->calcs;
+        auto const group = std::find_if(calcs.begin(), calcs.end(),
+          [&prefiringMap](auto const &calc){return calc.HasSameBinning(*prefiringMap);});
+
+        if (group != calcs.end())
+            periodPositions[periodLabel] = {group - calcs.begin(), group->AddPeriod(*prefiringMap)};
+        else
+        {
+            calcs.emplace_back(*prefiringMap);
+            periodPositions[periodLabel] = {calcs.size() - 1, 0};
+        }
+    }
+
+
+    // Periods of each group are given contiguous indices
+    newTables->numPeriods = 0;
+
+    for (auto const &calc: newTables->calcs)
+    {
+        newTables->calcOffsets.emplace_back(newTables->numPeriods);
+        newTables->numPeriods += calc.GetNumPeriods();
+
+        newTables->minActiveEta = std::min(newTables->minActiveEta, calc.GetMinActiveEta());
+        newTables->maxActiveEta = std::max(newTables->maxActiveEta, calc.GetMaxActiveEta());
     }
+
+    for (auto const &[periodLabel, position]: periodPositions)
+        newTables->periodLabelMap[periodLabel] =
+          newTables->calcOffsets[position.first] + position.second;
+
+    return newTables;
 }
 
 
 bool L1TPrefiringWeights::ProcessEvent()
 {
-    auto const &jets = jetmetPlugin->GetJets();
-    cachedWeights.clear();
-    
-    for (auto const &calc: *calcs)
-        cachedWeights.emplace_back(calc.ComputeWeights(jets));
+    // Compute event weights as described in [1]. Weights for all periods are updated jet by jet,
+    //with a single bin lookup for each group of periods that share the binning.
+    // [1] https://twiki.cern.ch/twiki/bin/viewauth/CMS/L1ECALPrefiringWeightRecipe#Introduction
+    std::fill(cachedWeights.begin(), cachedWeights.end(), WeightCalc::Factors{1., 1., 1., 1.});
+    std::size_t const numJets = jetBlock->GetSize();
+    double const *eta = jetBlock->Eta().data(), *pt = jetBlock->Pt().data();
+
+    for (std::size_t i = 0; i < numJets; ++i)
+    {
+        // Most jets are central and cannot prefire in any period
+        if (eta[i] < tables->minActiveEta or eta[i] >= tables->maxActiveEta)
+            continue;
+
+        for (unsigned g = 0; g < tables->calcs.size(); ++g)
+            tables->calcs[g].ApplyJet(eta[i], pt[i], &cachedWeights[tables->calcOffsets[g]]);
+    }
 
     return true;
 }
-
@@ -1,5 +1,9 @@
 #include <LeadJetTriggerFilter.hpp>
 
+#include <JetBlock.hpp>
+#include <SharedResources.hpp>
+#include <SkimCacheReader.hpp>
+
 #include <mensura/Config.hpp>
 #include <mensura/JetMETReader.hpp>
 #include <mensura/Processor.hpp>
@@ -17,12 +21,13 @@
 LeadJetTriggerFilter::LeadJetTriggerFilter(std::string const &name, std::string const &triggerName,
   std::string const &configFileName, bool useMargin):
     AnalysisPlugin(name),
-    jetmetPluginName("JetMET"), jetmetPlugin(nullptr),
+    jetmetPluginName("JetMET"), jetmetPlugin(nullptr), jetBlock(nullptr),
     triggerObjectsPluginName("TriggerObjects"), triggerObjectsPlugin(nullptr),
+    skimCachePlugin(nullptr),
     maxDR2(0.3 * 0.3)
 {
-    Config config(configFileName);
-    auto const &root = config.Get();
+    auto const config = SharedResources::GetConfig(configFileName);
+    auto const &root = config->Get();
     
     
     // Extract information about the requested trigger
@@ -32,7 +37,7 @@ LeadJetTriggerFilter::LeadJetTriggerFilter(std::string const &name, std::string
         std::ostringstream message;
         message << "LeadJetTriggerFilter[\"" << GetName() << "\"]::LeadJetTriggerFilter: " <<
           "Top-level structure in the data file must be a dictionary. This is not true for " <<
-          "file " << config.FilePath() << ".";
+          "file " << config->FilePath() << ".";
         throw std::runtime_error(message.str());
     }
     
@@ -40,7 +45,7 @@ LeadJetTriggerFilter::LeadJetTriggerFilter(std::string const &name, std::string
     {
         std::ostringstream message;
         message << "LeadJetTriggerFilter[\"" << GetName() << "\"]::LeadJetTriggerFilter: " <<
-          "File " << config.FilePath() << " does not contain entry for trigger \"" <<
+          "File " << config->FilePath() << " does not contain entry for trigger \"" <<
           triggerName << "\".";
         throw std::runtime_error(message.str());
     }
@@ -52,7 +57,7 @@ LeadJetTriggerFilter::LeadJetTriggerFilter(std::string const &name, std::string
     {
         std::ostringstream message;
         message << "LeadJetTriggerFilter[\"" << GetName() << "\"]::LeadJetTriggerFilter: " <<
-          "Entry \"" << triggerName << "\" in file " << config.FilePath() <<
+          "Entry \"" << triggerName << "\" in file " << config->FilePath() <<
           " does not contain required field \"filter\" or \"" << ptRangeLabel << "\".";
         throw std::runtime_error(message.str());
     }
@@ -65,7 +70,7 @@ LeadJetTriggerFilter::LeadJetTriggerFilter(std::string const &name, std::string
         std::ostringstream message;
         message << "LeadJetTriggerFilter[\"" << GetName() << "\"]::LeadJetTriggerFilter: " <<
           "Field \"" << ptRangeLabel << "\" in entry \"" << triggerName << "\" in file " <<
-          config.FilePath() << " is not an array of two elements.";
+          config->FilePath() << " is not an array of two elements.";
         throw std::runtime_error(message.str());
     }
     
@@ -84,12 +89,26 @@ void LeadJetTriggerFilter::BeginRun(Dataset const &)
 {
     // Save pointers to required services and plugins
     jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
-    triggerObjectsPlugin =
-      dynamic_cast<PECTriggerObjectReader const *>(GetDependencyPlugin(triggerObjectsPluginName));
+    jetBlock = &GetJetBlock(jetmetPlugin);
+    
+    Plugin const *triggerObjectsSource = GetDependencyPlugin(triggerObjectsPluginName);
+    triggerObjectsPlugin = dynamic_cast<PECTriggerObjectReader const *>(triggerObjectsSource);
+    skimCachePlugin = dynamic_cast<SkimCacheReader const *>(triggerObjectsSource);
     
     
     // Cache trigger filter index
-    triggerFilterIndex = triggerObjectsPlugin->GetFilterIndex(triggerFilter);
+    if (triggerObjectsPlugin)
+        triggerFilterIndex = triggerObjectsPlugin->GetFilterIndex(triggerFilter);
+    else if (skimCachePlugin)
+        triggerFilterIndex = skimCachePlugin->GetFilterIndex(triggerFilter);
+    else
+    {
+        std::ostringstream message;
+        message << "LeadJetTriggerFilter[\"" << GetName() << "\"]::BeginRun: Plugin \"" <<
+          triggerObjectsPluginName << "\" is neither a PECTriggerObjectReader nor a " <<
+          "SkimCacheReader.";
+        throw std::runtime_error(message.str());
+    }
 }
 
 
@@ -99,28 +118,42 @@ Plugin *LeadJetTriggerFilter::Clone() const
 }
 
 
+void LeadJetTriggerFilter::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
+void LeadJetTriggerFilter::SetTriggerObjectsPluginName(std::string const &name)
+{
+    triggerObjectsPluginName = name;
+}
+
+
 bool LeadJetTriggerFilter::ProcessEvent()
 {
-    auto const &jets = jetmetPlugin->GetJets();
-    
-    
     // Filtering on pt of the leading jet
-    if (jets.size() == 0)
+    if (jetBlock->GetSize() == 0)
         return false;
     
-    double const ptLead = jets[0].Pt();
+    double const ptLead = jetBlock->Pt()[0];
     
     if (ptLead < minLeadPt or ptLead >= maxLeadPt)
         return false;
     
     
-    // Matching to trigger objects for the selected filter
+    // Matching to trigger objects for the selected filter. When replaying from a skim cache, the
+    //result of the matching is available directly.
+    if (skimCachePlugin)
+        return skimCachePlugin->IsTriggerMatched(triggerFilterIndex);
+    
     auto const &triggerObjects = triggerObjectsPlugin->GetObjects(triggerFilterIndex);
+    double const etaLead = jetBlock->Eta()[0], phiLead = jetBlock->Phi()[0];
     
     for (auto const &triggerObject: triggerObjects)
     {
-        double const dR2 = std::pow(jets[0].Eta() - triggerObject.Eta(), 2) +
-          std::pow(TVector2::Phi_mpi_pi(jets[0].Phi() - triggerObject.Phi()), 2);
+        double const dR2 = std::pow(etaLead - triggerObject.Eta(), 2) +
+          std::pow(TVector2::Phi_mpi_pi(phiLead - triggerObject.Phi()), 2);
         
         if (dR2 < maxDR2)
         {
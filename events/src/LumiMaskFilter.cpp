@@ -0,0 +1,213 @@
+#include <LumiMaskFilter.hpp>
+
+#include <SharedResources.hpp>
+
+#include <mensura/Config.hpp>
+#include <mensura/EventIDReader.hpp>
+#include <mensura/Processor.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+
+LumiMaskFilter::Mask::Mask(Config const &config)
+{
+    auto const &root = config.Get();
+
+    if (not root.isObject())
+    {
+        std::ostringstream message;
+        message << "LumiMaskFilter::Mask::Mask: File " << config.FilePath() << " does not " <<
+          "contain a JSON object.";
+        throw std::runtime_error(message.str());
+    }
+
+
+    // Member names are strings, so sort runs numerically
+    std::vector<std::pair<unsigned long, std::string>> runLabels;
+
+    for (auto const &label: root.getMemberNames())
+    {
+        std::size_t endPos = 0;
+        unsigned long run = 0;
+
+        try
+        {
+            run = std::stoul(label, &endPos);
+        }
+        catch (std::logic_error const &)
+        {
+            endPos = 0;
+        }
+
+        if (endPos == 0 or endPos != label.size())
+        {
+            std::ostringstream message;
+            message << "LumiMaskFilter::Mask::Mask: Key \"" << label << "\" in file " <<
+              config.FilePath() << " is not a run number.";
+            throw std::runtime_error(message.str());
+        }
+
+        runLabels.emplace_back(run, label);
+    }
+
+    std::sort(runLabels.begin(), runLabels.end());
+
+
+    // Read ranges for each run. Sort them and merge overlapping and adjacent ones.
+    runStarts.emplace_back(0);
+
+    for (auto const &[run, label]: runLabels)
+    {
+        auto const &rangesNode = root[label];
+
+        if (not rangesNode.isArray())
+        {
+            std::ostringstream message;
+            message << "LumiMaskFilter::Mask::Mask: Entry for run " << run << " in file " <<
+              config.FilePath() << " is not an array.";
+            throw std::runtime_error(message.str());
+        }
+
+        std::vector<LumiRange> runRanges;
+
+        for (unsigned i = 0; i < rangesNode.size(); ++i)
+        {
+            auto const &rangeNode = rangesNode[i];
+
+            if (not rangeNode.isArray() or rangeNode.size() != 2 or
+              rangeNode[0].asUInt64() > rangeNode[1].asUInt64())
+            {
+                std::ostringstream message;
+                message << "LumiMaskFilter::Mask::Mask: Illegal range of luminosity blocks " <<
+                  "for run " << run << " in file " << config.FilePath() << ".";
+                throw std::runtime_error(message.str());
+            }
+
+            runRanges.emplace_back(LumiRange{rangeNode[0].asUInt64(), rangeNode[1].asUInt64()});
+        }
+
+        if (runRanges.empty())
+            continue;
+
+        std::sort(runRanges.begin(), runRanges.end(),
+          [](LumiRange const &a, LumiRange const &b){return a.first < b.first;});
+        ranges.emplace_back(runRanges.front());
+
+        for (auto const &range: runRanges)
+        {
+            if (range.first <= ranges.back().last + 1)
+                ranges.back().last = std::max(ranges.back().last, range.last);
+            else
+                ranges.emplace_back(range);
+        }
+
+        runs.emplace_back(run);
+        runStarts.emplace_back(ranges.size());
+    }
+}
+
+
+LumiMaskFilter::LumiMaskFilter(std::string const &name, std::string const &maskPath):
+    AnalysisPlugin{name},
+    eventIDPluginName{"InputData"}, eventIDPlugin{nullptr},
+    curRun{0}, curRangesBegin{0}, curRangesEnd{0},
+    curMinLumi{1}, curMaxLumi{0}, curVerdict{false}
+{
+    mask = SharedResources::Get<Mask>(maskPath, [&maskPath]()
+    {
+        return std::make_shared<Mask>(*SharedResources::GetConfig(maskPath));
+    });
+}
+
+
+LumiMaskFilter::LumiMaskFilter(std::string const &maskPath):
+    LumiMaskFilter{"LumiMaskFilter", maskPath}
+{}
+
+
+void LumiMaskFilter::BeginRun(Dataset const &)
+{
+    eventIDPlugin = dynamic_cast<EventIDReader const *>(GetDependencyPlugin(eventIDPluginName));
+
+    // Force the lookup in the first event
+    curMinLumi = 1;
+    curMaxLumi = 0;
+    curRun = 0;
+    curRangesBegin = curRangesEnd = 0;
+}
+
+
+LumiMaskFilter *LumiMaskFilter::Clone() const
+{
+    return new LumiMaskFilter(*this);
+}
+
+
+void LumiMaskFilter::SetEventIDPluginName(std::string const &name)
+{
+    eventIDPluginName = name;
+}
+
+
+bool LumiMaskFilter::ProcessEvent()
+{
+    auto const &id = eventIDPlugin->GetEventID();
+
+    if (id.Run() != curRun)
+        SelectRun(id.Run());
+
+    unsigned long const lumi = id.LumiBlock();
+
+    if (lumi < curMinLumi or lumi > curMaxLumi)
+        SelectLumi(lumi);
+
+    return curVerdict;
+}
+
+
+void LumiMaskFilter::SelectRun(unsigned long run)
+{
+    auto const &runs = mask->runs;
+    auto const res = std::lower_bound(runs.begin(), runs.end(), run);
+
+    if (res != runs.end() and *res == run)
+    {
+        std::size_t const index = res - runs.begin();
+        curRangesBegin = mask->runStarts[index];
+        curRangesEnd = mask->runStarts[index + 1];
+    }
+    else
+        curRangesBegin = curRangesEnd = 0;
+
+    curRun = run;
+    curMinLumi = 1;
+    curMaxLumi = 0;
+}
+
+
+void LumiMaskFilter::SelectLumi(unsigned long lumi)
+{
+    auto const begin = mask->ranges.begin() + curRangesBegin;
+    auto const end = mask->ranges.begin() + curRangesEnd;
+
+    // The luminosity block can only be contained in the last range that starts not later than it
+    auto const next = std::upper_bound(begin, end, lumi,
+      [](unsigned long l, LumiRange const &range){return l < range.first;});
+
+    if (next != begin and lumi <= (next - 1)->last)
+    {
+        curMinLumi = (next - 1)->first;
+        curMaxLumi = (next - 1)->last;
+        curVerdict = true;
+    }
+    else
+    {
+        curMinLumi = (next == begin) ? 0 : (next - 1)->last + 1;
+        curMaxLumi = (next == end) ? std::numeric_limits<unsigned long>::max() : next->first - 1;
+        curVerdict = false;
+    }
+}
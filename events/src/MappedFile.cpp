@@ -0,0 +1,61 @@
+#include <MappedFile.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+MappedFile::MappedFile(std::string const &path_):
+    path{path_}, data{nullptr}, size{0}
+{
+    int const fd = open(path.c_str(), O_RDONLY);
+    struct stat info;
+
+    if (fd < 0 or fstat(fd, &info) != 0)
+    {
+        int const error = errno;
+
+        if (fd >= 0)
+            close(fd);
+
+        std::ostringstream message;
+        message << "MappedFile::MappedFile: Failed to open file \"" << path << "\": " <<
+          std::strerror(error) << ".";
+        throw std::runtime_error(message.str());
+    }
+
+    size = info.st_size;
+
+    // Mapping of an empty file is not allowed, so leave the data pointer null in this case
+    if (size > 0)
+    {
+        void *const address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        int const error = errno;
+        close(fd);
+
+        if (address == MAP_FAILED)
+        {
+            std::ostringstream message;
+            message << "MappedFile::MappedFile: Failed to map file \"" << path << "\": " <<
+              std::strerror(error) << ".";
+            throw std::runtime_error(message.str());
+        }
+
+        data = static_cast<char const *>(address);
+    }
+    else
+        close(fd);
+}
+
+
+MappedFile::~MappedFile()
+{
+    if (data)
+        munmap(const_cast<char *>(data), size);
+}
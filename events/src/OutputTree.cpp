@@ -0,0 +1,12 @@
+#include <OutputTree.hpp>
+
+#include <mensura/TFileService.hpp>
+
+
+TTree *OutputTree::Create(TFileService const &fileService, std::string const &directory,
+  std::string const &name, std::string const &title)
+{
+    TTree *tree = fileService.Create<TTree>(directory.c_str(), name.c_str(), title.c_str());
+    tree->SetAutoFlush(clusterSize);
+    return tree;
+}
@@ -0,0 +1,70 @@
+#include <PartitionFilter.hpp>
+
+#include <mensura/Dataset.hpp>
+#include <mensura/Processor.hpp>
+
+#include <mensura/PECReader/PECInputData.hpp>
+
+#include <TTree.h>
+
+
+std::string const PartitionFilter::eventIDTreeName{"pecEventID/EventID"};
+
+
+PartitionFilter::PartitionFilter(std::string const &name /*= "PartitionFilter"*/):
+    AnalysisPlugin{name},
+    inputDataPluginName{"InputData"}, inputDataPlugin{nullptr}, eventIDTree{nullptr},
+    curRanges{nullptr}, curRangeIndex{0}
+{}
+
+
+void PartitionFilter::AddFile(std::string const &datasetID, std::string const &path,
+  std::vector<PartitionIndex::Range> const &ranges)
+{
+    fileRanges[{datasetID, path}] = ranges;
+}
+
+
+void PartitionFilter::BeginRun(Dataset const &dataset)
+{
+    auto const res =
+      fileRanges.find({dataset.GetSourceDatasetID(), dataset.GetFiles().front().name});
+    curRanges = (res != fileRanges.end()) ? &res->second : nullptr;
+    curRangeIndex = 0;
+    eventIDTree = nullptr;
+
+    // The tree with event IDs is only needed to find numbers of entries in partially selected
+    //files
+    if (curRanges)
+    {
+        inputDataPlugin =
+          dynamic_cast<PECInputData const *>(GetDependencyPlugin(inputDataPluginName));
+        inputDataPlugin->LoadTree(eventIDTreeName);
+        eventIDTree = inputDataPlugin->ExposeTree(eventIDTreeName);
+    }
+}
+
+
+PartitionFilter *PartitionFilter::Clone() const
+{
+    return new PartitionFilter(*this);
+}
+
+
+bool PartitionFilter::ProcessEvent()
+{
+    if (not curRanges)
+        return true;
+
+    // Take the number of the current entry from the reader instead of counting events, so that
+    //the result does not depend on filters placed before this plugin
+    inputDataPlugin->ReadEventFromTree(eventIDTreeName);
+    auto const entry = eventIDTree->GetReadEntry();
+
+    // Entries are read in increasing order and ranges are ordered, so the current range can only
+    //be advanced
+    while (curRangeIndex < curRanges->size() and (*curRanges)[curRangeIndex].end <= entry)
+        ++curRangeIndex;
+
+    return (curRangeIndex < curRanges->size() and (*curRanges)[curRangeIndex].begin <= entry);
+}
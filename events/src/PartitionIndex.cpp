@@ -0,0 +1,120 @@
+#include <PartitionIndex.hpp>
+
+#include <mensura/Config.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+
+PartitionIndex::PartitionIndex(std::vector<unsigned long> const &boundaries_):
+    boundaries{boundaries_}
+{
+    if (not std::is_sorted(boundaries.begin(), boundaries.end()))
+        throw std::runtime_error("PartitionIndex::PartitionIndex: Partition boundaries are not "
+          "sorted.");
+}
+
+
+void PartitionIndex::AddEntry(unsigned long run)
+{
+    unsigned const partition =
+      std::upper_bound(boundaries.begin(), boundaries.end(), run) - boundaries.begin() + 1;
+
+    if (not ranges.empty() and ranges.back().partition == partition)
+    {
+        auto &range = ranges.back();
+        ++range.end;
+        range.firstRun = std::min(range.firstRun, run);
+        range.lastRun = std::max(range.lastRun, run);
+    }
+    else
+    {
+        std::int64_t const begin = (ranges.empty()) ? 0 : ranges.back().end;
+        ranges.emplace_back(Range{partition, begin, begin + 1, run, run});
+    }
+}
+
+
+std::string PartitionIndex::GetPath(std::string const &inputPath)
+{
+    return inputPath + ".partitions.json";
+}
+
+
+std::vector<PartitionIndex::Range> PartitionIndex::GetRanges(unsigned partition) const
+{
+    std::vector<Range> selectedRanges;
+
+    for (auto const &range: ranges)
+    {
+        if (range.partition == partition)
+            selectedRanges.emplace_back(range);
+    }
+
+    return selectedRanges;
+}
+
+
+PartitionIndex PartitionIndex::Read(std::string const &path)
+{
+    Config config(path);
+    auto const &boundariesNode = config.Get({"boundaries"});
+    auto const &rangesNode = config.Get({"ranges"});
+
+    if (not boundariesNode.isArray() or not rangesNode.isArray())
+    {
+        std::ostringstream message;
+        message << "PartitionIndex::Read: File " << config.FilePath() << " does not contain " <<
+          "arrays \"boundaries\" and \"ranges\".";
+        throw std::runtime_error(message.str());
+    }
+
+    std::vector<unsigned long> boundaries;
+
+    for (unsigned i = 0; i < boundariesNode.size(); ++i)
+        boundaries.emplace_back(boundariesNode[i].asUInt64());
+
+    PartitionIndex index{boundaries};
+
+    for (unsigned i = 0; i < rangesNode.size(); ++i)
+    {
+        auto const &rangeNode = rangesNode[i];
+        index.ranges.emplace_back(Range{rangeNode["partition"].asUInt(),
+          rangeNode["begin"].asInt64(), rangeNode["end"].asInt64(),
+          rangeNode["runs"][0].asUInt64(), rangeNode["runs"][1].asUInt64()});
+    }
+
+    return index;
+}
+
+
+void PartitionIndex::Write(std::string const &path) const
+{
+    std::ofstream out(path);
+
+    if (not out)
+    {
+        std::ostringstream message;
+        message << "PartitionIndex::Write: Failed to create file \"" << path << "\".";
+        throw std::runtime_error(message.str());
+    }
+
+    out << "{\n  \"boundaries\": [";
+
+    for (unsigned i = 0; i < boundaries.size(); ++i)
+        out << ((i > 0) ? ", " : "") << boundaries[i];
+
+    out << "],\n  \"ranges\": [";
+
+    for (unsigned i = 0; i < ranges.size(); ++i)
+    {
+        auto const &range = ranges[i];
+        out << ((i > 0) ? ",\n" : "\n") << "    {\"partition\": " << range.partition <<
+          ", \"begin\": " << range.begin << ", \"end\": " << range.end << ", \"runs\": [" <<
+          range.firstRun << ", " << range.lastRun << "]}";
+    }
+
+    out << "\n  ]\n}\n";
+}
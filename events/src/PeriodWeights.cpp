@@ -1,9 +1,18 @@
 #include <PeriodWeights.hpp>
 
+#include <OutputTree.hpp>
+#include <SharedTree.hpp>
+#include <SharedResources.hpp>
+
 #include <mensura/Processor.hpp>
 #include <mensura/ROOTLock.hpp>
 
+#include <TAxis.h>
+
+#include <algorithm>
 #include <limits>
+#include <sstream>
+#include <stdexcept>
 #include <utility>
 
 
@@ -20,8 +29,8 @@ PeriodWeights::Period::Period() noexcept:
 PeriodWeights::PeriodWeights(std::string const &name, std::string const &configPath,
   std::string const &triggerName_):
     AnalysisPlugin(name),
-    config(configPath),
-    profilesDir(config.Get({"pileup_profiles_location"}).asString()),
+    config(SharedResources::GetConfig(configPath)),
+    profilesDir(config->Get({"pileup_profiles_location"}).asString()),
     triggerName(triggerName_),
     fileServiceName("TFileService"), fileService(nullptr),
     puPluginName("PileUp"), puPlugin(nullptr),
@@ -46,16 +55,19 @@ void PeriodWeights::BeginRun(Dataset const &dataset)
     fs::path profilePath("pileup_" + dataset.GetSourceDatasetID() + ".root");
 
     if (not fs::exists(profilesDir / profilePath))
-        profilePath = config.Get({"default_sim_pileup_profile"}).asString();
-
-    simPileupProfile.reset(ReadProfile(profilePath));
-
+        profilePath = config->Get({"default_sim_pileup_profile"}).asString();
 
     ConstructPeriods();
 
+    for (auto &[periodLabel, period]: periods)
+        period.pileupRatios = GetRatioTable(profilePath, period.dataPileupProfile);
+
 
     // Create output tree
-    tree = fileService->Create<TTree>(directoryName.c_str(), treeName.c_str(), "Event weights");
+    if (sharedTreeName.empty())
+        tree = OutputTree::Create(*fileService, directoryName, treeName, "Event weights");
+    else
+        tree = dynamic_cast<SharedTree const *>(GetDependencyPlugin(sharedTreeName))->GetTree();
     
     ROOTLock::Lock();
 
@@ -79,7 +91,45 @@ void PeriodWeights::BeginRun(Dataset const &dataset)
 
 PeriodWeights *PeriodWeights::Clone() const
 {
-    return new PeriodWeights(GetName(), config.FilePath(), triggerName);
+    // Per-event data cannot be copied. Construct a new instance and copy the configuration, which
+    //is shared via SharedResources.
+    auto *clone = new PeriodWeights(GetName(), config->FilePath(), triggerName);
+    clone->fileServiceName = fileServiceName;
+    clone->puPluginName = puPluginName;
+    clone->prefiringPluginName = prefiringPluginName;
+    clone->treeName = treeName;
+    clone->directoryName = directoryName;
+    clone->sharedTreeName = sharedTreeName;
+    return clone;
+}
+
+
+std::vector<std::string> PeriodWeights::GetPeriodLabels() const
+{
+    std::vector<std::string> labels;
+
+    for (auto const &[periodLabel, period]: periods)
+        labels.emplace_back(periodLabel);
+
+    return labels;
+}
+
+
+Float_t const *PeriodWeights::GetPrefiringWeightSyst(std::string const &periodLabel) const
+{
+    return FindPeriod(periodLabel, "GetPrefiringWeightSyst").prefiringWeightSyst;
+}
+
+
+Float_t const &PeriodWeights::GetWeight(std::string const &periodLabel) const
+{
+    return FindPeriod(periodLabel, "GetWeight").weight;
+}
+
+
+void PeriodWeights::SetFileServiceName(std::string const &name)
+{
+    fileServiceName = name;
 }
 
 
@@ -89,6 +139,12 @@ void PeriodWeights::SetPrefiringWeightPlugin(std::string const &name)
 }
 
 
+void PeriodWeights::SetSharedTreeName(std::string const &name)
+{
+    sharedTreeName = name;
+}
+
+
 void PeriodWeights::SetTreeName(std::string const &name)
 {
     auto const pos = name.rfind('/');
@@ -108,7 +164,7 @@ void PeriodWeights::SetTreeName(std::string const &name)
 
 void PeriodWeights::ConstructPeriods()
 {
-    auto const &periodConfigs = config.Get({"periods"});
+    auto const &periodConfigs = config->Get({"periods"});
 
     for (auto const &periodLabel: periodConfigs.getMemberNames())
     {
@@ -117,8 +173,8 @@ void PeriodWeights::ConstructPeriods()
 
         Period period;
         period.luminosity = Config::Get(periodTriggerConfig, {"lumi"}).asDouble();
-        period.dataPileupProfile.reset(ReadProfile(
-          Config::Get(periodTriggerConfig, {"pileup_profile"}).asString()));
+        period.dataPileupProfile =
+          Config::Get(periodTriggerConfig, {"pileup_profile"}).asString();
 
         if (prefiringPlugin)
             period.index = prefiringPlugin->FindPeriodIndex(periodLabel);
@@ -130,6 +186,23 @@ void PeriodWeights::ConstructPeriods()
 }
 
 
+PeriodWeights::Period const &PeriodWeights::FindPeriod(std::string const &periodLabel,
+  std::string const &caller) const
+{
+    auto const res = periods.find(periodLabel);
+
+    if (res == periods.end())
+    {
+        std::ostringstream message;
+        message << "PeriodWeights[\"" << GetName() << "\"]::" << caller << ": Unknown period \"" <<
+          periodLabel << "\".";
+        throw std::runtime_error(message.str());
+    }
+
+    return res->second;
+}
+
+
 bool PeriodWeights::ProcessEvent()
 {
     double mu = puPlugin->GetExpectedPileUp();
@@ -140,22 +213,9 @@ bool PeriodWeights::ProcessEvent()
         mu = 0.;
 
 
-    double const puProbSim = simPileupProfile->GetBinContent(simPileupProfile->FindFixBin(mu));
-
     for (auto const &[periodLabel, period]: periods)
     {
-        double puWeight;
-
-        if (puProbSim == 0.)
-            puWeight = 0.;
-        else
-        {
-            double const puProbData = period.dataPileupProfile->GetBinContent(
-              period.dataPileupProfile->FindFixBin(mu));
-            puWeight = puProbData / puProbSim;
-        }
-
-        period.weight = period.luminosity * puWeight;
+        period.weight = period.luminosity * period.pileupRatios->Eval(mu);
 
 
         // Save prefiring weights. Systematic variations are stored as relative variations with
@@ -171,11 +231,75 @@ bool PeriodWeights::ProcessEvent()
     }
 
 
-    tree->Fill();
+    if (sharedTreeName.empty())
+        tree->Fill();
+
     return true;
 }
 
 
+std::shared_ptr<PeriodWeights::PileUpRatioTable const> PeriodWeights::GetRatioTable(
+  fs::path const &simProfile, fs::path const &dataProfile)
+{
+    std::string const key{(profilesDir / simProfile).string() + '\n' +
+      (profilesDir / dataProfile).string()};
+    return SharedResources::Get<PileUpRatioTable>(key, [this, &simProfile, &dataProfile]()
+    {
+        return BuildRatioTable(simProfile, dataProfile);
+    });
+}
+
+
+std::shared_ptr<PeriodWeights::PileUpRatioTable const> PeriodWeights::BuildRatioTable(
+  fs::path const &simProfile, fs::path const &dataProfile)
+{
+    std::unique_ptr<TH1> simHist{ReadProfile(simProfile)}, dataHist{ReadProfile(dataProfile)};
+    TAxis const *simAxis = simHist->GetXaxis(), *dataAxis = dataHist->GetXaxis();
+
+    // Bins of the table are given by the union of bin edges of the two profiles. The ratio is
+    //constant within each of them.
+    std::vector<double> edges;
+
+    for (TAxis const *axis: {simAxis, dataAxis})
+        for (int bin = 1; bin <= axis->GetNbins() + 1; ++bin)
+            edges.emplace_back(axis->GetBinLowEdge(bin));
+
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    // If the two binnings coincide, copy the axis directly to profit from uniform binning
+    bool const sameBinning = (int(edges.size()) == simAxis->GetNbins() + 1 and
+      int(edges.size()) == dataAxis->GetNbins() + 1);
+    BinnedAxis axis = (sameBinning) ? BinnedAxis{*simAxis} : BinnedAxis{edges};
+
+
+    // Evaluate the ratio at the centre of each bin, which is safe against rounding at the edges
+    std::vector<double> ratios(edges.size() + 1);
+    double const inf = std::numeric_limits<double>::infinity();
+
+    for (unsigned bin = 0; bin < ratios.size(); ++bin)
+    {
+        double mu;
+
+        if (bin == 0)
+            mu = -inf;
+        else if (bin == ratios.size() - 1)
+            mu = inf;
+        else
+            mu = 0.5 * (edges[bin - 1] + edges[bin]);
+
+        double const puProbSim = simHist->GetBinContent(simHist->FindFixBin(mu));
+
+        if (puProbSim == 0.)
+            ratios[bin] = 0.;
+        else
+            ratios[bin] = dataHist->GetBinContent(dataHist->FindFixBin(mu)) / puProbSim;
+    }
+
+    return std::shared_ptr<PileUpRatioTable const>(new PileUpRatioTable{axis, ratios});
+}
+
+
 TH1 *PeriodWeights::ReadProfile(fs::path path)
 {
     path = profilesDir / path;
@@ -1,5 +1,8 @@
 #include <PileUpVars.hpp>
 
+#include <OutputTree.hpp>
+#include <SharedTree.hpp>
+
 #include <mensura/PileUpReader.hpp>
 #include <mensura/Processor.hpp>
 #include <mensura/ROOTLock.hpp>
@@ -25,8 +28,11 @@ void PileUpVars::BeginRun(Dataset const &dataset)
     
     
     // Create output tree
-    tree = fileService->Create<TTree>(directoryName.c_str(), treeName.c_str(),
-      "Observables describing pileup");
+    if (sharedTreeName.empty())
+        tree = OutputTree::Create(*fileService, directoryName, treeName,
+          "Observables describing pileup");
+    else
+        tree = dynamic_cast<SharedTree const *>(GetDependencyPlugin(sharedTreeName))->GetTree();
     
     
     // Assign branch addresses
@@ -48,6 +54,18 @@ Plugin *PileUpVars::Clone() const
 }
 
 
+void PileUpVars::SetFileServiceName(std::string const &name)
+{
+    fileServiceName = name;
+}
+
+
+void PileUpVars::SetSharedTreeName(std::string const &name)
+{
+    sharedTreeName = name;
+}
+
+
 void PileUpVars::SetTreeName(std::string const &name)
 {
     auto const pos = name.rfind('/');
@@ -74,6 +92,8 @@ bool PileUpVars::ProcessEvent()
         bfLambdaPU = puPlugin->GetExpectedPileUp();
     
     
-    tree->Fill();
+    if (sharedTreeName.empty())
+        tree->Fill();
+    
     return true;
 }
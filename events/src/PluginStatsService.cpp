@@ -0,0 +1,236 @@
+#include <PluginStatsService.hpp>
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace
+{
+/// Writes the given string as a JSON string literal
+void WriteJSONString(std::ostream &out, std::string const &text)
+{
+    out << '"';
+
+    for (char c: text)
+    {
+        if (c == '"' or c == '\\')
+            out << '\\';
+
+        out << c;
+    }
+
+    out << '"';
+}
+}  // anonymous namespace
+
+
+PluginStatsService::PluginStatsService(std::string const &name /*= "PluginStats"*/):
+    Service(name),
+    summary{std::make_shared<Summary>()}, threadIndex{-1}, runningIndex{-1}
+{}
+
+
+PluginStatsService *PluginStatsService::Clone() const
+{
+    auto *clone = new PluginStatsService(*this);
+    clone->threadIndex = -1;
+    clone->runningIndex = -1;
+
+    for (auto &record: clone->records)
+    {
+        record.numEvents = record.numAccepted = 0;
+        record.wallTime = record.cpuTime = 0.;
+        record.rejectedWallTime = record.rejectedCpuTime = 0.;
+    }
+
+    return clone;
+}
+
+
+void PluginStatsService::EndRun()
+{
+    CloseInterval(false);
+
+    if (threadIndex < 0 or records.empty())
+        return;
+
+    std::lock_guard<std::mutex> lock(summary->mutex);
+    auto &threadRecords = summary->threadRecords[threadIndex];
+
+    for (unsigned i = 0; i < records.size(); ++i)
+    {
+        if (i >= threadRecords.size())
+            threadRecords.emplace_back(Record{records[i].name, 0, 0, 0., 0., 0., 0.});
+
+        threadRecords[i].numEvents += records[i].numEvents;
+        threadRecords[i].numAccepted += records[i].numAccepted;
+        threadRecords[i].wallTime += records[i].wallTime;
+        threadRecords[i].cpuTime += records[i].cpuTime;
+        threadRecords[i].rejectedWallTime += records[i].rejectedWallTime;
+        threadRecords[i].rejectedCpuTime += records[i].rejectedCpuTime;
+
+        records[i].numEvents = records[i].numAccepted = 0;
+        records[i].wallTime = records[i].cpuTime = 0.;
+        records[i].rejectedWallTime = records[i].rejectedCpuTime = 0.;
+    }
+}
+
+
+unsigned PluginStatsService::RegisterPlugin(std::string const &pluginName) const
+{
+    if (threadIndex < 0)
+    {
+        std::lock_guard<std::mutex> lock(summary->mutex);
+        threadIndex = summary->numThreads;
+        ++summary->numThreads;
+    }
+
+    for (unsigned i = 0; i < records.size(); ++i)
+    {
+        if (records[i].name == pluginName)
+            return i;
+    }
+
+    records.emplace_back(Record{pluginName, 0, 0, 0., 0., 0., 0.});
+    return records.size() - 1;
+}
+
+
+void PluginStatsService::Start(unsigned index) const
+{
+    // If the previous plugin has rejected the event, its interval has not been closed
+    CloseInterval(false);
+
+    runningIndex = index;
+    ++records[index].numEvents;
+    startTime = Now();
+}
+
+
+void PluginStatsService::Stop(unsigned index) const
+{
+    if (runningIndex == int(index))
+        CloseInterval(true);
+}
+
+
+void PluginStatsService::WriteJSON(std::string const &path) const
+{
+    std::lock_guard<std::mutex> lock(summary->mutex);
+
+    std::ofstream out(path);
+
+    if (not out)
+    {
+        std::ostringstream message;
+        message << "PluginStatsService[\"" << GetName() << "\"]::WriteJSON: Failed to create " <<
+          "file \"" << path << "\".";
+        throw std::runtime_error(message.str());
+    }
+
+
+    // Sum measurements over threads. Plugins are ordered as they have been registered in the
+    //first thread that has seen them.
+    std::vector<Record> totalRecords;
+
+    for (auto const &[thread, threadRecords]: summary->threadRecords)
+    {
+        for (auto const &record: threadRecords)
+        {
+            auto res = std::find_if(totalRecords.begin(), totalRecords.end(),
+              [&record](Record const &r){return r.name == record.name;});
+
+            if (res == totalRecords.end())
+            {
+                totalRecords.emplace_back(record);
+                continue;
+            }
+
+            res->numEvents += record.numEvents;
+            res->numAccepted += record.numAccepted;
+            res->wallTime += record.wallTime;
+            res->cpuTime += record.cpuTime;
+            res->rejectedWallTime += record.rejectedWallTime;
+            res->rejectedCpuTime += record.rejectedCpuTime;
+        }
+    }
+
+
+    // A rejecting plugin cannot be followed by a probe, so the end of its interval is only
+    //known approximately. This is stated in the file since it affects the interpretation.
+    out << "{\n  \"note\": ";
+    WriteJSONString(out, "Wall and CPU time of an event rejected by a plugin extend until the "
+      "next instrumented plugin starts and thus include the overhead of the framework between "
+      "events. This time is also given separately as rejected_wall_time and rejected_cpu_time.");
+    out << ",\n  \"threads\": [";
+    bool first = true;
+
+    for (auto const &[thread, threadRecords]: summary->threadRecords)
+    {
+        out << ((first) ? "\n" : ",\n") << "    {\"thread\": " << thread << ", \"plugins\": ";
+        WriteJSONRecords(out, threadRecords, "    ");
+        out << "}";
+        first = false;
+    }
+
+    out << "\n  ],\n  \"total\": ";
+    WriteJSONRecords(out, totalRecords, "  ");
+    out << "\n}\n";
+}
+
+
+void PluginStatsService::CloseInterval(bool accepted) const
+{
+    if (runningIndex < 0)
+        return;
+
+    TimePoint const now = Now();
+    Record &record = records[runningIndex];
+    double const wallTime = std::chrono::duration<double>(now.wall - startTime.wall).count();
+    double const cpuTime = now.cpu - startTime.cpu;
+    record.wallTime += wallTime;
+    record.cpuTime += cpuTime;
+
+    if (accepted)
+        ++record.numAccepted;
+    else
+    {
+        record.rejectedWallTime += wallTime;
+        record.rejectedCpuTime += cpuTime;
+    }
+
+    runningIndex = -1;
+}
+
+
+PluginStatsService::TimePoint PluginStatsService::Now()
+{
+    timespec cpuTime;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime);
+
+    return {std::chrono::steady_clock::now(), cpuTime.tv_sec + 1e-9 * cpuTime.tv_nsec};
+}
+
+
+void PluginStatsService::WriteJSONRecords(std::ostream &out, std::vector<Record> const &records,
+  std::string const &indent)
+{
+    out << "[";
+
+    for (unsigned i = 0; i < records.size(); ++i)
+    {
+        auto const &record = records[i];
+        out << ((i > 0) ? ",\n" : "\n") << indent << "  {\"name\": ";
+        WriteJSONString(out, record.name);
+        out << ", \"events\": " << record.numEvents << ", \"accepted\": " <<
+          record.numAccepted << ", \"rejected\": " << record.numEvents - record.numAccepted <<
+          ", \"wall_time\": " << record.wallTime << ", \"cpu_time\": " << record.cpuTime <<
+          ", \"rejected_wall_time\": " << record.rejectedWallTime <<
+          ", \"rejected_cpu_time\": " << record.rejectedCpuTime << "}";
+    }
+
+    out << "\n" << indent << "]";
+}
@@ -0,0 +1,39 @@
+#include <SharedResources.hpp>
+
+#include <mensura/Config.hpp>
+
+#include <TFile.h>
+#include <TH1.h>
+
+
+std::recursive_mutex SharedResources::mutex;
+
+std::map<std::string, std::weak_ptr<void const>> SharedResources::objects;
+
+
+std::shared_ptr<Config const> SharedResources::GetConfig(std::string const &path)
+{
+    return Get<Config>(path, [&path](){return std::make_shared<Config const>(path);});
+}
+
+
+std::shared_ptr<TH1 const> SharedResources::GetHistogram(std::string const &path,
+  std::string const &inFilePath)
+{
+    return Get<TH1>(path + ':' + inFilePath, [&path, &inFilePath]() -> std::shared_ptr<TH1 const>
+    {
+        TFile file(path.c_str());
+
+        if (file.IsZombie())
+            return nullptr;
+
+        auto *hist = dynamic_cast<TH1 *>(file.Get(inFilePath.c_str()));
+
+        if (not hist)
+            return nullptr;
+
+        hist->SetDirectory(nullptr);
+        file.Close();
+        return std::shared_ptr<TH1 const>(hist);
+    });
+}
@@ -0,0 +1,47 @@
+#include <SharedTree.hpp>
+
+#include <OutputTree.hpp>
+
+#include <mensura/Processor.hpp>
+#include <mensura/TFileService.hpp>
+
+
+SharedTree::SharedTree(std::string const &name, std::string const &treeName_):
+    AnalysisPlugin{name},
+    fileServiceName{"TFileService"}, fileService{nullptr},
+    treeName{treeName_}, tree{nullptr}
+{
+    auto const pos = treeName.rfind('/');
+
+    if (pos != std::string::npos)
+    {
+        directoryName = treeName.substr(0, pos);
+        treeName = treeName.substr(pos + 1);
+    }
+}
+
+
+void SharedTree::BeginRun(Dataset const &)
+{
+    fileService = dynamic_cast<TFileService const *>(GetMaster().GetService(fileServiceName));
+    tree = OutputTree::Create(*fileService, directoryName, treeName,
+      "Observables and weights from several plugins");
+}
+
+
+SharedTree *SharedTree::Clone() const
+{
+    return new SharedTree(*this);
+}
+
+
+void SharedTree::SetFileServiceName(std::string const &name)
+{
+    fileServiceName = name;
+}
+
+
+bool SharedTree::ProcessEvent()
+{
+    return true;
+}
@@ -0,0 +1,30 @@
+#include <SharedTreeFiller.hpp>
+
+#include <SharedTree.hpp>
+
+#include <TTree.h>
+
+
+SharedTreeFiller::SharedTreeFiller(std::string const &name, std::string const &sharedTreeName_):
+    AnalysisPlugin{name},
+    sharedTreeName{sharedTreeName_}, sharedTree{nullptr}
+{}
+
+
+void SharedTreeFiller::BeginRun(Dataset const &)
+{
+    sharedTree = dynamic_cast<SharedTree const *>(GetDependencyPlugin(sharedTreeName));
+}
+
+
+SharedTreeFiller *SharedTreeFiller::Clone() const
+{
+    return new SharedTreeFiller(*this);
+}
+
+
+bool SharedTreeFiller::ProcessEvent()
+{
+    sharedTree->GetTree()->Fill();
+    return true;
+}
@@ -0,0 +1,164 @@
+#include <SimBalanceHists.hpp>
+
+#include <BalanceCalc.hpp>
+#include <GenWeights.hpp>
+#include <JetBlock.hpp>
+#include <PeriodWeights.hpp>
+
+#include <mensura/JetMETReader.hpp>
+#include <mensura/Processor.hpp>
+#include <mensura/TFileService.hpp>
+
+
+SimBalanceHists::SimBalanceHists(std::string const &name /*= "SimBalanceHists"*/):
+    AnalysisPlugin(name),
+    fileServiceName("TFileService"), fileService(nullptr),
+    jetmetPluginName("JetMET"), jetBlock(nullptr),
+    balanceCalcName("BalanceCalc"), balanceCalc(nullptr),
+    genWeightsName("GenWeights"), genWeights(nullptr),
+    periodWeightsName("PeriodWeights"), periodWeights(nullptr),
+    outDirectoryName(name)
+{
+    // Default binning is the same as in BalanceHists
+    for (int pt = 180; pt < 1000; pt += 5)
+        ptLeadBinning.emplace_back(pt);
+
+    for (int pt = 1000; pt < 3000; pt += 10)
+        ptLeadBinning.emplace_back(pt);
+}
+
+
+void SimBalanceHists::BeginRun(Dataset const &)
+{
+    // Save pointers to required services and plugins
+    fileService = dynamic_cast<TFileService const *>(GetMaster().GetService(fileServiceName));
+    jetBlock = &GetJetBlock(GetDependencyPlugin(jetmetPluginName));
+    balanceCalc = dynamic_cast<BalanceCalc const *>(GetDependencyPlugin(balanceCalcName));
+    genWeights = dynamic_cast<GenWeights const *>(GetDependencyPlugin(genWeightsName));
+    periodWeights = dynamic_cast<PeriodWeights const *>(GetDependencyPlugin(periodWeightsName));
+
+
+    // Create profiles for all periods and variations. Pointers to weights stay valid until the
+    //next call to BeginRun of the weight plugins, which precede this plugin.
+    histSets.clear();
+
+    for (auto const &period: periodWeights->GetPeriodLabels())
+    {
+        BookHists(period, "", nullptr);
+
+        if (genWeights->HasMEWeights())
+        {
+            BookHists(period, "MERenormUp", genWeights->GetMERenormWeights());
+            BookHists(period, "MERenormDown", genWeights->GetMERenormWeights() + 1);
+            BookHists(period, "MEFactUp", genWeights->GetMEFactWeights());
+            BookHists(period, "MEFactDown", genWeights->GetMEFactWeights() + 1);
+        }
+
+        if (periodWeights->HasPrefiringWeights())
+        {
+            Float_t const *prefiringSyst = periodWeights->GetPrefiringWeightSyst(period);
+            BookHists(period, "L1TPrefiringUp", prefiringSyst);
+            BookHists(period, "L1TPrefiringDown", prefiringSyst + 1);
+        }
+    }
+}
+
+
+SimBalanceHists *SimBalanceHists::Clone() const
+{
+    auto *clone = new SimBalanceHists(*this);
+    clone->histSets.clear();
+    return clone;
+}
+
+
+void SimBalanceHists::SetBalanceCalcName(std::string const &name)
+{
+    balanceCalcName = name;
+}
+
+
+void SimBalanceHists::SetBinningPtLead(std::vector<double> const &binning)
+{
+    ptLeadBinning = binning;
+}
+
+
+void SimBalanceHists::SetDirectoryName(std::string const &name)
+{
+    outDirectoryName = name;
+}
+
+
+void SimBalanceHists::SetFileServiceName(std::string const &name)
+{
+    fileServiceName = name;
+}
+
+
+void SimBalanceHists::SetGenWeightsName(std::string const &name)
+{
+    genWeightsName = name;
+}
+
+
+void SimBalanceHists::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
+void SimBalanceHists::SetPeriodWeightsName(std::string const &name)
+{
+    periodWeightsName = name;
+}
+
+
+void SimBalanceHists::BookHists(std::string const &period, std::string const &variationLabel,
+  Float_t const *variation)
+{
+    std::string const suffix{"_" + period + ((variation) ? "_" + variationLabel : "")};
+    int const numBins = ptLeadBinning.size() - 1;
+
+    HistSet histSet;
+    histSet.periodWeight = &periodWeights->GetWeight(period);
+    histSet.variation = variation;
+
+    histSet.profPtLead = fileService->Create<TProfile>(outDirectoryName,
+      ("PtLeadProfile" + suffix).c_str(), ";p_{T}^{lead} [GeV];p_{T}^{lead} [GeV]",
+      numBins, ptLeadBinning.data());
+    histSet.profPtBal = fileService->Create<TProfile>(outDirectoryName,
+      ("PtBalProfile" + suffix).c_str(), ";p_{T}^{lead} [GeV];p_{T} balance",
+      numBins, ptLeadBinning.data());
+    histSet.profMPF = fileService->Create<TProfile>(outDirectoryName,
+      ("MPFProfile" + suffix).c_str(), ";p_{T}^{lead} [GeV];MPF",
+      numBins, ptLeadBinning.data());
+
+    histSet.profPtLead->Sumw2();
+    histSet.profPtBal->Sumw2();
+    histSet.profMPF->Sumw2();
+
+    histSets.emplace_back(histSet);
+}
+
+
+bool SimBalanceHists::ProcessEvent()
+{
+    double const ptLead = jetBlock->Pt()[0];
+    double const ptBal = balanceCalc->GetPtBal(), mpf = balanceCalc->GetMPF();
+    double const weightGen = genWeights->GetWeight();
+
+    for (auto const &histSet: histSets)
+    {
+        double weight = weightGen * *histSet.periodWeight;
+
+        if (histSet.variation)
+            weight *= *histSet.variation;
+
+        histSet.profPtLead->Fill(ptLead, ptLead, weight);
+        histSet.profPtBal->Fill(ptLead, ptBal, weight);
+        histSet.profMPF->Fill(ptLead, mpf, weight);
+    }
+
+    return true;
+}
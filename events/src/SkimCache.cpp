@@ -0,0 +1,70 @@
+#include <SkimCache.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace fs = std::filesystem;
+
+
+std::uint64_t SkimCache::Hash(std::string const &text, std::uint64_t seed /*= hashSeed*/)
+{
+    std::uint64_t hash = seed;
+
+    for (unsigned char c: text)
+    {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+
+std::uint64_t SkimCache::HashFile(std::string const &path, std::uint64_t seed /*= hashSeed*/)
+{
+    std::ifstream file{path, std::ios::binary};
+
+    if (not file)
+    {
+        std::ostringstream message;
+        message << "SkimCache::HashFile: Failed to open file \"" << path << "\".";
+        throw std::runtime_error(message.str());
+    }
+
+    std::ostringstream content;
+    content << file.rdbuf();
+
+    return Hash(content.str(), seed);
+}
+
+
+std::string SkimCache::GetPath(std::string const &directory, std::uint64_t configKey,
+  std::string const &datasetID, std::string const &inputPath)
+{
+    // Include the size and the modification time of the input file so that the cache is
+    //invalidated if the file is replaced. They are not available for remote files, which are
+    //identified by their paths only.
+    fs::path const absInputPath{fs::absolute(inputPath)};
+    std::ostringstream fileKey;
+    fileKey << datasetID << '\n' << absInputPath.string();
+
+    std::error_code error;
+    auto const fileSize = fs::file_size(absInputPath, error);
+
+    if (not error)
+    {
+        auto const modificationTime = fs::last_write_time(absInputPath, error);
+        fileKey << '\n' << fileSize << '\n' <<
+          ((error) ? 0 : modificationTime.time_since_epoch().count());
+    }
+
+    std::ostringstream fileName;
+    fileName << absInputPath.stem().string() << '_' << std::hex << std::setw(16) <<
+      std::setfill('0') << Hash(fileKey.str(), configKey) << ".skim";
+
+    return (fs::path{directory} / fileName.str()).string();
+}
@@ -0,0 +1,57 @@
+#include <SkimCacheJetMETReader.hpp>
+
+#include <SkimCacheReader.hpp>
+
+#include <sstream>
+#include <stdexcept>
+
+
+SkimCacheJetMETReader::SkimCacheJetMETReader(std::string const &name /*= "JetMET"*/):
+    JetMETReader{name},
+    cachePlugin{nullptr}, cachePluginName{"InputData"}
+{}
+
+
+void SkimCacheJetMETReader::BeginRun(Dataset const &)
+{
+    cachePlugin = dynamic_cast<SkimCacheReader const *>(GetDependencyPlugin(cachePluginName));
+}
+
+
+SkimCacheJetMETReader *SkimCacheJetMETReader::Clone() const
+{
+    return new SkimCacheJetMETReader(*this);
+}
+
+
+JetBlock const &SkimCacheJetMETReader::GetJetBlock() const
+{
+    return cachePlugin->GetJetBlock();
+}
+
+
+double SkimCacheJetMETReader::GetJetRadius() const
+{
+    if (not cachePlugin)
+    {
+        std::ostringstream message;
+        message << "SkimCacheJetMETReader[\"" << GetName() << "\"]::GetJetRadius: This method " <<
+          "cannot be executed before a handle to the SkimCacheReader has been obtained.";
+        throw std::runtime_error(message.str());
+    }
+
+    return cachePlugin->GetJetRadius();
+}
+
+
+bool SkimCacheJetMETReader::ProcessEvent()
+{
+    if (fillStandardJets)
+        cachePlugin->GetJetBlock().Export(jets);
+
+    met.SetPtEtaPhiM(cachePlugin->GetMETPt(), 0., cachePlugin->GetMETPhi(), 0.);
+    rawMET.SetPtEtaPhiM(cachePlugin->GetRawMETPt(), 0., cachePlugin->GetRawMETPhi(), 0.);
+
+    // The end of the input is signalled by the SkimCacheReader
+    return true;
+}
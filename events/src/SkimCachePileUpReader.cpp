@@ -0,0 +1,32 @@
+#include <SkimCachePileUpReader.hpp>
+
+#include <SkimCacheReader.hpp>
+
+
+SkimCachePileUpReader::SkimCachePileUpReader(std::string const &name /*= "PileUp"*/):
+    PileUpReader{name},
+    cachePlugin{nullptr}, cachePluginName{"InputData"}
+{}
+
+
+void SkimCachePileUpReader::BeginRun(Dataset const &)
+{
+    cachePlugin = dynamic_cast<SkimCacheReader const *>(GetDependencyPlugin(cachePluginName));
+}
+
+
+SkimCachePileUpReader *SkimCachePileUpReader::Clone() const
+{
+    return new SkimCachePileUpReader(*this);
+}
+
+
+bool SkimCachePileUpReader::ProcessEvent()
+{
+    numVertices = cachePlugin->GetNumVertices();
+    rho = cachePlugin->GetRho();
+    expectedPileUp = 0.;
+
+    // The end of the input is signalled by the SkimCacheReader
+    return true;
+}
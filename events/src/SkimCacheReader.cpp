@@ -0,0 +1,179 @@
+#include <SkimCacheReader.hpp>
+
+#include <SkimCache.hpp>
+
+#include <mensura/Dataset.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+
+SkimCacheReader::SkimCacheReader(std::string const &name, std::string const &directory_,
+  std::uint64_t configKey_):
+    EventIDReader{name},
+    directory{directory_}, configKey{configKey_}, jetRadius{0.},
+    numVertices{0}, rho{0.}, metPt{0.}, metPhi{0.}, rawMETPt{0.}, rawMETPhi{0.}, triggerBits{0}
+{}
+
+
+SkimCacheReader::SkimCacheReader(SkimCacheReader const &src):
+    EventIDReader{src},
+    directory{src.directory}, configKey{src.configKey}, jetRadius{0.},
+    numVertices{0}, rho{0.}, metPt{0.}, metPhi{0.}, rawMETPt{0.}, rawMETPhi{0.}, triggerBits{0}
+{}
+
+
+void SkimCacheReader::BeginRun(Dataset const &dataset)
+{
+    path = SkimCache::GetPath(directory, configKey, dataset.GetSourceDatasetID(),
+      dataset.GetFiles().front().name);
+    file.open(path, std::ios::binary);
+
+    if (not file)
+    {
+        std::ostringstream message;
+        message << "SkimCacheReader[\"" << GetName() << "\"]::BeginRun: Failed to open file \"" <<
+          path << "\".";
+        throw std::runtime_error(message.str());
+    }
+
+
+    // Check the header
+    char magic[sizeof(SkimCache::magic)];
+    file.read(magic, sizeof(magic));
+
+    if (not file or std::memcmp(magic, SkimCache::magic, sizeof(magic)) != 0)
+        ReportCorruptedFile("not a skim cache file");
+
+    std::uint32_t version;
+    std::uint64_t key;
+    Read(version);
+    Read(key);
+
+    if (version != SkimCache::formatVersion or key != configKey)
+        ReportCorruptedFile("written with a different version or configuration");
+
+    Read(jetRadius);
+
+    std::uint32_t numFilters;
+    Read(numFilters);
+    triggerFilters.clear();
+
+    for (unsigned i = 0; i < numFilters; ++i)
+    {
+        std::uint32_t length;
+        Read(length);
+        std::string filter(length, '\0');
+        file.read(&filter[0], length);
+        triggerFilters.emplace_back(filter);
+    }
+
+    if (not file)
+        ReportCorruptedFile("truncated header");
+}
+
+
+SkimCacheReader *SkimCacheReader::Clone() const
+{
+    return new SkimCacheReader(*this);
+}
+
+
+void SkimCacheReader::EndRun()
+{
+    file.close();
+}
+
+
+unsigned SkimCacheReader::GetFilterIndex(std::string const &filter) const
+{
+    auto const res = std::find(triggerFilters.begin(), triggerFilters.end(), filter);
+
+    if (res == triggerFilters.end())
+    {
+        std::ostringstream message;
+        message << "SkimCacheReader[\"" << GetName() << "\"]::GetFilterIndex: Trigger filter \"" <<
+          filter << "\" is not stored in file \"" << path << "\".";
+        throw std::runtime_error(message.str());
+    }
+
+    return res - triggerFilters.begin();
+}
+
+
+bool SkimCacheReader::ProcessEvent()
+{
+    std::uint64_t run, lumiBlock, event;
+    std::uint32_t bunchCrossing;
+    Read(run);
+
+    // The end of the file can only be reached at the boundary between events
+    if (file.eof())
+        return false;
+
+    Read(lumiBlock);
+    Read(event);
+    Read(bunchCrossing);
+    eventID.Set(run, lumiBlock, event, bunchCrossing);
+
+    std::uint32_t numPV;
+    Read(numPV);
+    numVertices = numPV;
+    Read(rho);
+
+    Read(metPt);
+    Read(metPhi);
+    Read(rawMETPt);
+    Read(rawMETPhi);
+
+    Read(triggerBits);
+
+
+    // Read jets
+    std::uint32_t numJets;
+    Read(numJets);
+
+    ReadArray(pt, numJets);
+    ReadArray(eta, numJets);
+    ReadArray(phi, numJets);
+    ReadArray(mass, numJets);
+    ReadArray(area, numJets);
+    ReadArray(rawFactor, numJets);
+    ReadArray(id, numJets);
+
+    if (not file)
+        ReportCorruptedFile("truncated event record");
+
+    jetBlock.Clear();
+
+    for (unsigned i = 0; i < numJets; ++i)
+        jetBlock.Add(pt[i], eta[i], phi[i], mass[i], area[i], rawFactor[i], id[i]);
+
+    return true;
+}
+
+
+template<typename T>
+void SkimCacheReader::Read(T &value)
+{
+    file.read(reinterpret_cast<char *>(&value), sizeof(value));
+}
+
+
+template<typename T>
+void SkimCacheReader::ReadArray(std::vector<T> &values, std::size_t size)
+{
+    values.resize(size);
+    file.read(reinterpret_cast<char *>(values.data()), sizeof(T) * size);
+}
+
+
+void SkimCacheReader::ReportCorruptedFile(std::string const &reason) const
+{
+    std::ostringstream message;
+    message << "SkimCacheReader[\"" << GetName() << "\"]: File \"" << path << "\" cannot be " <<
+      "used: " << reason << ".";
+    throw std::runtime_error(message.str());
+}
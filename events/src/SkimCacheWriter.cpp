@@ -0,0 +1,194 @@
+#include <SkimCacheWriter.hpp>
+
+#include <JetBlock.hpp>
+#include <SkimCache.hpp>
+
+#include <mensura/Dataset.hpp>
+#include <mensura/EventIDReader.hpp>
+#include <mensura/JetMETReader.hpp>
+#include <mensura/PileUpReader.hpp>
+
+#include <mensura/PECReader/PECTriggerObjectReader.hpp>
+
+#include <TVector2.h>
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+
+SkimCacheWriter::SkimCacheWriter(std::string const &name, std::string const &directory_,
+  std::uint64_t configKey_, std::vector<std::string> const &triggerFilters_):
+    AnalysisPlugin{name},
+    directory{directory_}, configKey{configKey_}, triggerFilters{triggerFilters_},
+    eventIDPlugin{nullptr}, eventIDPluginName{"InputData"},
+    puPlugin{nullptr}, puPluginName{"PileUp"},
+    jetmetPlugin{nullptr}, jetmetPluginName{"JetMET"}, jetBlock{nullptr},
+    triggerObjectsPlugin{nullptr}, triggerObjectsPluginName{"TriggerObjects"}
+{
+    if (triggerFilters.size() > SkimCache::maxTriggerFilters)
+    {
+        std::ostringstream message;
+        message << "SkimCacheWriter[\"" << GetName() << "\"]::SkimCacheWriter: At most " <<
+          SkimCache::maxTriggerFilters << " trigger filters are supported while " <<
+          triggerFilters.size() << " given.";
+        throw std::runtime_error(message.str());
+    }
+}
+
+
+SkimCacheWriter::SkimCacheWriter(SkimCacheWriter const &src):
+    AnalysisPlugin{src},
+    directory{src.directory}, configKey{src.configKey}, triggerFilters{src.triggerFilters},
+    eventIDPlugin{nullptr}, eventIDPluginName{src.eventIDPluginName},
+    puPlugin{nullptr}, puPluginName{src.puPluginName},
+    jetmetPlugin{nullptr}, jetmetPluginName{src.jetmetPluginName}, jetBlock{nullptr},
+    triggerObjectsPlugin{nullptr}, triggerObjectsPluginName{src.triggerObjectsPluginName}
+{}
+
+
+void SkimCacheWriter::BeginRun(Dataset const &dataset)
+{
+    // Save pointers to required plugins
+    eventIDPlugin = dynamic_cast<EventIDReader const *>(GetDependencyPlugin(eventIDPluginName));
+    puPlugin = dynamic_cast<PileUpReader const *>(GetDependencyPlugin(puPluginName));
+    jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    jetBlock = &GetJetBlock(jetmetPlugin);
+    triggerObjectsPlugin = dynamic_cast<PECTriggerObjectReader const *>(
+      GetDependencyPlugin(triggerObjectsPluginName));
+
+    triggerFilterIndices.clear();
+
+    for (auto const &filter: triggerFilters)
+        triggerFilterIndices.emplace_back(triggerObjectsPlugin->GetFilterIndex(filter));
+
+
+    // Open a new cache file under a temporary name
+    path = SkimCache::GetPath(directory, configKey, dataset.GetSourceDatasetID(),
+      dataset.GetFiles().front().name);
+    tmpPath = path + ".tmp";
+    file.open(tmpPath, std::ios::binary | std::ios::trunc);
+
+    if (not file)
+    {
+        std::ostringstream message;
+        message << "SkimCacheWriter[\"" << GetName() << "\"]::BeginRun: Failed to create file \""
+          << tmpPath << "\".";
+        throw std::runtime_error(message.str());
+    }
+
+
+    // Write the header
+    file.write(SkimCache::magic, sizeof(SkimCache::magic));
+    Write(SkimCache::formatVersion);
+    Write(configKey);
+    Write(jetmetPlugin->GetJetRadius());
+    Write(std::uint32_t(triggerFilters.size()));
+
+    for (auto const &filter: triggerFilters)
+    {
+        Write(std::uint32_t(filter.size()));
+        file.write(filter.data(), filter.size());
+    }
+}
+
+
+SkimCacheWriter *SkimCacheWriter::Clone() const
+{
+    return new SkimCacheWriter(*this);
+}
+
+
+void SkimCacheWriter::EndRun()
+{
+    file.close();
+
+    if (not file or std::rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        std::ostringstream message;
+        message << "SkimCacheWriter[\"" << GetName() << "\"]::EndRun: Failed to write file \"" <<
+          path << "\".";
+        throw std::runtime_error(message.str());
+    }
+}
+
+
+void SkimCacheWriter::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
+bool SkimCacheWriter::ProcessEvent()
+{
+    auto const &id = eventIDPlugin->GetEventID();
+    Write(std::uint64_t(id.Run()));
+    Write(std::uint64_t(id.LumiBlock()));
+    Write(std::uint64_t(id.Event()));
+    Write(std::uint32_t(id.BunchCrossing()));
+
+    Write(std::uint32_t(puPlugin->GetNumVertices()));
+    Write(double(puPlugin->GetRho()));
+
+    auto const &met = jetmetPlugin->GetMET();
+    auto const &rawMET = jetmetPlugin->GetRawMET();
+    Write(double(met.Pt()));
+    Write(double(met.Phi()));
+    Write(double(rawMET.Pt()));
+    Write(double(rawMET.Phi()));
+
+
+    // Flags for trigger matching of the leading jet
+    std::uint64_t triggerBits = 0;
+
+    if (jetBlock->GetSize() > 0)
+    {
+        double const etaLead = jetBlock->Eta()[0], phiLead = jetBlock->Phi()[0];
+
+        for (unsigned i = 0; i < triggerFilterIndices.size(); ++i)
+        {
+            for (auto const &triggerObject:
+              triggerObjectsPlugin->GetObjects(triggerFilterIndices[i]))
+            {
+                double const dR2 = std::pow(etaLead - triggerObject.Eta(), 2) +
+                  std::pow(TVector2::Phi_mpi_pi(phiLead - triggerObject.Phi()), 2);
+
+                if (dR2 < 0.3 * 0.3)
+                {
+                    triggerBits |= std::uint64_t(1) << i;
+                    break;
+                }
+            }
+        }
+    }
+
+    Write(triggerBits);
+
+
+    // Jets are stored in the columnar layout
+    Write(std::uint32_t(jetBlock->GetSize()));
+    WriteArray(jetBlock->Pt());
+    WriteArray(jetBlock->Eta());
+    WriteArray(jetBlock->Phi());
+    WriteArray(jetBlock->Mass());
+    WriteArray(jetBlock->Area());
+    WriteArray(jetBlock->RawFactor());
+    WriteArray(jetBlock->ID());
+
+    return true;
+}
+
+
+template<typename T>
+void SkimCacheWriter::Write(T const &value)
+{
+    file.write(reinterpret_cast<char const *>(&value), sizeof(value));
+}
+
+
+template<typename T>
+void SkimCacheWriter::WriteArray(std::vector<T> const &values)
+{
+    file.write(reinterpret_cast<char const *>(values.data()), sizeof(T) * values.size());
+}
@@ -0,0 +1,43 @@
+#include <TimingProbe.hpp>
+
+#include <PluginStatsService.hpp>
+
+#include <mensura/Processor.hpp>
+
+
+TimingProbe::TimingProbe(std::string const &name, std::string const &targetName_, Mode mode_):
+    AnalysisPlugin{name},
+    targetName{targetName_}, mode{mode_},
+    statsServiceName{"PluginStats"}, statsService{nullptr}, targetIndex{0}
+{}
+
+
+void TimingProbe::BeginRun(Dataset const &)
+{
+    statsService =
+      dynamic_cast<PluginStatsService const *>(GetMaster().GetService(statsServiceName));
+    targetIndex = statsService->RegisterPlugin(targetName);
+}
+
+
+TimingProbe *TimingProbe::Clone() const
+{
+    return new TimingProbe(*this);
+}
+
+
+void TimingProbe::SetStatsServiceName(std::string const &name)
+{
+    statsServiceName = name;
+}
+
+
+bool TimingProbe::ProcessEvent()
+{
+    if (mode == Mode::Start)
+        statsService->Start(targetIndex);
+    else
+        statsService->Stop(targetIndex);
+
+    return true;
+}
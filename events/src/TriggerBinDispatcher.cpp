@@ -0,0 +1,209 @@
+#include <TriggerBinDispatcher.hpp>
+
+#include <JetBlock.hpp>
+#include <SharedResources.hpp>
+#include <SkimCacheReader.hpp>
+
+#include <mensura/Config.hpp>
+#include <mensura/JetMETReader.hpp>
+
+#include <mensura/PECReader/PECTriggerObjectReader.hpp>
+
+#include <TVector2.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+
+TriggerBinDispatcher::TriggerBinDispatcher(std::string const &name,
+  std::string const &configFileName, bool useMargin /*= true*/):
+    AnalysisPlugin{name},
+    jetmetPluginName{"JetMET"}, jetmetPlugin{nullptr}, jetBlock{nullptr},
+    triggerObjectsPluginName{"TriggerObjects"},
+    triggerObjectsPlugin{nullptr}, skimCachePlugin{nullptr},
+    maxDR2{0.3 * 0.3}
+{
+    auto const config = SharedResources::GetConfig(configFileName);
+    auto const &root = config->Get();
+
+    if (not root.isObject())
+    {
+        std::ostringstream message;
+        message << "TriggerBinDispatcher[\"" << GetName() << "\"]::TriggerBinDispatcher: " <<
+          "Top-level structure in the data file must be a dictionary. This is not true for " <<
+          "file " << config->FilePath() << ".";
+        throw std::runtime_error(message.str());
+    }
+
+    std::string const ptRangeLabel(useMargin ? "ptRangeMargined" : "ptRange");
+
+    for (auto const &triggerName: root.getMemberNames())
+    {
+        auto const &triggerInfo = root[triggerName];
+
+        if (not triggerInfo.isMember("filter") or not triggerInfo.isMember(ptRangeLabel) or
+          not triggerInfo[ptRangeLabel].isArray() or triggerInfo[ptRangeLabel].size() != 2)
+        {
+            std::ostringstream message;
+            message << "TriggerBinDispatcher[\"" << GetName() << "\"]::TriggerBinDispatcher: " <<
+              "Entry \"" << triggerName << "\" in file " << config->FilePath() <<
+              " does not contain field \"filter\" or a valid field \"" << ptRangeLabel << "\".";
+            throw std::runtime_error(message.str());
+        }
+
+        Bin bin;
+        bin.triggerName = triggerName;
+        bin.filter = triggerInfo["filter"].asString();
+        bin.minPt = triggerInfo[ptRangeLabel][0].asDouble();
+        bin.maxPt = triggerInfo[ptRangeLabel][1].asDouble();
+        bin.filterIndex = 0;
+        bin.configIndex = bins.size();
+        bins.emplace_back(bin);
+    }
+
+
+    // Sort the bins and record how far the pt ranges of preceding bins extend. When pt of the
+    //leading jet exceeds this reach, no earlier bin can contain it, which terminates the search.
+    std::sort(bins.begin(), bins.end(),
+      [](Bin const &a, Bin const &b){return a.minPt < b.minPt;});
+    double reachPt = -std::numeric_limits<double>::infinity();
+
+    for (auto &bin: bins)
+    {
+        reachPt = std::max(reachPt, bin.maxPt);
+        bin.reachPt = reachPt;
+        minPts.emplace_back(bin.minPt);
+    }
+
+    accepted.resize(bins.size(), false);
+}
+
+
+void TriggerBinDispatcher::BeginRun(Dataset const &)
+{
+    // Save pointers to required plugins
+    jetmetPlugin = dynamic_cast<JetMETReader const *>(GetDependencyPlugin(jetmetPluginName));
+    jetBlock = &GetJetBlock(jetmetPlugin);
+
+    Plugin const *triggerObjectsSource = GetDependencyPlugin(triggerObjectsPluginName);
+    triggerObjectsPlugin = dynamic_cast<PECTriggerObjectReader const *>(triggerObjectsSource);
+    skimCachePlugin = dynamic_cast<SkimCacheReader const *>(triggerObjectsSource);
+
+    if (not triggerObjectsPlugin and not skimCachePlugin)
+    {
+        std::ostringstream message;
+        message << "TriggerBinDispatcher[\"" << GetName() << "\"]::BeginRun: Plugin \"" <<
+          triggerObjectsPluginName << "\" is neither a PECTriggerObjectReader nor a " <<
+          "SkimCacheReader.";
+        throw std::runtime_error(message.str());
+    }
+
+
+    // Cache indices of trigger filters
+    for (auto &bin: bins)
+    {
+        if (triggerObjectsPlugin)
+            bin.filterIndex = triggerObjectsPlugin->GetFilterIndex(bin.filter);
+        else
+            bin.filterIndex = skimCachePlugin->GetFilterIndex(bin.filter);
+    }
+}
+
+
+TriggerBinDispatcher *TriggerBinDispatcher::Clone() const
+{
+    return new TriggerBinDispatcher(*this);
+}
+
+
+unsigned TriggerBinDispatcher::GetBinIndex(std::string const &triggerName) const
+{
+    for (auto const &bin: bins)
+    {
+        if (bin.triggerName == triggerName)
+            return bin.configIndex;
+    }
+
+    std::ostringstream message;
+    message << "TriggerBinDispatcher[\"" << GetName() << "\"]::GetBinIndex: Trigger \"" <<
+      triggerName << "\" is not found in the configuration.";
+    throw std::runtime_error(message.str());
+}
+
+
+std::vector<std::string> TriggerBinDispatcher::GetTriggerNames() const
+{
+    std::vector<std::string> names(bins.size());
+
+    for (auto const &bin: bins)
+        names[bin.configIndex] = bin.triggerName;
+
+    return names;
+}
+
+
+void TriggerBinDispatcher::SetJetMETPluginName(std::string const &name)
+{
+    jetmetPluginName = name;
+}
+
+
+void TriggerBinDispatcher::SetTriggerObjectsPluginName(std::string const &name)
+{
+    triggerObjectsPluginName = name;
+}
+
+
+bool TriggerBinDispatcher::IsMatched(Bin const &bin, double etaLead, double phiLead) const
+{
+    if (skimCachePlugin)
+        return skimCachePlugin->IsTriggerMatched(bin.filterIndex);
+
+    for (auto const &triggerObject: triggerObjectsPlugin->GetObjects(bin.filterIndex))
+    {
+        double const dR2 = std::pow(etaLead - triggerObject.Eta(), 2) +
+          std::pow(TVector2::Phi_mpi_pi(phiLead - triggerObject.Phi()), 2);
+
+        if (dR2 < maxDR2)
+            return true;
+    }
+
+    return false;
+}
+
+
+bool TriggerBinDispatcher::ProcessEvent()
+{
+    std::fill(accepted.begin(), accepted.end(), false);
+
+    if (jetBlock->GetSize() == 0)
+        return false;
+
+    double const ptLead = jetBlock->Pt()[0];
+    double const etaLead = jetBlock->Eta()[0], phiLead = jetBlock->Phi()[0];
+
+
+    // Candidate bins precede the first bin whose lower boundary is above ptLead. Walk back from
+    //it until the pt ranges of all remaining bins end below ptLead.
+    bool anyAccepted = false;
+    auto const end = std::upper_bound(minPts.begin(), minPts.end(), ptLead) - minPts.begin();
+
+    for (auto i = end - 1; i >= 0 and bins[i].reachPt > ptLead; --i)
+    {
+        Bin const &bin = bins[i];
+
+        if (ptLead >= bin.maxPt)
+            continue;
+
+        if (IsMatched(bin, etaLead, phiLead))
+        {
+            accepted[bin.configIndex] = true;
+            anyAccepted = true;
+        }
+    }
+
+    return anyAccepted;
+}
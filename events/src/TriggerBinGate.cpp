@@ -0,0 +1,30 @@
+#include <TriggerBinGate.hpp>
+
+#include <TriggerBinDispatcher.hpp>
+
+
+TriggerBinGate::TriggerBinGate(std::string const &name, std::string const &dispatcherName_,
+  std::string const &triggerName_):
+    AnalysisPlugin{name},
+    dispatcherName{dispatcherName_}, dispatcher{nullptr},
+    triggerName{triggerName_}, binIndex{0}
+{}
+
+
+void TriggerBinGate::BeginRun(Dataset const &)
+{
+    dispatcher = dynamic_cast<TriggerBinDispatcher const *>(GetDependencyPlugin(dispatcherName));
+    binIndex = dispatcher->GetBinIndex(triggerName);
+}
+
+
+TriggerBinGate *TriggerBinGate::Clone() const
+{
+    return new TriggerBinGate(*this);
+}
+
+
+bool TriggerBinGate::ProcessEvent()
+{
+    return dispatcher->IsAccepted(binIndex);
+}